@@ -0,0 +1,144 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "src/cbor_validator.h"
+#include "third_party/chromium_components_cbor/reader.h"
+#include "third_party/chromium_components_cbor/values.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+DEFINE_int32(iterations, 1000000, "Number of times each input is processed.");
+DEFINE_string(responses_path, "",
+              "Optional file with one hex encoded response per line, for "
+              "example recorded from a real device.");
+
+namespace {
+
+// Builds a response shaped like a packed MakeCredential attestation.
+std::vector<uint8_t> MakeCredentialResponse() {
+  cbor::Value::ArrayValue certificates;
+  certificates.push_back(cbor::Value(cbor::Value::BinaryValue(600, 0x30)));
+  cbor::Value::MapValue attestation_statement;
+  attestation_statement[cbor::Value("alg")] = cbor::Value(-7);
+  attestation_statement[cbor::Value("sig")] =
+      cbor::Value(cbor::Value::BinaryValue(71, 0x30));
+  attestation_statement[cbor::Value("x5c")] =
+      cbor::Value(std::move(certificates));
+  cbor::Value::MapValue response;
+  response[cbor::Value(1)] = cbor::Value("packed");
+  response[cbor::Value(2)] = cbor::Value(cbor::Value::BinaryValue(164, 0x01));
+  response[cbor::Value(3)] = cbor::Value(std::move(attestation_statement));
+  return cbor::Writer::Write(cbor::Value(std::move(response))).value();
+}
+
+// Builds a response shaped like GetInfo, with many small items.
+std::vector<uint8_t> GetInfoResponse() {
+  cbor::Value::ArrayValue versions;
+  versions.push_back(cbor::Value("FIDO_2_0"));
+  versions.push_back(cbor::Value("U2F_V2"));
+  cbor::Value::ArrayValue extensions;
+  extensions.push_back(cbor::Value("hmac-secret"));
+  extensions.push_back(cbor::Value("credProtect"));
+  cbor::Value::MapValue options;
+  options[cbor::Value("rk")] = cbor::Value(true);
+  options[cbor::Value("up")] = cbor::Value(true);
+  options[cbor::Value("plat")] = cbor::Value(false);
+  options[cbor::Value("clientPin")] = cbor::Value(true);
+  cbor::Value::ArrayValue pin_protocols;
+  pin_protocols.push_back(cbor::Value(1));
+  cbor::Value::MapValue response;
+  response[cbor::Value(1)] = cbor::Value(std::move(versions));
+  response[cbor::Value(2)] = cbor::Value(std::move(extensions));
+  response[cbor::Value(3)] = cbor::Value(cbor::Value::BinaryValue(16, 0xAA));
+  response[cbor::Value(4)] = cbor::Value(std::move(options));
+  response[cbor::Value(5)] = cbor::Value(1200);
+  response[cbor::Value(6)] = cbor::Value(std::move(pin_protocols));
+  return cbor::Writer::Write(cbor::Value(std::move(response))).value();
+}
+
+template <typename Function>
+absl::Duration TimePerIteration(int iterations, Function function) {
+  absl::Time start = absl::Now();
+  for (int i = 0; i < iterations; ++i) {
+    function();
+  }
+  return (absl::Now() - start) / iterations;
+}
+
+void Measure(const std::string& name, const std::vector<uint8_t>& input) {
+  // All results are accumulated, so the loops can not be optimized away.
+  int read_count = 0;
+  absl::Duration read_time = TimePerIteration(FLAGS_iterations, [&]() {
+    read_count += cbor::Reader::Read(input).has_value();
+  });
+  int validated_count = 0;
+  absl::Duration validate_time = TimePerIteration(FLAGS_iterations, [&]() {
+    validated_count += !fido2_tests::ValidateCanonicalCbor(input).has_value();
+  });
+  CHECK_EQ(read_count, validated_count)
+      << "reader and validator disagree on " << name;
+  std::cout << name << " (" << input.size() << " bytes): Reader::Read "
+            << absl::ToDoubleNanoseconds(read_time)
+            << " ns, ValidateCanonicalCbor "
+            << absl::ToDoubleNanoseconds(validate_time) << " ns";
+
+  absl::optional<cbor::Value> value = cbor::Reader::Read(input);
+  if (value.has_value()) {
+    size_t written_size = 0;
+    absl::Duration write_time = TimePerIteration(FLAGS_iterations, [&]() {
+      written_size += cbor::Writer::Write(*value)->size();
+    });
+    std::cout << ", Writer::Write " << absl::ToDoubleNanoseconds(write_time)
+              << " ns";
+  }
+  std::cout << std::endl;
+}
+
+}  // namespace
+
+// Measures decoding, validating and encoding typical responses. Validation is
+// what HidDevice does for every response, decoding and encoding is what tests
+// and builders do.
+// Usage example:
+//   ./cbor_benchmark --iterations=100000 --responses_path=responses.txt
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  Measure("MakeCredential", MakeCredentialResponse());
+  Measure("GetInfo", GetInfoResponse());
+
+  if (!FLAGS_responses_path.empty()) {
+    std::ifstream responses_file(FLAGS_responses_path);
+    CHECK(responses_file.is_open())
+        << "Unable to open file: " << FLAGS_responses_path;
+    std::string line;
+    for (int line_number = 1; std::getline(responses_file, line);
+         ++line_number) {
+      std::string bytes = absl::HexStringToBytes(line);
+      Measure(absl::StrCat("Line ", line_number),
+              std::vector<uint8_t>(bytes.begin(), bytes.end()));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,256 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/cbor_validator.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "glog/logging.h"
+#include "third_party/chromium_components_cbor/reader.h"
+
+namespace fido2_tests {
+namespace {
+
+using Kind = CborViolation::Kind;
+
+// Major types from RFC 7049, section 2.1.
+constexpr uint8_t kUnsigned = 0;
+constexpr uint8_t kNegative = 1;
+constexpr uint8_t kByteString = 2;
+constexpr uint8_t kString = 3;
+constexpr uint8_t kArray = 4;
+constexpr uint8_t kMap = 5;
+constexpr uint8_t kTag = 6;
+constexpr uint8_t kSimpleValue = 7;
+
+// The initial byte and argument of a data item.
+struct Header {
+  uint8_t major_type;
+  uint8_t additional_info;
+  uint64_t argument;
+  // Number of bytes of the initial byte and the argument.
+  size_t size;
+};
+
+// Walks the data once, keeping only the offset of the current data item.
+class Validator {
+ public:
+  explicit Validator(absl::Span<const uint8_t> data) : data_(data) {}
+
+  // Checks the data item at the offset, and advances the offset past it.
+  std::optional<CborViolation> CheckItem(size_t* offset, int nesting_level) {
+    const size_t item_offset = *offset;
+    if (nesting_level < 0) {
+      return CborViolation{Kind::kTooMuchNesting, item_offset};
+    }
+    Header header;
+    if (std::optional<CborViolation> violation =
+            ReadHeader(item_offset, &header)) {
+      return violation;
+    }
+    *offset += header.size;
+    constexpr uint64_t kMaxInteger = std::numeric_limits<int64_t>::max();
+    switch (header.major_type) {
+      case kUnsigned:
+      case kNegative:
+        if (header.argument > kMaxInteger) {
+          return CborViolation{Kind::kIntegerOutOfRange, item_offset};
+        }
+        return std::nullopt;
+      case kByteString:
+      case kString:
+        if (data_.size() - *offset < header.argument) {
+          return CborViolation{Kind::kTruncated, item_offset};
+        }
+        *offset += header.argument;
+        return std::nullopt;
+      case kArray:
+        for (uint64_t i = 0; i < header.argument; ++i) {
+          if (std::optional<CborViolation> violation =
+                  CheckItem(offset, nesting_level - 1)) {
+            return violation;
+          }
+        }
+        return std::nullopt;
+      case kMap:
+        return CheckMapEntries(header.argument, offset, nesting_level);
+      case kTag:
+        return CborViolation{Kind::kTag, item_offset};
+      case kSimpleValue:
+        if (header.additional_info > 24) {
+          return CborViolation{Kind::kFloat, item_offset};
+        }
+        // Only false, true, null and undefined are assigned.
+        if (header.argument < 20 || header.argument > 23) {
+          return CborViolation{Kind::kUnassignedSimpleValue, item_offset};
+        }
+        return std::nullopt;
+    }
+    CHECK(false) << "major type out of range - TEST SUITE BUG";
+    return std::nullopt;
+  }
+
+ private:
+  // Decodes the header at the offset, rejecting encodings that are not the
+  // shortest possible.
+  std::optional<CborViolation> ReadHeader(size_t offset, Header* header) {
+    if (offset >= data_.size()) {
+      return CborViolation{Kind::kTruncated, offset};
+    }
+    header->major_type = data_[offset] >> 5;
+    header->additional_info = data_[offset] & 0x1F;
+    header->size = 1;
+    if (header->additional_info < 24) {
+      header->argument = header->additional_info;
+      return std::nullopt;
+    }
+    if (header->additional_info == 31) {
+      return CborViolation{Kind::kIndefiniteLength, offset};
+    }
+    if (header->additional_info > 27) {
+      return CborViolation{Kind::kReservedAdditionalInfo, offset};
+    }
+    const size_t argument_size = 1u << (header->additional_info - 24);
+    if (data_.size() - offset <= argument_size) {
+      return CborViolation{Kind::kTruncated, offset};
+    }
+    header->argument = 0;
+    for (size_t i = 1; i <= argument_size; ++i) {
+      header->argument = (header->argument << 8) | data_[offset + i];
+    }
+    header->size += argument_size;
+    // Floats use the argument as their value, so their size is fixed.
+    if (header->major_type == kSimpleValue && header->additional_info > 24) {
+      return std::nullopt;
+    }
+    if ((argument_size == 1 && header->argument < 24) ||
+        header->argument <= (1ULL << 8 * (argument_size >> 1)) - 1) {
+      return CborViolation{Kind::kNonMinimalEncoding, offset};
+    }
+    return std::nullopt;
+  }
+
+  // Checks the keys and values of a map, whose header ends at the offset.
+  std::optional<CborViolation> CheckMapEntries(uint64_t num_entries,
+                                               size_t* offset,
+                                               int nesting_level) {
+    absl::Span<const uint8_t> previous_key;
+    for (uint64_t i = 0; i < num_entries; ++i) {
+      const size_t key_offset = *offset;
+      if (std::optional<CborViolation> violation =
+              CheckItem(offset, nesting_level - 1)) {
+        return violation;
+      }
+      absl::Span<const uint8_t> key =
+          data_.subspan(key_offset, *offset - key_offset);
+      if ((key[0] >> 5) > kString) {
+        return CborViolation{Kind::kUnsupportedMapKey, key_offset};
+      }
+      if (!previous_key.empty()) {
+        if (previous_key == key) {
+          return CborViolation{Kind::kDuplicateMapKey, key_offset};
+        }
+        if (!IsKeyLess(previous_key, key)) {
+          return CborViolation{Kind::kUnsortedMapKeys, key_offset};
+        }
+      }
+      previous_key = key;
+      if (std::optional<CborViolation> violation =
+              CheckItem(offset, nesting_level - 1)) {
+        return violation;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Compares encoded map keys in canonical order, which sorts by major type,
+  // then by length and then lexically. For the supported key types, comparing
+  // the length of the whole encoding is equivalent to comparing the values.
+  static bool IsKeyLess(absl::Span<const uint8_t> key1,
+                        absl::Span<const uint8_t> key2) {
+    if ((key1[0] >> 5) != (key2[0] >> 5)) {
+      return (key1[0] >> 5) < (key2[0] >> 5);
+    }
+    if (key1.size() != key2.size()) {
+      return key1.size() < key2.size();
+    }
+    return std::lexicographical_compare(key1.begin(), key1.end(),
+                                        key2.begin(), key2.end());
+  }
+
+  absl::Span<const uint8_t> data_;
+};
+
+}  // namespace
+
+std::string CborViolation::KindToString() const {
+  switch (kind) {
+    case Kind::kTruncated:
+      return "truncated data item";
+    case Kind::kReservedAdditionalInfo:
+      return "reserved additional information";
+    case Kind::kIndefiniteLength:
+      return "indefinite length";
+    case Kind::kNonMinimalEncoding:
+      return "non-minimal encoding of an integer or length";
+    case Kind::kIntegerOutOfRange:
+      return "integer outside of the 64 bit signed range";
+    case Kind::kUnsupportedMapKey:
+      return "map key that is neither integer nor string";
+    case Kind::kDuplicateMapKey:
+      return "duplicate map key";
+    case Kind::kUnsortedMapKeys:
+      return "unsorted map keys";
+    case Kind::kTag:
+      return "semantic tag";
+    case Kind::kFloat:
+      return "floating point value";
+    case Kind::kUnassignedSimpleValue:
+      return "unassigned simple value";
+    case Kind::kTooMuchNesting:
+      return "too much nesting";
+    case Kind::kTrailingData:
+      return "trailing data";
+  }
+  CHECK(false) << "unknown violation kind - TEST SUITE BUG";
+  return "";
+}
+
+std::optional<CborViolation> ValidateCanonicalCborItem(
+    absl::Span<const uint8_t> data, size_t* item_size) {
+  Validator validator(data);
+  size_t offset = 0;
+  if (std::optional<CborViolation> violation =
+          validator.CheckItem(&offset, cbor::Reader::kCBORMaxDepth)) {
+    return violation;
+  }
+  *item_size = offset;
+  return std::nullopt;
+}
+
+std::optional<CborViolation> ValidateCanonicalCbor(
+    absl::Span<const uint8_t> data) {
+  size_t item_size;
+  if (std::optional<CborViolation> violation =
+          ValidateCanonicalCborItem(data, &item_size)) {
+    return violation;
+  }
+  if (item_size != data.size()) {
+    return CborViolation{Kind::kTrailingData, item_size};
+  }
+  return std::nullopt;
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,65 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CBOR_VALIDATOR_H_
+#define CBOR_VALIDATOR_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/types/span.h"
+
+namespace fido2_tests {
+
+// Describes why encoded data is not canonical CBOR as required by CTAP2. The
+// offset points to the initial byte of the offending data item.
+struct CborViolation {
+  enum class Kind {
+    kTruncated,
+    kReservedAdditionalInfo,
+    kIndefiniteLength,
+    kNonMinimalEncoding,
+    kIntegerOutOfRange,
+    kUnsupportedMapKey,
+    kDuplicateMapKey,
+    kUnsortedMapKeys,
+    kTag,
+    kFloat,
+    kUnassignedSimpleValue,
+    kTooMuchNesting,
+    kTrailingData,
+  };
+
+  Kind kind;
+  size_t offset;
+
+  // Returns a description of the kind, without the offset.
+  std::string KindToString() const;
+};
+
+// Checks the data item at the start of the data in a single pass without
+// allocations. Accepts the same data items as cbor::Reader. If the item is
+// canonical, returns nullopt and writes its size into the second argument,
+// which is left untouched otherwise. Bytes after the item are ignored.
+std::optional<CborViolation> ValidateCanonicalCborItem(
+    absl::Span<const uint8_t> data, size_t* item_size);
+
+// As above, but requires the data to consist of exactly one data item.
+std::optional<CborViolation> ValidateCanonicalCbor(
+    absl::Span<const uint8_t> data);
+
+}  // namespace fido2_tests
+
+#endif  // CBOR_VALIDATOR_H_
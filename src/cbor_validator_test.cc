@@ -0,0 +1,115 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/cbor_validator.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "third_party/chromium_components_cbor/reader.h"
+#include "third_party/chromium_components_cbor/values.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+namespace fido2_tests {
+namespace {
+
+using Kind = CborViolation::Kind;
+
+TEST(CborValidator, TestCanonical) {
+  cbor::Value::MapValue inner_map;
+  inner_map[cbor::Value("alg")] = cbor::Value(-7);
+  inner_map[cbor::Value("sig")] = cbor::Value(cbor::Value::BinaryValue(70, 1));
+  cbor::Value::MapValue map;
+  map[cbor::Value(1)] = cbor::Value("packed");
+  map[cbor::Value(2)] = cbor::Value(cbor::Value::BinaryValue(300, 2));
+  map[cbor::Value(3)] = cbor::Value(std::move(inner_map));
+  std::vector<uint8_t> encoded =
+      cbor::Writer::Write(cbor::Value(std::move(map))).value();
+  EXPECT_FALSE(ValidateCanonicalCbor(encoded).has_value());
+}
+
+TEST(CborValidator, TestViolations) {
+  struct ViolationTestCase {
+    std::vector<uint8_t> input;
+    Kind kind;
+    size_t offset;
+  };
+  const std::vector<ViolationTestCase> test_cases = {
+      {{0xA1, 0x01, 0x43, 0x00}, Kind::kTruncated, 2},
+      {{0x19, 0x01}, Kind::kTruncated, 0},
+      {{0x82, 0x01, 0x1C}, Kind::kReservedAdditionalInfo, 2},
+      {{0x9F, 0x01, 0xFF}, Kind::kIndefiniteLength, 0},
+      {{0x82, 0x18, 0x17, 0x00}, Kind::kNonMinimalEncoding, 1},
+      {{0x59, 0x00, 0x01, 0x00}, Kind::kNonMinimalEncoding, 0},
+      {{0x3B, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+       Kind::kIntegerOutOfRange,
+       0},
+      {{0xA1, 0x80, 0x00}, Kind::kUnsupportedMapKey, 1},
+      {{0xA2, 0x01, 0x00, 0x01, 0x00}, Kind::kDuplicateMapKey, 3},
+      {{0xA2, 0x20, 0x00, 0x01, 0x00}, Kind::kUnsortedMapKeys, 3},
+      {{0xA2, 0x61, 0x61, 0x00, 0x18, 0x18, 0x00}, Kind::kUnsortedMapKeys, 4},
+      {{0xC1, 0x00}, Kind::kTag, 0},
+      {{0xFA, 0x00, 0x00, 0x00, 0x00}, Kind::kFloat, 0},
+      {{0xF0}, Kind::kUnassignedSimpleValue, 0},
+      {std::vector<uint8_t>(18, 0x81), Kind::kTooMuchNesting, 17},
+      {{0x01, 0x02}, Kind::kTrailingData, 1},
+  };
+  for (const ViolationTestCase& test_case : test_cases) {
+    std::optional<CborViolation> violation =
+        ValidateCanonicalCbor(test_case.input);
+    ASSERT_TRUE(violation.has_value());
+    EXPECT_EQ(violation->kind, test_case.kind) << violation->KindToString();
+    EXPECT_EQ(violation->offset, test_case.offset)
+        << violation->KindToString();
+  }
+}
+
+TEST(CborValidator, TestItemSize) {
+  std::vector<uint8_t> input = {0x82, 0x01, 0x41, 0x00, 0xFF};
+  size_t item_size = 0;
+  EXPECT_FALSE(ValidateCanonicalCborItem(input, &item_size).has_value());
+  EXPECT_EQ(item_size, 4u);
+}
+
+// Mutates a canonical encoding at random, and compares with cbor::Reader.
+TEST(CborValidator, TestAcceptsSameAsReader) {
+  cbor::Value::ArrayValue array;
+  array.push_back(cbor::Value(1000));
+  array.push_back(cbor::Value(-25));
+  array.push_back(cbor::Value(true));
+  cbor::Value::MapValue map;
+  map[cbor::Value(1)] = cbor::Value("fmt");
+  map[cbor::Value(-1)] = cbor::Value(std::move(array));
+  map[cbor::Value("b")] = cbor::Value(cbor::Value::BinaryValue(30, 0x18));
+  const std::vector<uint8_t> encoded =
+      cbor::Writer::Write(cbor::Value(std::move(map))).value();
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<size_t> position(0, encoded.size() - 1);
+  std::uniform_int_distribution<int> byte(0, 255);
+  for (int i = 0; i < 10000; ++i) {
+    std::vector<uint8_t> input = encoded;
+    input[position(rng)] = byte(rng);
+    if (i % 2) {
+      input.resize(position(rng));
+    }
+    bool reader_accepts = cbor::Reader::Read(input).has_value();
+    EXPECT_EQ(!ValidateCanonicalCbor(input).has_value(), reader_accepts)
+        << "mutation " << i;
+  }
+}
+
+}  // namespace
+}  // namespace fido2_tests
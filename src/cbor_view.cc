@@ -0,0 +1,202 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/cbor_view.h"
+
+#include "glog/logging.h"
+#include "src/cbor_validator.h"
+
+namespace fido2_tests {
+namespace {
+
+using Type = cbor::Value::Type;
+
+// The initial byte and argument of a data item.
+struct Header {
+  uint8_t additional_info;
+  uint64_t argument;
+  // Number of bytes of the initial byte and the argument.
+  size_t size;
+};
+
+// Decodes the header at the start of data that passed validation.
+Header ReadHeader(absl::Span<const uint8_t> data) {
+  CHECK(!data.empty()) << "invalid CBOR in view - TEST SUITE BUG";
+  Header header = {.additional_info = static_cast<uint8_t>(data[0] & 0x1F),
+                   .argument = 0,
+                   .size = 1};
+  if (header.additional_info < 24) {
+    header.argument = header.additional_info;
+    return header;
+  }
+  CHECK_LE(header.additional_info, 27)
+      << "invalid CBOR in view - TEST SUITE BUG";
+  const size_t argument_size = 1u << (header.additional_info - 24);
+  CHECK_GT(data.size(), argument_size)
+      << "invalid CBOR in view - TEST SUITE BUG";
+  for (size_t i = 1; i <= argument_size; ++i) {
+    header.argument = (header.argument << 8) | data[i];
+  }
+  header.size += argument_size;
+  return header;
+}
+
+// Returns the size of the data item at the start of data that passed
+// validation. Only reads headers to skip nested items, instead of validating
+// them again, so that lookups cost linear time in the skipped bytes.
+size_t ItemSize(absl::Span<const uint8_t> data) {
+  size_t offset = 0;
+  // Counts the items that still need to be skipped, instead of recursing.
+  uint64_t pending_items = 1;
+  while (pending_items > 0) {
+    pending_items -= 1;
+    const Type type = static_cast<Type>(data[offset] >> 5);
+    const Header header = ReadHeader(data.subspan(offset));
+    offset += header.size;
+    switch (type) {
+      case Type::BYTE_STRING:
+      case Type::STRING:
+        offset += header.argument;
+        break;
+      case Type::ARRAY:
+        pending_items += header.argument;
+        break;
+      case Type::MAP:
+        pending_items += 2 * header.argument;
+        break;
+      case Type::TAG:
+        pending_items += 1;
+        break;
+      default:
+        break;
+    }
+    CHECK_LE(offset, data.size()) << "invalid CBOR in view - TEST SUITE BUG";
+  }
+  return offset;
+}
+
+}  // namespace
+
+std::optional<CborView> CborView::Parse(absl::Span<const uint8_t> data) {
+  size_t item_size;
+  if (ValidateCanonicalCborItem(data, &item_size).has_value()) {
+    return std::nullopt;
+  }
+  return CborView(data.first(item_size));
+}
+
+CborView::CborView(absl::Span<const uint8_t> encoded) : encoded_(encoded) {}
+
+cbor::Value::Type CborView::type() const {
+  return static_cast<Type>(encoded_[0] >> 5);
+}
+
+bool CborView::is_integer() const {
+  return type() == Type::UNSIGNED || type() == Type::NEGATIVE;
+}
+
+bool CborView::is_bytestring() const { return type() == Type::BYTE_STRING; }
+
+bool CborView::is_string() const { return type() == Type::STRING; }
+
+bool CborView::is_array() const { return type() == Type::ARRAY; }
+
+bool CborView::is_map() const { return type() == Type::MAP; }
+
+bool CborView::is_bool() const {
+  const uint8_t additional_info = encoded_[0] & 0x1F;
+  return type() == Type::SIMPLE_VALUE &&
+         (additional_info == static_cast<int>(
+                                 cbor::Value::SimpleValue::FALSE_VALUE) ||
+          additional_info ==
+              static_cast<int>(cbor::Value::SimpleValue::TRUE_VALUE));
+}
+
+int64_t CborView::GetInteger() const {
+  CHECK(is_integer()) << "view is not an integer - TEST SUITE BUG";
+  const int64_t argument = ReadHeader(encoded_).argument;
+  return type() == Type::UNSIGNED ? argument : -1 - argument;
+}
+
+absl::Span<const uint8_t> CborView::GetBytestring() const {
+  CHECK(is_bytestring()) << "view is not a byte string - TEST SUITE BUG";
+  return GetContent();
+}
+
+std::string_view CborView::GetString() const {
+  CHECK(is_string()) << "view is not a string - TEST SUITE BUG";
+  absl::Span<const uint8_t> content = GetContent();
+  return std::string_view(reinterpret_cast<const char*>(content.data()),
+                          content.size());
+}
+
+bool CborView::GetBool() const {
+  CHECK(is_bool()) << "view is not a boolean - TEST SUITE BUG";
+  return (encoded_[0] & 0x1F) ==
+         static_cast<int>(cbor::Value::SimpleValue::TRUE_VALUE);
+}
+
+size_t CborView::size() const {
+  CHECK(is_array() || is_map())
+      << "view is neither array nor map - TEST SUITE BUG";
+  return ReadHeader(encoded_).argument;
+}
+
+CborView CborView::GetArrayElement(size_t index) const {
+  CHECK(is_array()) << "view is not an array - TEST SUITE BUG";
+  CHECK_LT(index, size()) << "array index out of bounds - TEST SUITE BUG";
+  absl::Span<const uint8_t> rest = GetContent();
+  for (size_t i = 0; i < index; ++i) {
+    rest.remove_prefix(ItemSize(rest));
+  }
+  return CborView(rest.first(ItemSize(rest)));
+}
+
+std::optional<CborView> CborView::Find(int64_t key) const {
+  CHECK(is_map()) << "view is not a map - TEST SUITE BUG";
+  absl::Span<const uint8_t> rest = GetContent();
+  for (size_t i = 0; i < size(); ++i) {
+    CborView entry_key(rest.first(ItemSize(rest)));
+    rest.remove_prefix(entry_key.encoded_.size());
+    CborView entry_value(rest.first(ItemSize(rest)));
+    rest.remove_prefix(entry_value.encoded_.size());
+    if (entry_key.is_integer() && entry_key.GetInteger() == key) {
+      return entry_value;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<CborView> CborView::Find(std::string_view key) const {
+  CHECK(is_map()) << "view is not a map - TEST SUITE BUG";
+  absl::Span<const uint8_t> rest = GetContent();
+  for (size_t i = 0; i < size(); ++i) {
+    CborView entry_key(rest.first(ItemSize(rest)));
+    rest.remove_prefix(entry_key.encoded_.size());
+    CborView entry_value(rest.first(ItemSize(rest)));
+    rest.remove_prefix(entry_value.encoded_.size());
+    if (entry_key.is_string() && entry_key.GetString() == key) {
+      return entry_value;
+    }
+  }
+  return std::nullopt;
+}
+
+absl::Span<const uint8_t> CborView::GetEncoded() const { return encoded_; }
+
+absl::Span<const uint8_t> CborView::GetContent() const {
+  return encoded_.subspan(ReadHeader(encoded_).size);
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,80 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CBOR_VIEW_H_
+#define CBOR_VIEW_H_
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "absl/types/span.h"
+#include "third_party/chromium_components_cbor/values.h"
+
+namespace fido2_tests {
+
+// A non-owning view of an encoded CBOR data item. Lookups walk the encoded
+// bytes on demand, so nothing is copied or allocated. Use it for nested
+// structures that are only inspected, like COSE keys inside authData.
+//
+// Parse accepts the same canonical subset of CBOR as cbor::Reader, so
+// accessors can rely on well formed data. The viewed bytes must outlive the
+// view and all views returned from it.
+//
+// Example:
+//   std::optional<CborView> cose_key = CborView::Parse(auth_data_tail);
+//   CHECK(cose_key.has_value() && cose_key->is_map());
+//   std::optional<CborView> alg = cose_key->Find(3);
+class CborView {
+ public:
+  // Returns a view of the data item at the start of the data, or nullopt if it
+  // is not accepted by cbor::Reader. Bytes after the data item are not part of
+  // the view, compare the size of GetEncoded() to detect them.
+  static std::optional<CborView> Parse(absl::Span<const uint8_t> data);
+
+  cbor::Value::Type type() const;
+  bool is_integer() const;
+  bool is_bytestring() const;
+  bool is_string() const;
+  bool is_array() const;
+  bool is_map() const;
+  bool is_bool() const;
+
+  // The getters fail if the view has a different type.
+  int64_t GetInteger() const;
+  absl::Span<const uint8_t> GetBytestring() const;
+  std::string_view GetString() const;
+  bool GetBool() const;
+  // Returns the number of elements of an array or entries of a map.
+  size_t size() const;
+  // Returns the element of an array at the index, which must be in bounds.
+  CborView GetArrayElement(size_t index) const;
+  // Returns the value for the integer or string key in a map, or nullopt if
+  // the map has no such key.
+  std::optional<CborView> Find(int64_t key) const;
+  std::optional<CborView> Find(std::string_view key) const;
+  // Returns all bytes of the data item, including its header.
+  absl::Span<const uint8_t> GetEncoded() const;
+
+ private:
+  explicit CborView(absl::Span<const uint8_t> encoded);
+  // Returns the encoding of the contained items of an array or map.
+  absl::Span<const uint8_t> GetContent() const;
+
+  absl::Span<const uint8_t> encoded_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // CBOR_VIEW_H_
@@ -0,0 +1,160 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/cbor_view.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "third_party/chromium_components_cbor/reader.h"
+#include "third_party/chromium_components_cbor/values.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+namespace fido2_tests {
+namespace {
+
+std::vector<uint8_t> Encode(const cbor::Value& value) {
+  return cbor::Writer::Write(value).value();
+}
+
+TEST(CborView, TestMapLookup) {
+  cbor::Value::MapValue inner_map;
+  inner_map[cbor::Value("id")] = cbor::Value(cbor::Value::BinaryValue(3, 7));
+  inner_map[cbor::Value("up")] = cbor::Value(false);
+  cbor::Value::MapValue map;
+  map[cbor::Value(1)] = cbor::Value("packed");
+  map[cbor::Value(-2)] = cbor::Value(-300);
+  map[cbor::Value(3)] = cbor::Value(std::move(inner_map));
+  std::vector<uint8_t> encoded = Encode(cbor::Value(std::move(map)));
+
+  std::optional<CborView> view = CborView::Parse(encoded);
+  ASSERT_TRUE(view.has_value());
+  ASSERT_TRUE(view->is_map());
+  EXPECT_EQ(view->size(), 3u);
+  EXPECT_EQ(view->GetEncoded().size(), encoded.size());
+  EXPECT_EQ(view->Find(1)->GetString(), "packed");
+  EXPECT_EQ(view->Find(-2)->GetInteger(), -300);
+  EXPECT_FALSE(view->Find(2).has_value());
+  EXPECT_FALSE(view->Find("id").has_value());
+
+  std::optional<CborView> inner_view = view->Find(3);
+  ASSERT_TRUE(inner_view.has_value());
+  EXPECT_EQ(inner_view->Find("id")->GetBytestring(),
+            absl::MakeConstSpan(cbor::Value::BinaryValue(3, 7)));
+  ASSERT_TRUE(inner_view->Find("up")->is_bool());
+  EXPECT_FALSE(inner_view->Find("up")->GetBool());
+  // Views point into the original buffer.
+  EXPECT_GE(inner_view->GetEncoded().data(), encoded.data());
+}
+
+TEST(CborView, TestArray) {
+  cbor::Value::ArrayValue array;
+  array.push_back(cbor::Value(24));
+  array.push_back(cbor::Value(true));
+  array.push_back(cbor::Value(cbor::Value::ArrayValue()));
+  std::vector<uint8_t> encoded = Encode(cbor::Value(std::move(array)));
+
+  std::optional<CborView> view = CborView::Parse(encoded);
+  ASSERT_TRUE(view.has_value());
+  ASSERT_TRUE(view->is_array());
+  ASSERT_EQ(view->size(), 3u);
+  EXPECT_EQ(view->GetArrayElement(0).GetInteger(), 24);
+  EXPECT_TRUE(view->GetArrayElement(1).GetBool());
+  EXPECT_EQ(view->GetArrayElement(2).size(), 0u);
+}
+
+TEST(CborView, TestSkipsNestedItems) {
+  cbor::Value::ArrayValue inner_array;
+  inner_array.push_back(cbor::Value(cbor::Value::BinaryValue(300, 1)));
+  inner_array.push_back(cbor::Value("text"));
+  cbor::Value::MapValue inner_map;
+  inner_map[cbor::Value(1)] = cbor::Value(std::move(inner_array));
+  inner_map[cbor::Value(2)] = cbor::Value(-70000);
+  cbor::Value::MapValue map;
+  map[cbor::Value(1)] = cbor::Value(std::move(inner_map));
+  map[cbor::Value(2)] = cbor::Value(cbor::Value::ArrayValue());
+  map[cbor::Value(3)] = cbor::Value(true);
+  std::vector<uint8_t> encoded = Encode(cbor::Value(std::move(map)));
+
+  std::optional<CborView> view = CborView::Parse(encoded);
+  ASSERT_TRUE(view.has_value());
+  EXPECT_TRUE(view->Find(3)->GetBool());
+  EXPECT_EQ(view->Find(2)->size(), 0u);
+  std::optional<CborView> inner_view = view->Find(1);
+  ASSERT_TRUE(inner_view.has_value());
+  EXPECT_EQ(inner_view->Find(2)->GetInteger(), -70000);
+  EXPECT_EQ(inner_view->Find(1)->GetArrayElement(1).GetString(), "text");
+  EXPECT_EQ(inner_view->Find(1)->GetArrayElement(0).GetBytestring().size(),
+            300u);
+}
+
+TEST(CborView, TestTrailingData) {
+  std::vector<uint8_t> encoded = Encode(cbor::Value(cbor::Value::MapValue()));
+  encoded.push_back(0x01);
+  std::optional<CborView> view = CborView::Parse(encoded);
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(view->GetEncoded().size(), 1u);
+}
+
+TEST(CborView, TestAcceptsSameAsReader) {
+  const std::vector<std::vector<uint8_t>> inputs = {
+      // Integers, including the limits of int64_t.
+      {0x17},
+      {0x18, 0x18},
+      {0x1B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+      {0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+      {0x1B, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+      // Non-minimal encodings.
+      {0x18, 0x17},
+      {0x19, 0x00, 0xFF},
+      // Truncated byte string and unknown additional information.
+      {0x43, 0x01, 0x02},
+      {0x5F},
+      // Map keys out of order, duplicated or with an unsupported type.
+      {0xA2, 0x01, 0x00, 0x02, 0x00},
+      {0xA2, 0x02, 0x00, 0x01, 0x00},
+      {0xA2, 0x01, 0x00, 0x01, 0x00},
+      {0xA2, 0x01, 0x00, 0x20, 0x00},
+      {0xA2, 0x20, 0x00, 0x01, 0x00},
+      {0xA2, 0x61, 0x62, 0x00, 0x18, 0x18, 0x00},
+      {0xA1, 0x80, 0x00},
+      // Simple values, floats and tags.
+      {0xF5},
+      {0xF6},
+      {0xF0},
+      {0xF8, 0x20},
+      {0xF9, 0x00, 0x00},
+      {0xC1, 0x00},
+      // Nesting beyond the reader's limit.
+      std::vector<uint8_t>(17, 0x81),
+      std::vector<uint8_t>(18, 0x81),
+  };
+  for (std::vector<uint8_t> input : inputs) {
+    if (input.back() == 0x81) {
+      input.push_back(0x00);
+    }
+    size_t num_bytes_consumed;
+    bool reader_accepts =
+        cbor::Reader::Read(input, &num_bytes_consumed).has_value();
+    std::optional<CborView> view = CborView::Parse(input);
+    EXPECT_EQ(view.has_value(), reader_accepts) << "first byte " << input[0]
+                                                << ", size " << input.size();
+    if (view.has_value() && reader_accepts) {
+      EXPECT_EQ(view->GetEncoded().size(), num_bytes_consumed);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace fido2_tests
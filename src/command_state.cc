@@ -46,11 +46,17 @@ CommandState::CommandState(DeviceInterface* device,
     std::string aaguid_string(aaguid_bytes.begin(), aaguid_bytes.end());
     device_tracker->SetAaguid(absl::BytesToHexString(aaguid_string));
   }
+  if (auto map_iter =
+          decoded_map.find(CborValue(InfoMember::kFirmwareVersion));
+      map_iter != decoded_map.end() && map_iter->second.is_unsigned()) {
+    device_tracker->SetFirmwareVersion(map_iter->second.GetUnsigned());
+  }
 }
 
 void CommandState::PromptReplugAndInit() {
   std::cout << "Please replug the device, then hit enter." << std::endl;
   std::cin.ignore();
+  replug_count_ += 1;
   CHECK(fido2_tests::Status::kErrNone == device_->Init())
       << "CTAPHID initialization failed";
 
@@ -74,6 +80,7 @@ void CommandState::Reset() {
     }
   }
   device_tracker_->AssertResponse(response, "Reset");
+  device_tracker_->GetSignatureVerifier()->ForgetCredentials();
 
   platform_cose_key_ = cbor::Value::MapValue();
   shared_secret_ = cbor::Value::BinaryValue();
@@ -81,6 +88,21 @@ void CommandState::Reset() {
   auth_token_ = cbor::Value::BinaryValue();
 }
 
+Status CommandState::AttemptReset() {
+  absl::variant<cbor::Value, Status> response =
+      fido2_commands::ResetPositiveTest(device_);
+  if (absl::holds_alternative<Status>(response)) {
+    OK_OR_RETURN(absl::get<Status>(response));
+  }
+  device_tracker_->GetSignatureVerifier()->ForgetCredentials();
+
+  platform_cose_key_ = cbor::Value::MapValue();
+  shared_secret_ = cbor::Value::BinaryValue();
+  pin_utf8_ = cbor::Value::BinaryValue();
+  auth_token_ = cbor::Value::BinaryValue();
+  return Status::kErrNone;
+}
+
 void CommandState::Prepare(bool set_uv) {
   if (set_uv) {
     device_tracker_->AssertResponse(GetAuthToken(), "refresh auth token");
@@ -290,5 +312,18 @@ cbor::Value::BinaryValue CommandState::GetCurrentAuthToken() {
   return auth_token_;
 }
 
-}  // namespace fido2_tests
+bool CommandState::HasPin() const { return !pin_utf8_.empty(); }
+
+cbor::Value::BinaryValue CommandState::GetPin() const { return pin_utf8_; }
+
+const cbor::Value::MapValue& CommandState::GetPlatformCoseKey() const {
+  return platform_cose_key_;
+}
 
+cbor::Value::BinaryValue CommandState::GetSharedSecret() const {
+  return shared_secret_;
+}
+
+int CommandState::GetReplugCount() const { return replug_count_; }
+
+}  // namespace fido2_tests
@@ -38,6 +38,10 @@ class CommandState {
   void PromptReplugAndInit();
   // Calls the Reset command to reset the state of the device.
   void Reset();
+  // Calls the Reset command without prompting for a replug first. Returns the
+  // command's status code, and only changes the state on success. Some
+  // authenticators only allow resets shortly after power up.
+  Status AttemptReset();
   // Takes actions until the state is neutral. Call this function before
   // executing a test. If your test needs user verification to work, use set_uv.
   void Prepare(bool set_uv = false);
@@ -81,6 +85,16 @@ class CommandState {
   // Returns the currently stored auth token. This value represents what should
   // be the internal state of the device right now (or is empty if unknown).
   cbor::Value::BinaryValue GetCurrentAuthToken();
+  // Returns whether a PIN is currently set, as far as this state knows.
+  bool HasPin() const;
+  // Returns the PIN that is currently set, or an empty value if there is none.
+  cbor::Value::BinaryValue GetPin() const;
+  // Returns the platform key of the last key agreement, or an empty map.
+  const cbor::Value::MapValue& GetPlatformCoseKey() const;
+  // Returns the shared secret of the last key agreement, or an empty value.
+  cbor::Value::BinaryValue GetSharedSecret() const;
+  // Returns how often the user was asked to replug, including for resets.
+  int GetReplugCount() const;
 
  private:
   DeviceInterface* device_;
@@ -90,6 +104,7 @@ class CommandState {
   cbor::Value::BinaryValue shared_secret_;
   cbor::Value::BinaryValue pin_utf8_;
   cbor::Value::BinaryValue auth_token_;
+  int replug_count_ = 0;
 };
 
 }  // namespace fido2_tests
@@ -0,0 +1,54 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "src/results_stream.h"
+
+DEFINE_string(stream_path, "",
+              "The path of the streamed results, ending in \".jsonl\".");
+
+// Converts a results stream into the results file format. The tools do this
+// themselves when they finish, so this is only needed after a crash.
+// Usage example:
+//   ./compact_results --stream_path=results/product_serial.jsonl
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_stream_path.empty()) {
+    std::cout << "Please add the --stream_path flag." << std::endl;
+    return 0;
+  }
+
+  std::filesystem::path stream_path = FLAGS_stream_path;
+  if (const char* env_dir = std::getenv("BUILD_WORKSPACE_DIRECTORY");
+      env_dir && stream_path.is_relative()) {
+    stream_path = std::filesystem::path(env_dir) / stream_path;
+  }
+  std::filesystem::path results_path = stream_path;
+  results_path.replace_extension(".json");
+
+  std::ofstream results_file(results_path);
+  CHECK(results_file.is_open()) << "Unable to open file: " << results_path;
+  results_file << std::setw(2)
+               << fido2_tests::ResultsStream::Compact(stream_path)
+               << std::endl;
+  std::cout << "Results written to " << results_path << std::endl;
+  return 0;
+}
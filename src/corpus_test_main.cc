@@ -19,6 +19,7 @@
 #include "glog/logging.h"
 #include "src/command_state.h"
 #include "src/constants.h"
+#include "src/crypto_utility.h"
 #include "src/fuzzing/corpus_controller.h"
 #include "src/hid/hid_device.h"
 #include "src/monitors/blackbox_monitor.h"
@@ -49,6 +50,33 @@ DEFINE_string(monitor, "blackbox", "The monitor type used in fuzzing.");
 
 DEFINE_bool(verbose, false, "Printing debug logs, i.e. transmitted packets.");
 
+DEFINE_bool(stream_results, true,
+            "Write observations and tests to a JSON Lines file as they "
+            "happen, instead of keeping them in memory until the end.");
+
+DEFINE_bool(adaptive_timeouts, true,
+            "Learn how long the device usually takes per command, and report "
+            "responses that take far longer. The fixed timeout of 5 s still "
+            "applies.");
+
+DEFINE_int32(num_runs, 0,
+             "Mutated files to run after the whole corpus, picked with "
+             "preference for corpora, mutations and files that caused new "
+             "responses.");
+
+DEFINE_int32(seed, 0,
+             "Seed for picking and mutating files. Picks also depend on "
+             "device timing.");
+
+DEFINE_bool(fix_credentials, true,
+            "Make a few credentials and let GetAssertion inputs use them, "
+            "so that the device does not reject most inputs early. Needs a "
+            "touch per credential.");
+
+DEFINE_bool(fix_pin_auth, false,
+            "Set a PIN, and recompute the PIN authentication of inputs, so "
+            "that they get past the HMAC check.");
+
 DEFINE_int32(port, 2331, "Port to listen on for GDB remote connection.");
 
 DEFINE_validator(port, &ValidatePort);
@@ -74,9 +102,15 @@ int main(int argc, char** argv) {
   }
 
   fido2_tests::DeviceTracker tracker;
-  std::unique_ptr<fido2_tests::DeviceInterface> device =
-      std::make_unique<fido2_tests::hid::HidDevice>(&tracker, FLAGS_token_path,
-                                                    FLAGS_verbose);
+  auto hid_device = std::make_unique<fido2_tests::hid::HidDevice>(
+      &tracker, FLAGS_token_path, FLAGS_verbose);
+  if (FLAGS_adaptive_timeouts) {
+    hid_device->EnableAdaptiveTimeouts();
+  }
+  std::unique_ptr<fido2_tests::DeviceInterface> device = std::move(hid_device);
+  if (FLAGS_stream_results) {
+    tracker.StreamResultsTo("fuzzing_results/");
+  }
   CHECK(fido2_tests::Status::kErrNone == device->Init())
       << "CTAPHID initialization failed";
   device->Wink();
@@ -97,6 +131,8 @@ int main(int argc, char** argv) {
   }
   CHECK(monitor->Attach()) << "Monitor failed to attach!";
 
+  // Every input is followed by a key agreement, so keep keys ready.
+  fido2_tests::crypto_utility::ScopedEcdhKeyPool ecdh_key_pool;
   fido2_tests::CommandState command_state(device.get(), &tracker);
 
   std::string corpus_dir = FLAGS_corpus_path;
@@ -104,8 +140,14 @@ int main(int argc, char** argv) {
     corpus_dir = absl::StrCat(env_dir, "/", FLAGS_corpus_path);
   }
 
+  const fido2_tests::fuzzing_helpers::FuzzingOptions options = {
+      .corpus_path = corpus_dir,
+      .num_runs = FLAGS_num_runs,
+      .seed = FLAGS_seed,
+      .fix_credentials = FLAGS_fix_credentials,
+      .fix_pin_auth = FLAGS_fix_pin_auth};
   const std::vector<std::unique_ptr<fido2_tests::BaseTest>>& tests =
-      fido2_tests::runners::GetCorpusTests(monitor.get(), corpus_dir);
+      fido2_tests::runners::GetCorpusTests(monitor.get(), options);
   fido2_tests::runners::RunTests(device.get(), &tracker, &command_state, tests);
 
   std::cout << "\nRESULTS" << std::endl;
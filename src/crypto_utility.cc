@@ -14,6 +14,13 @@
 
 #include "src/crypto_utility.h"
 
+#include <deque>
+#include <optional>
+#include <thread>
+
+#include "absl/base/const_init.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 #include "glog/logging.h"
 #include "openssl/aes.h"
 #include "openssl/bn.h"
@@ -22,7 +29,9 @@
 #include "openssl/evp.h"
 #include "openssl/hmac.h"
 #include "openssl/pem.h"
+#include "openssl/rsa.h"
 #include "openssl/sha.h"
+#include "openssl/x509.h"
 #include "src/constants.h"
 
 namespace fido2_tests {
@@ -34,6 +43,26 @@ constexpr size_t kAuthTokenSize = 16;
 constexpr int kCurveName = NID_X9_62_prime256v1;
 constexpr int kEcdhKeyType = 2;
 constexpr int kCurveParameter = 1;
+// Number of key pairs an ECDH key pool keeps ready for handshakes.
+constexpr size_t kEcdhKeyPoolSize = 8;
+
+// The group is immutable after creation, so all threads share one instance.
+const EC_GROUP* GetP256Group() {
+  static const EC_GROUP* group = [] {
+    EC_GROUP* group = EC_GROUP_new_by_curve_name(kCurveName);
+    CHECK(group != nullptr) << "unable to create EC group - TEST SUITE BUG";
+    return group;
+  }();
+  return group;
+}
+
+// Returns a scratch context for bignum arithmetic that belongs to the calling
+// thread, to avoid allocating one per call.
+BN_CTX* GetThreadBnCtx() {
+  thread_local bssl::UniquePtr<BN_CTX> bn_ctx(BN_CTX_new());
+  CHECK(bn_ctx != nullptr) << "unable to create BN_CTX - TEST SUITE BUG";
+  return bn_ctx.get();
+}
 
 // This function passes ownership of the generated key to its caller.
 bssl::UniquePtr<EC_POINT> EcPointFromPublicCoordinates(
@@ -48,8 +77,9 @@ bssl::UniquePtr<EC_POINT> EcPointFromPublicCoordinates(
   CHECK(public_y_bignum != nullptr)
       << "unable to create bignum from y vector - TEST SUITE BUG";
   bssl::UniquePtr<EC_POINT> public_point(EC_POINT_new(ec_group));
-  CHECK(EC_POINT_set_affine_coordinates_GFp(
-      ec_group, public_point.get(), public_x_bignum, public_y_bignum, nullptr))
+  CHECK(EC_POINT_set_affine_coordinates_GFp(ec_group, public_point.get(),
+                                            public_x_bignum, public_y_bignum,
+                                            GetThreadBnCtx()))
       << "could not set the EC point coordinates provided by the public";
   BN_free(public_x_bignum);
   BN_free(public_y_bignum);
@@ -66,7 +96,7 @@ void WritePublicKeyToCoseMap(const EC_GROUP* ec_group,
   BN_init(&platform_public_key_y_bignum);
   CHECK(EC_POINT_get_affine_coordinates_GFp(
       ec_group, ec_public_key, &platform_public_key_x_bignum,
-      &platform_public_key_y_bignum, nullptr))
+      &platform_public_key_y_bignum, GetThreadBnCtx()))
       << "unable to get public key coordinates - TEST SUITE BUG";
   int platform_public_key_x_len = BN_num_bytes(&platform_public_key_x_bignum);
   std::vector<uint8_t> platform_public_key_x(kCoordinateEncodingSize, 0);
@@ -100,6 +130,186 @@ void WritePublicKeyToCoseMap(const EC_GROUP* ec_group,
   (*cose_public_key_out)[cbor::Value(-3)] = cbor::Value(platform_public_key_y);
 }
 
+// A generated platform key, with the public key already in COSE format.
+struct EcdhKeyPair {
+  bssl::UniquePtr<EC_KEY> key;
+  cbor::Value::MapValue cose_public_key;
+};
+
+EcdhKeyPair GenerateEcdhKeyPair() {
+  EcdhKeyPair key_pair;
+  key_pair.key.reset(EC_KEY_new_by_curve_name(kCurveName));
+  CHECK(key_pair.key != nullptr) << "unable to create EC key - TEST SUITE BUG";
+  CHECK(EC_KEY_generate_key(key_pair.key.get()))
+      << "could not generate platform key - TEST SUITE BUG";
+  WritePublicKeyToCoseMap(GetP256Group(),
+                          EC_KEY_get0_public_key(key_pair.key.get()),
+                          &key_pair.cose_public_key);
+  return key_pair;
+}
+
+// Generates platform keys on a background thread, so that handshakes only
+// compute the shared secret. Every key is handed out once. The thread stops
+// when the pool is destroyed.
+class EcdhKeyPool {
+ public:
+  EcdhKeyPool() : filler_(&EcdhKeyPool::Fill, this) {}
+
+  ~EcdhKeyPool() {
+    {
+      absl::MutexLock lock(&mutex_);
+      is_stopping_ = true;
+    }
+    filler_.join();
+  }
+
+  // Returns nothing if handshakes drained the pool faster than it refills.
+  std::optional<EcdhKeyPair> TryTake() {
+    absl::MutexLock lock(&mutex_);
+    if (key_pairs_.empty()) {
+      return std::nullopt;
+    }
+    EcdhKeyPair key_pair = std::move(key_pairs_.front());
+    key_pairs_.pop_front();
+    return key_pair;
+  }
+
+ private:
+  void Fill() {
+    while (true) {
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(this, &EcdhKeyPool::HasSpaceOrIsStopping));
+        if (is_stopping_) {
+          return;
+        }
+      }
+      EcdhKeyPair key_pair = GenerateEcdhKeyPair();
+      absl::MutexLock lock(&mutex_);
+      key_pairs_.push_back(std::move(key_pair));
+    }
+  }
+
+  bool HasSpaceOrIsStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return is_stopping_ || key_pairs_.size() < kEcdhKeyPoolSize;
+  }
+
+  absl::Mutex mutex_;
+  std::deque<EcdhKeyPair> key_pairs_ ABSL_GUARDED_BY(mutex_);
+  bool is_stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  // Declared last, so that the thread starts after all other members exist.
+  std::thread filler_;
+};
+
+// The pool owned by the current ScopedEcdhKeyPool, if any.
+ABSL_CONST_INIT absl::Mutex active_pool_mutex(absl::kConstInit);
+EcdhKeyPool* active_pool ABSL_GUARDED_BY(active_pool_mutex) = nullptr;
+
+// Takes a key pair from the active pool, or generates one on the calling
+// thread if there is no pool or it is empty.
+EcdhKeyPair TakeEcdhKeyPair() {
+  {
+    absl::MutexLock lock(&active_pool_mutex);
+    if (active_pool != nullptr) {
+      std::optional<EcdhKeyPair> key_pair = active_pool->TryTake();
+      if (key_pair.has_value()) {
+        return std::move(*key_pair);
+      }
+    }
+  }
+  return GenerateEcdhKeyPair();
+}
+
+// Only the structure and constants matter when checking keys, so this is a
+// fixed, valid example.
+cbor::Value::MapValue FixedExampleEcdhCoseKey() {
+  cbor::Value::MapValue example_cose_key;
+  example_cose_key[cbor::Value(1)] = cbor::Value(kEcdhKeyType);
+  // The spec asks for -25, even though it is not the algorithm in use.
+  example_cose_key[cbor::Value(3)] =
+      cbor::Value(static_cast<int>(Algorithm::kEcdhEsHkdf256));
+  example_cose_key[cbor::Value(-1)] = cbor::Value(kCurveParameter);
+  example_cose_key[cbor::Value(-2)] = cbor::Value(cbor::Value::BinaryValue(
+      {0xb2, 0x07, 0x17, 0xfb, 0xc7, 0xc8, 0x25, 0x17, 0xf5, 0x11, 0x02,
+       0x7d, 0x9e, 0x80, 0x88, 0x8a, 0xbd, 0x33, 0xa1, 0x83, 0x7c, 0xe8,
+       0x35, 0xa5, 0x0c, 0xef, 0xfd, 0x4d, 0xea, 0x14, 0x33, 0x7b}));
+  example_cose_key[cbor::Value(-3)] = cbor::Value(cbor::Value::BinaryValue(
+      {0x9d, 0x13, 0x28, 0x23, 0xed, 0xd8, 0x52, 0xdc, 0xc2, 0x1e, 0x49,
+       0x23, 0x16, 0x8d, 0xf9, 0x6f, 0xe6, 0x9e, 0xa5, 0x91, 0xe1, 0xc2,
+       0xd1, 0x3e, 0x98, 0xe4, 0x92, 0x06, 0x73, 0xec, 0x31, 0xb0}));
+  return example_cose_key;
+}
+
+// Returns nullptr if the key is malformed or its algorithm is unsupported.
+bssl::UniquePtr<EVP_PKEY> EvpKeyFromCose(
+    const cbor::Value::MapValue& cose_public_key) {
+  auto get_entry = [&cose_public_key](int key) -> const cbor::Value* {
+    auto iter = cose_public_key.find(cbor::Value(key));
+    return iter == cose_public_key.end() ? nullptr : &iter->second;
+  };
+  auto get_bignum = [&get_entry](int key) -> bssl::UniquePtr<BIGNUM> {
+    const cbor::Value* entry = get_entry(key);
+    if (entry == nullptr || !entry->is_bytestring()) {
+      return nullptr;
+    }
+    const cbor::Value::BinaryValue& bytes = entry->GetBytestring();
+    return bssl::UniquePtr<BIGNUM>(
+        BN_bin2bn(bytes.data(), bytes.size(), nullptr));
+  };
+
+  const cbor::Value* alg = get_entry(3);
+  if (alg == nullptr || !alg->is_integer()) {
+    return nullptr;
+  }
+  bssl::UniquePtr<EVP_PKEY> evp_key(EVP_PKEY_new());
+  switch (alg->GetInteger()) {
+    case static_cast<int>(Algorithm::kEs256Algorithm): {
+      bssl::UniquePtr<BIGNUM> x = get_bignum(-2);
+      bssl::UniquePtr<BIGNUM> y = get_bignum(-3);
+      bssl::UniquePtr<EC_KEY> ec_key(EC_KEY_new_by_curve_name(kCurveName));
+      // Also rejects points that are not on the curve.
+      if (!x || !y ||
+          !EC_KEY_set_public_key_affine_coordinates(ec_key.get(), x.get(),
+                                                    y.get()) ||
+          !EVP_PKEY_set1_EC_KEY(evp_key.get(), ec_key.get())) {
+        return nullptr;
+      }
+      return evp_key;
+    }
+    case static_cast<int>(Algorithm::kRs256Algorithm): {
+      bssl::UniquePtr<BIGNUM> n = get_bignum(-1);
+      bssl::UniquePtr<BIGNUM> e = get_bignum(-2);
+      bssl::UniquePtr<RSA> rsa(RSA_new());
+      if (!n || !e || !RSA_set0_key(rsa.get(), n.get(), e.get(), nullptr)) {
+        return nullptr;
+      }
+      // The RSA key owns the bignums now.
+      n.release();
+      e.release();
+      if (!EVP_PKEY_set1_RSA(evp_key.get(), rsa.get())) {
+        return nullptr;
+      }
+      return evp_key;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+// Verifies a SHA256 based signature, using the padding or encoding that is
+// the default for the key type.
+bool VerifyWithEvpKey(EVP_PKEY* public_key, const std::vector<uint8_t>& message,
+                      const std::vector<uint8_t>& signature) {
+  bssl::UniquePtr<EVP_MD_CTX> md_ctx(EVP_MD_CTX_new());
+  CHECK(md_ctx != nullptr) << "unable to create EVP_MD_CTX - TEST SUITE BUG";
+  return EVP_DigestVerifyInit(md_ctx.get(), nullptr, EVP_sha256(), nullptr,
+                              public_key) == 1 &&
+         EVP_DigestVerifyUpdate(md_ctx.get(), message.data(),
+                                message.size()) == 1 &&
+         EVP_DigestVerifyFinal(md_ctx.get(), signature.data(),
+                               signature.size()) == 1;
+}
+
 std::vector<uint8_t> Aes256Cbc(const std::vector<uint8_t>& key,
                                const std::vector<uint8_t>& message,
                                bool is_encrypt_mode) {
@@ -123,26 +333,30 @@ std::vector<uint8_t> Aes256Cbc(const std::vector<uint8_t>& key,
 
 }  // namespace
 
+ScopedEcdhKeyPool::ScopedEcdhKeyPool() {
+  absl::MutexLock lock(&active_pool_mutex);
+  CHECK(active_pool == nullptr)
+      << "only one ECDH key pool may exist - TEST SUITE BUG";
+  active_pool = new EcdhKeyPool();
+}
+
+ScopedEcdhKeyPool::~ScopedEcdhKeyPool() {
+  EcdhKeyPool* pool;
+  {
+    absl::MutexLock lock(&active_pool_mutex);
+    pool = active_pool;
+    active_pool = nullptr;
+  }
+  // Joins the background thread outside the lock, so handshakes don't wait.
+  delete pool;
+}
+
 cbor::Value::MapValue GenerateExampleEcdhCoseKey() {
-  cbor::Value::MapValue example_cose_key;
-  example_cose_key[cbor::Value(1)] = cbor::Value(kEcdhKeyType);
-  // The spec asks for -25, even though it is not the algorithm in use.
-  example_cose_key[cbor::Value(3)] =
-      cbor::Value(static_cast<int>(Algorithm::kEcdhEsHkdf256));
-  example_cose_key[cbor::Value(-1)] = cbor::Value(kCurveParameter);
-  example_cose_key[cbor::Value(-2)] = cbor::Value(cbor::Value::BinaryValue(
-      {0xb2, 0x07, 0x17, 0xfb, 0xc7, 0xc8, 0x25, 0x17, 0xf5, 0x11, 0x02,
-       0x7d, 0x9e, 0x80, 0x88, 0x8a, 0xbd, 0x33, 0xa1, 0x83, 0x7c, 0xe8,
-       0x35, 0xa5, 0x0c, 0xef, 0xfd, 0x4d, 0xea, 0x14, 0x33, 0x7b}));
-  example_cose_key[cbor::Value(-3)] = cbor::Value(cbor::Value::BinaryValue(
-      {0x9d, 0x13, 0x28, 0x23, 0xed, 0xd8, 0x52, 0xdc, 0xc2, 0x1e, 0x49,
-       0x23, 0x16, 0x8d, 0xf9, 0x6f, 0xe6, 0x9e, 0xa5, 0x91, 0xe1, 0xc2,
-       0xd1, 0x3e, 0x98, 0xe4, 0x92, 0x06, 0x73, 0xec, 0x31, 0xb0}));
-  return example_cose_key;
+  return TakeEcdhKeyPair().cose_public_key;
 }
 
 void CheckEcdhCoseKey(const cbor::Value::MapValue& cose_key) {
-  cbor::Value::MapValue correct_cose_key = GenerateExampleEcdhCoseKey();
+  cbor::Value::MapValue correct_cose_key = FixedExampleEcdhCoseKey();
 
   for (const auto& map_entry : cose_key) {
     auto correct_cose_iter = correct_cose_key.find(map_entry.first);
@@ -181,29 +395,25 @@ std::vector<uint8_t> Aes256CbcEncrypt(const std::vector<uint8_t>& key,
 std::vector<uint8_t> CompleteEcdhHandshake(
     const cbor::Value::MapValue& cose_public_key_in,
     cbor::Value::MapValue* cose_public_key_out) {
-  std::vector<uint8_t> public_key_in_x =
+  const std::vector<uint8_t>& public_key_in_x =
       cose_public_key_in.find(cbor::Value(-2))->second.GetBytestring();
-  std::vector<uint8_t> public_key_in_y =
+  const std::vector<uint8_t>& public_key_in_y =
       cose_public_key_in.find(cbor::Value(-3))->second.GetBytestring();
 
-  bssl::UniquePtr<EC_GROUP> group(EC_GROUP_new_by_curve_name(kCurveName));
-  CHECK(group != nullptr) << "unable to create EC group - TEST SUITE BUG";
-  bssl::UniquePtr<EC_POINT> received_point(EcPointFromPublicCoordinates(
-      group.get(), public_key_in_x, public_key_in_y));
+  const EC_GROUP* group = GetP256Group();
+  bssl::UniquePtr<EC_POINT> received_point(
+      EcPointFromPublicCoordinates(group, public_key_in_x, public_key_in_y));
 
-  bssl::UniquePtr<EC_KEY> generated_key(EC_KEY_new_by_curve_name(kCurveName));
-  CHECK(EC_KEY_generate_key(generated_key.get()))
-      << "could not generate platform key - TEST SUITE BUG";
-  WritePublicKeyToCoseMap(group.get(),
-                          EC_KEY_get0_public_key(generated_key.get()),
-                          cose_public_key_out);
+  EcdhKeyPair generated_key_pair = TakeEcdhKeyPair();
+  *cose_public_key_out = std::move(generated_key_pair.cose_public_key);
 
-  size_t field_size = EC_GROUP_get_degree(group.get());
+  size_t field_size = EC_GROUP_get_degree(group);
   size_t field_byte_length = (field_size + 7) / 8;
   std::vector<uint8_t> key_product_x(field_byte_length, 0);
   // Without a KDF, the output is the x coordinate of the resulting EC point.
   CHECK(ECDH_compute_key(key_product_x.data(), field_byte_length,
-                         received_point.get(), generated_key.get(), nullptr))
+                         received_point.get(), generated_key_pair.key.get(),
+                         nullptr))
       << "unable to generate secret EC key";
   return Sha256Hash(key_product_x);
 }
@@ -219,6 +429,26 @@ std::vector<uint8_t> ExtractEcdsaSignatureR(
   return r_bytes;
 }
 
+bool VerifyCoseSignature(const cbor::Value::MapValue& cose_public_key,
+                         const std::vector<uint8_t>& message,
+                         const std::vector<uint8_t>& signature) {
+  bssl::UniquePtr<EVP_PKEY> public_key = EvpKeyFromCose(cose_public_key);
+  return public_key && VerifyWithEvpKey(public_key.get(), message, signature);
+}
+
+bool VerifyCertificateSignature(const std::vector<uint8_t>& certificate,
+                                const std::vector<uint8_t>& message,
+                                const std::vector<uint8_t>& signature) {
+  const uint8_t* certificate_data = certificate.data();
+  bssl::UniquePtr<X509> x509(
+      d2i_X509(nullptr, &certificate_data, certificate.size()));
+  if (!x509) {
+    return false;
+  }
+  bssl::UniquePtr<EVP_PKEY> public_key(X509_get_pubkey(x509.get()));
+  return public_key && VerifyWithEvpKey(public_key.get(), message, signature);
+}
+
 std::vector<uint8_t> LeftHmacSha256(const std::vector<uint8_t>& secret,
                                     const std::vector<uint8_t>& message) {
   uint8_t hmac_result[SHA256_DIGEST_LENGTH];
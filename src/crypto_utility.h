@@ -22,7 +22,21 @@
 namespace fido2_tests {
 namespace crypto_utility {
 
-// Generates a valid ECDH public key and outputs it in COSE key format.
+// Keeps ECDH key pairs ready on a background thread while it exists, so that
+// handshakes and example keys don't wait for key generation. Without a pool,
+// keys are generated on the calling thread. Only one pool may exist at a time.
+// Worth it for corpus runs, which do a key agreement after every input.
+class ScopedEcdhKeyPool {
+ public:
+  ScopedEcdhKeyPool();
+  // Stops the background thread and discards unused key pairs.
+  ~ScopedEcdhKeyPool();
+  ScopedEcdhKeyPool(const ScopedEcdhKeyPool&) = delete;
+  ScopedEcdhKeyPool& operator=(const ScopedEcdhKeyPool&) = delete;
+};
+
+// Generates a valid ECDH public key and outputs it in COSE key format. Uses a
+// pre-generated key pair if a ScopedEcdhKeyPool exists.
 cbor::Value::MapValue GenerateExampleEcdhCoseKey();
 
 // Checks if the ECDH COSE key contains all necessary keys, if it has
@@ -45,7 +59,8 @@ std::vector<uint8_t> Aes256CbcEncrypt(const std::vector<uint8_t>& key,
 // using cose_public_key_in as the peer's public key. Returns the shared secret
 // (i.e. the SHA256 of big-endian encoding of the x-coordinate of the shared
 // point) and writes the generated public key, in COSE format, to
-// cose_public_key_out.
+// cose_public_key_out. Uses a pre-generated key pair if a ScopedEcdhKeyPool
+// exists, so that only the key agreement is computed here.
 std::vector<uint8_t> CompleteEcdhHandshake(
     const cbor::Value::MapValue& cose_public_key_in,
     cbor::Value::MapValue* cose_public_key_out);
@@ -55,6 +70,18 @@ std::vector<uint8_t> CompleteEcdhHandshake(
 std::vector<uint8_t> ExtractEcdsaSignatureR(
     const std::vector<uint8_t>& ecdsa_signature);
 
+// Verifies an ES256 (DER encoded) or RS256 signature of the message with the
+// public key in COSE format. Returns false on invalid signatures, and also if
+// the key is malformed or uses another algorithm.
+bool VerifyCoseSignature(const cbor::Value::MapValue& cose_public_key,
+                         const std::vector<uint8_t>& message,
+                         const std::vector<uint8_t>& signature);
+
+// As above, but uses the public key of a DER encoded X.509 certificate.
+bool VerifyCertificateSignature(const std::vector<uint8_t>& certificate,
+                                const std::vector<uint8_t>& message,
+                                const std::vector<uint8_t>& signature);
+
 // Returns the first 16 bytes of an HMAC using SHA256, using the given secret
 // and message.
 std::vector<uint8_t> LeftHmacSha256(const std::vector<uint8_t>& secret,
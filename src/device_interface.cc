@@ -0,0 +1,45 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/device_interface.h"
+
+#include "glog/logging.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+namespace fido2_tests {
+
+Status DeviceInterface::ExchangeCborRequest(
+    Command command, const cbor::Value& request, bool expect_up_check,
+    std::vector<uint8_t>* response_cbor) const {
+  auto encoded_request = cbor::Writer::Write(request);
+  CHECK(encoded_request.has_value()) << "encoding went wrong - TEST SUITE BUG";
+  return ExchangeCbor(command, *encoded_request, expect_up_check,
+                      response_cbor);
+}
+
+Status DeviceInterface::ExchangeCborMessage(
+    const std::vector<uint8_t>& message, bool expect_up_check,
+    std::vector<uint8_t>* response_cbor) const {
+  if (message.empty()) return Status::kErrInvalidLength;
+  const std::vector<uint8_t> payload(message.begin() + 1, message.end());
+  return ExchangeCbor(static_cast<Command>(message[0]), payload,
+                      expect_up_check, response_cbor);
+}
+
+Status DeviceInterface::ExchangeRawFrames(
+    const std::vector<uint8_t>& data) const {
+  return Status::kErrInvalidCommand;
+}
+
+}  // namespace fido2_tests
@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "src/constants.h"
+#include "third_party/chromium_components_cbor/values.h"
 
 namespace fido2_tests {
 
@@ -39,6 +40,27 @@ class DeviceInterface {
                               const std::vector<uint8_t>& payload,
                               bool expect_up_check,
                               std::vector<uint8_t>* response_cbor) const = 0;
+  // Same as ExchangeCbor, but encodes the request itself. Interfaces can
+  // override this to encode directly into their transport frames. The default
+  // implementation encodes into a buffer and calls ExchangeCbor.
+  virtual Status ExchangeCborRequest(Command command,
+                                     const cbor::Value& request,
+                                     bool expect_up_check,
+                                     std::vector<uint8_t>* response_cbor) const;
+  // Same as ExchangeCbor, but the first byte of the message is the command
+  // byte. This allows sending command bytes that are not in the Command enum,
+  // like unknown or vendor commands. The default implementation splits off the
+  // command byte and calls ExchangeCbor. It returns kErrInvalidLength for an
+  // empty message, which interfaces that can send one should override.
+  virtual Status ExchangeCborMessage(const std::vector<uint8_t>& message,
+                                     bool expect_up_check,
+                                     std::vector<uint8_t>* response_cbor) const;
+  // Sends the data as a sequence of raw transport frames, without fixing
+  // channel IDs, sequence numbers or lengths. Responses are not reassembled,
+  // only drained. Afterwards, checks that the device still answers. Returns
+  // kErrTimeout if it stalled. The default implementation is for interfaces
+  // without frames and returns kErrInvalidCommand.
+  virtual Status ExchangeRawFrames(const std::vector<uint8_t>& data) const;
 };
 
 // Contains all device identifier for logging and to re-identify the device.
@@ -18,6 +18,8 @@
 #include <fstream>
 #include <iostream>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/time/clock.h"
 #include "src/parameter_check.h"
 #include "third_party/chromium_components_cbor/values.h"
@@ -27,6 +29,13 @@ extern const char build_scm_revision[];
 namespace fido2_tests {
 namespace {
 constexpr std::string_view kFileType = ".json";
+constexpr std::string_view kStreamFileType = ".jsonl";
+// Only the first details of an observation template are kept for the report.
+constexpr size_t kMaxObservationDetails = 10;
+
+std::string CurrentDateString() {
+  return absl::FormatTime("%Y-%m-%d", absl::Now(), absl::LocalTimeZone());
+}
 
 // Creates a directory for results files and returns the path. Just return
 // the path if that directory already exists. Fails if the directory wasn't
@@ -133,8 +142,22 @@ void DeviceTracker::SetDeviceIdentifiers(DeviceIdentifiers device_identifiers) {
   device_identifiers_ = std::move(device_identifiers);
 }
 
+const DeviceIdentifiers& DeviceTracker::GetDeviceIdentifiers() const {
+  return device_identifiers_;
+}
+
 void DeviceTracker::SetAaguid(std::string_view aaguid) { aaguid_ = aaguid; }
 
+const std::string& DeviceTracker::GetAaguid() const { return aaguid_; }
+
+void DeviceTracker::SetFirmwareVersion(int64_t firmware_version) {
+  firmware_version_ = firmware_version;
+}
+
+std::optional<int64_t> DeviceTracker::GetFirmwareVersion() const {
+  return firmware_version_;
+}
+
 void DeviceTracker::IgnoreNextTouchPrompt() { ignores_touch_prompt_ = true; }
 
 bool DeviceTracker::IsTouchPromptIgnored() {
@@ -143,17 +166,90 @@ bool DeviceTracker::IsTouchPromptIgnored() {
   return reponse;
 }
 
+std::string DeviceTracker::ObservationCount::ToString() const {
+  std::string result = observation;
+  if (count > 1) {
+    absl::StrAppend(&result, " × ", count);
+  }
+  if (!details.empty()) {
+    absl::StrAppend(&result, " (", absl::StrJoin(details, ", "));
+    if (has_omitted_details) {
+      absl::StrAppend(&result, ", ...");
+    }
+    absl::StrAppend(&result, ")");
+  }
+  return result;
+}
+
+DeviceTracker::ObservationCount* DeviceTracker::CountObservation(
+    const std::string& observation) {
+  auto [index_iter, is_new] =
+      observation_index_.try_emplace(observation, observations_.size());
+  if (is_new) {
+    observations_.push_back({.observation = observation});
+  }
+  ObservationCount* entry = &observations_[index_iter->second];
+  entry->count += 1;
+  return entry;
+}
+
 void DeviceTracker::AddObservation(const std::string& observation) {
-  if (std::find(observations_.begin(), observations_.end(), observation) ==
-      observations_.end()) {
-    observations_.push_back(observation);
+  ObservationCount* entry = CountObservation(observation);
+  if (results_stream_ && entry->count == 1) {
+    results_stream_->AppendObservation(observation);
+  }
+}
+
+void DeviceTracker::AddObservation(const std::string& observation,
+                                   std::string_view detail) {
+  ObservationCount* entry = CountObservation(observation);
+  if (std::find(entry->details.begin(), entry->details.end(), detail) !=
+      entry->details.end()) {
+    return;
+  }
+  if (entry->details.size() >= kMaxObservationDetails) {
+    entry->has_omitted_details = true;
+  } else {
+    entry->details.push_back(std::string(detail));
+    if (results_stream_) {
+      results_stream_->AppendObservation(
+          absl::StrCat(observation, " (", detail, ")"));
+    }
+  }
+}
+
+void DeviceTracker::CollectSignatureFailures() {
+  for (const std::string& failure : signature_verifier_.Join()) {
+    AddObservation("A signature does not verify", failure);
+  }
+}
+
+std::vector<std::string> DeviceTracker::PendingObservations() const {
+  std::vector<std::string> observations;
+  observations.reserve(observations_.size());
+  for (const ObservationCount& entry : observations_) {
+    observations.push_back(entry.ToString());
+  }
+  return observations;
+}
+
+void DeviceTracker::StreamResultsTo(std::string_view results_dir) {
+  std::filesystem::path stream_path = absl::StrCat(
+      CreateSaveFileDirectory(results_dir), device_identifiers_.product_name,
+      "_", device_identifiers_.serial_number, kStreamFileType);
+  results_stream_ = std::make_unique<ResultsStream>(stream_path);
+  has_streamed_metadata_ = false;
+  // Observations made before streaming still belong to the next test.
+  for (const std::string& observation : PendingObservations()) {
+    results_stream_->AppendObservation(observation);
   }
 }
 
 void DeviceTracker::AssertCondition(bool condition, std::string_view message) {
   if (!condition) {
+    CollectSignatureFailures();
     SaveResultsToFile();
-    for (std::string_view observation : observations_) {
+    for (std::string_view observation : PendingObservations()) {
       PrintWarningMessage(observation);
     }
   }
@@ -204,15 +300,36 @@ bool DeviceTracker::CheckStatus(
   return CheckStatus(returned_status);
 }
 
-void DeviceTracker::LogTest(std::string test_id, std::string test_description,
-                            std::optional<std::string> error_message,
-                            std::vector<std::string> tags) {
+nlohmann::json DeviceTracker::LogTest(std::string test_id,
+                                     std::string test_description,
+                                     std::optional<std::string> error_message,
+                                     std::vector<std::string> tags) {
+  CollectSignatureFailures();
   TestResult result = {.test_id = std::move(test_id),
                        .test_description = std::move(test_description),
                        .error_message = std::move(error_message),
-                       .observations = std::move(observations_),
+                       .observations = PendingObservations(),
                        .tags = std::move(tags)};
   observations_ = {};
+  observation_index_ = {};
+  nlohmann::json test_json = result.ToJson();
+  RecordTest(std::move(result));
+  return test_json;
+}
+
+void DeviceTracker::LogCachedTest(const nlohmann::json& test) {
+  TestResult result = {
+      .test_id = test.value("id", ""),
+      .test_description = test.value("description", ""),
+      .error_message = std::nullopt,
+      .observations =
+          test.value("observations", std::vector<std::string>()),
+      .tags = test.value("tags", std::vector<std::string>())};
+  result.observations.push_back("The result was reused from an earlier run.");
+  RecordTest(std::move(result));
+}
+
+void DeviceTracker::RecordTest(TestResult result) {
   if (result.error_message.has_value()) {
     PrintFailMessage(absl::StrCat("Failed test: ", result.test_description,
                                   " - ", result.error_message.value()));
@@ -223,26 +340,42 @@ void DeviceTracker::LogTest(std::string test_id, std::string test_description,
   for (std::string_view observation : result.observations) {
     PrintWarningMessage(observation);
   }
-  tests_.push_back(std::move(result));
+  if (results_stream_) {
+    if (!has_streamed_metadata_) {
+      // Makes the stream self-contained, in case the tool crashes.
+      results_stream_->AppendMetadata(
+          GenerateMetadataJson(build_scm_revision, CurrentDateString()));
+      has_streamed_metadata_ = true;
+    }
+    results_stream_->AppendTest(result.ToJson());
+  } else {
+    tests_.push_back(std::move(result));
+  }
 }
 
 KeyChecker* DeviceTracker::GetKeyChecker() { return &key_checker_; }
 
 CounterChecker* DeviceTracker::GetCounterChecker() { return &counter_checker_; }
 
+SignatureVerifier* DeviceTracker::GetSignatureVerifier() {
+  return &signature_verifier_;
+}
+
 void DeviceTracker::ReportFindings() const {
   int failed_test_count = 0;
-  for (const TestResult& test : tests_) {
-    if (test.error_message.has_value()) {
+  const std::vector<nlohmann::json> tests = CollectTests();
+  for (const nlohmann::json& test : tests) {
+    if (test["result"] != "pass") {
       failed_test_count += 1;
-      PrintFailMessage(absl::StrCat("Failed test: ", test.test_description,
-                                    " - ", test.error_message.value()));
-      for (std::string_view observation : test.observations) {
-        PrintWarningMessage(observation);
+      PrintFailMessage(absl::StrCat(
+          "Failed test: ", test["description"].get<std::string>(), " - ",
+          test["error_message"].get<std::string>()));
+      for (const auto& observation : test["observations"]) {
+        PrintWarningMessage(observation.get<std::string>());
       }
     }
   }
-  int test_count = tests_.size();
+  int test_count = tests.size();
   int successful_test_count = test_count - failed_test_count;
   std::cout << "Passed " << successful_test_count << " out of " << test_count
             << " tests." << std::endl;
@@ -250,18 +383,13 @@ void DeviceTracker::ReportFindings() const {
 
 nlohmann::json DeviceTracker::GenerateResultsJson(
     std::string_view commit_hash, std::string_view time_string) const {
-  int failed_test_count = 0;
-  for (const TestResult& test : tests_) {
-    if (test.error_message.has_value()) {
-      failed_test_count += 1;
-    }
-  }
-  int test_count = tests_.size();
-  int successful_test_count = test_count - failed_test_count;
+  return SummarizeResults(GenerateMetadataJson(commit_hash, time_string),
+                          CollectTests());
+}
 
-  nlohmann::json results = {
-      {"passed_test_count", successful_test_count},
-      {"total_test_count", test_count},
+nlohmann::json DeviceTracker::GenerateMetadataJson(
+    std::string_view commit_hash, std::string_view time_string) const {
+  return {
       {"date", time_string},
       {"commit", commit_hash},
       {
@@ -297,16 +425,25 @@ nlohmann::json DeviceTracker::GenerateResultsJson(
           },
       },
   };
+}
+
+std::vector<nlohmann::json> DeviceTracker::CollectTests() const {
+  if (results_stream_) {
+    return ResultsStream::ReadTests(results_stream_->GetPath());
+  }
+  std::vector<nlohmann::json> tests;
   for (const TestResult& test : tests_) {
-    results["tests"].push_back(test.ToJson());
+    tests.push_back(test.ToJson());
   }
-  return results;
+  return tests;
 }
 
 void DeviceTracker::SaveResultsToFile(std::string_view results_dir) const {
-  absl::Time now = absl::Now();
-  absl::TimeZone local = absl::LocalTimeZone();
-  std::string time_string = absl::FormatTime("%Y-%m-%d", now, local);
+  std::string time_string = CurrentDateString();
+  if (results_stream_) {
+    results_stream_->AppendMetadata(
+        GenerateMetadataJson(build_scm_revision, time_string));
+  }
 
   std::filesystem::path results_path = absl::StrCat(
       CreateSaveFileDirectory(results_dir), device_identifiers_.product_name,
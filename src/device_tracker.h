@@ -15,13 +15,17 @@
 #ifndef DEVICE_TRACKER_H_
 #define DEVICE_TRACKER_H_
 
+#include <memory>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "nlohmann/json.hpp"
 #include "src/constants.h"
 #include "src/device_interface.h"
 #include "src/parameter_check.h"
+#include "src/results_stream.h"
+#include "src/signature_verifier.h"
 #include "third_party/chromium_components_cbor/values.h"
 
 namespace fido2_tests {
@@ -73,17 +77,37 @@ class DeviceTracker {
   // Setter for the device identifiers, for writing to the result file. Must be
   // called at least once.
   void SetDeviceIdentifiers(DeviceIdentifiers device_identifiers);
+  // Returns the device identifiers set through SetDeviceIdentifiers.
+  const DeviceIdentifiers& GetDeviceIdentifiers() const;
   // Setter for the AAGUID, which is reported as a device identifier.
   void SetAaguid(std::string_view aaguid);
+  // Returns the AAGUID set through SetAaguid, or an empty string.
+  const std::string& GetAaguid() const;
+  // Setter for the firmware version from GetInfo, if the device reports one.
+  void SetFirmwareVersion(int64_t firmware_version);
+  // Returns the firmware version set through SetFirmwareVersion.
+  std::optional<int64_t> GetFirmwareVersion() const;
   // The next time a touch prompt is received, it should be ignored. Call
   // IsTouchPromptIgnored to consume.
   void IgnoreNextTouchPrompt();
   // Returns true if IgnoreNextTouchPrompt was called before, and then false
   // until IgnoreNextTouchPrompt is called again.
   bool IsTouchPromptIgnored();
-  // Adds a string to the list of observations. Duplicates are ignored.
+  // Adds a string to the list of observations. Duplicates are counted instead
+  // of being listed again, and are reported as "observation × count".
   // Observations are logged with the next finished test.
   void AddObservation(const std::string& observation);
+  // As above, but the observation is a template that is shared between many
+  // occurrences, while the detail tells them apart, e.g. the name of the input
+  // file. Only the first few details of each template are kept, all further
+  // occurrences are only counted.
+  void AddObservation(const std::string& observation, std::string_view detail);
+  // From now on, writes every observation and test to a JSON Lines file in the
+  // results directory as soon as it is logged, instead of keeping them in
+  // memory. The file name matches the results file, with a ".jsonl" ending.
+  // Call after setting the device identifiers. Saving the results file then
+  // compacts the stream. See ResultsStream for the format.
+  void StreamResultsTo(std::string_view results_dir = "results/");
   // Asserts a general condition, exits on failure. Prints all results collected
   // so far and saves them into a file.
   void AssertCondition(bool condition, std::string_view message);
@@ -100,18 +124,26 @@ class DeviceTracker {
   bool CheckStatus(Status expected_status, Status returned_status);
   // Returns whether the response is a value or the success status.
   bool CheckStatus(const absl::variant<cbor::Value, Status>& returned_variant);
-  // Logs a test and its result.
-  void LogTest(std::string test_id, std::string test_description,
-               std::optional<std::string> error_message,
-               std::vector<std::string> tags);
+  // Logs a test and its result. Waits for queued signature verifications
+  // first, and adds their failures as observations. Returns the test in the
+  // format of the results file.
+  nlohmann::json LogTest(std::string test_id, std::string test_description,
+                         std::optional<std::string> error_message,
+                         std::vector<std::string> tags);
+  // Logs a passed test from an earlier run, in the format of the results file.
+  // Pending observations belong to the next executed test instead.
+  void LogCachedTest(const nlohmann::json& test);
   // Returns a reference to the KeyChecker instance.
   KeyChecker* GetKeyChecker();
   // Returns a reference to the CounterChecker instance.
   CounterChecker* GetCounterChecker();
+  // Returns a reference to the SignatureVerifier instance.
+  SignatureVerifier* GetSignatureVerifier();
   // Prints a report including all information from the CounterChecker, logged
   // observations, problems and tests.
   void ReportFindings() const;
-  // Generates a JSON object with test results.
+  // Generates a JSON object with test results. If results are streamed, the
+  // tests are read back from the stream file.
   nlohmann::json GenerateResultsJson(std::string_view commit_hash,
                                      std::string_view time_string) const;
   // Saves the results to a JSON file. Creates a "results" directory, if
@@ -121,17 +153,50 @@ class DeviceTracker {
   void SaveResultsToFile(std::string_view results_dir = "results/") const;
 
  private:
+  // An observation with all its occurrences since the last logged test.
+  struct ObservationCount {
+    std::string observation;
+    int count = 0;
+    std::vector<std::string> details;
+    bool has_omitted_details = false;
+    // Returns the observation, its count if it happened more than once, and
+    // the stored details.
+    std::string ToString() const;
+  };
+
+  // Counts an occurrence of the observation and returns its entry.
+  ObservationCount* CountObservation(const std::string& observation);
+  // Waits for the SignatureVerifier and adds observations for failures.
+  void CollectSignatureFailures();
+  // Prints, streams or stores the test result.
+  void RecordTest(TestResult result);
+  // Returns all observations since the last logged test, in order of their
+  // first appearance.
+  std::vector<std::string> PendingObservations() const;
+  // Generates the JSON object with all results, except for tests.
+  nlohmann::json GenerateMetadataJson(std::string_view commit_hash,
+                                      std::string_view time_string) const;
+  // Returns all logged tests in the results file format, with observations.
+  std::vector<nlohmann::json> CollectTests() const;
+
   KeyChecker key_checker_;
   CounterChecker counter_checker_;
+  SignatureVerifier signature_verifier_;
   // You need to call SetDeviceIdentifiers to initialize.
   DeviceIdentifiers device_identifiers_;
   std::string aaguid_;
+  std::optional<int64_t> firmware_version_;
   bool ignores_touch_prompt_ = false;
   // We want the observations, problems and tests to be listed in order of
-  // appearance.
-  std::vector<std::string> observations_;
+  // appearance. The index maps observations to their position for constant
+  // time deduplication.
+  std::vector<ObservationCount> observations_;
+  absl::flat_hash_map<std::string, size_t> observation_index_;
   std::vector<std::string> problems_;
   std::vector<TestResult> tests_;
+  // Only set while streaming, tests_ stays empty then.
+  std::unique_ptr<ResultsStream> results_stream_;
+  bool has_streamed_metadata_ = false;
   absl::flat_hash_set<std::string> versions_;
   absl::flat_hash_set<std::string> extensions_;
   // Some options have three states, unsupported, inactive and active.
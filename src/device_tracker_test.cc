@@ -14,6 +14,8 @@
 
 #include "src/device_tracker.h"
 
+#include <filesystem>
+
 #include "gtest/gtest.h"
 #include "src/constants.h"
 #include "third_party/chromium_components_cbor/values.h"
@@ -148,6 +150,94 @@ TEST(DeviceTracker, TestGenerateResultsJson) {
   EXPECT_EQ(output, expected_output);
 }
 
+TEST(DeviceTracker, TestObservationCounts) {
+  DeviceTracker device_tracker = DeviceTracker();
+  device_tracker.AddObservation("SINGLE");
+  device_tracker.AddObservation("REPEATED");
+  device_tracker.AddObservation("REPEATED");
+  device_tracker.AddObservation("TEMPLATE", "in file A");
+  device_tracker.AddObservation("TEMPLATE", "in file B");
+  device_tracker.AddObservation("TEMPLATE", "in file A");
+  device_tracker.LogTest("TEST", "DESCRIPTION", std::nullopt, {});
+
+  nlohmann::json output =
+      device_tracker.GenerateResultsJson("c0", "2020-01-01");
+  nlohmann::json expected_observations = {
+      "SINGLE", "REPEATED × 2", "TEMPLATE × 3 (in file A, in file B)"};
+  EXPECT_EQ(output["tests"][0]["observations"], expected_observations);
+}
+
+TEST(DeviceTracker, TestObservationDetailCap) {
+  DeviceTracker device_tracker = DeviceTracker();
+  for (int i = 0; i < 1000; ++i) {
+    device_tracker.AddObservation("TEMPLATE", absl::StrCat(i));
+  }
+  device_tracker.LogTest("TEST", "DESCRIPTION", std::nullopt, {});
+
+  nlohmann::json output =
+      device_tracker.GenerateResultsJson("c0", "2020-01-01");
+  EXPECT_EQ(output["tests"][0]["observations"],
+            nlohmann::json({"TEMPLATE × 1000 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, "
+                            "...)"}));
+}
+
+TEST(DeviceTracker, TestObservationsResetPerTest) {
+  DeviceTracker device_tracker = DeviceTracker();
+  device_tracker.AddObservation("OBSERVATION");
+  device_tracker.LogTest("FIRST_TEST", "DESCRIPTION", std::nullopt, {});
+  device_tracker.AddObservation("OBSERVATION");
+  device_tracker.LogTest("SECOND_TEST", "DESCRIPTION", std::nullopt, {});
+
+  nlohmann::json output =
+      device_tracker.GenerateResultsJson("c0", "2020-01-01");
+  EXPECT_EQ(output["tests"][0]["observations"],
+            nlohmann::json({"OBSERVATION"}));
+  EXPECT_EQ(output["tests"][1]["observations"],
+            nlohmann::json({"OBSERVATION"}));
+}
+
+TEST(DeviceTracker, TestLogCachedTest) {
+  DeviceTracker device_tracker = DeviceTracker();
+  nlohmann::json test_result =
+      device_tracker.LogTest("TEST", "DESCRIPTION", std::nullopt, {"TAG"});
+  device_tracker.LogCachedTest(test_result);
+
+  nlohmann::json output =
+      device_tracker.GenerateResultsJson("c0", "2020-01-01");
+  EXPECT_EQ(output["passed_test_count"], 2);
+  EXPECT_EQ(output["tests"][1]["id"], "TEST");
+  EXPECT_EQ(output["tests"][1]["tags"], nlohmann::json({"TAG"}));
+  EXPECT_EQ(output["tests"][1]["observations"].size(), 1);
+}
+
+TEST(DeviceTracker, TestStreamedResultsJson) {
+  std::filesystem::path results_dir =
+      std::filesystem::temp_directory_path() / "device_tracker_test/";
+  DeviceTracker memory_tracker = DeviceTracker();
+  DeviceTracker stream_tracker = DeviceTracker();
+  for (DeviceTracker* device_tracker : {&memory_tracker, &stream_tracker}) {
+    device_tracker->SetDeviceIdentifiers({.manufacturer = "M",
+                                          .product_name = "P",
+                                          .serial_number = "S",
+                                          .vendor_id = 1,
+                                          .product_id = 2});
+    device_tracker->AddObservation("EARLY_OBSERVATION");
+    if (device_tracker == &stream_tracker) {
+      device_tracker->StreamResultsTo(results_dir.string());
+    }
+    device_tracker->AddObservation("OBSERVATION");
+    device_tracker->AddObservation("OBSERVATION");
+    device_tracker->LogTest("FALSE_TEST", "FALSE_DESCRIPTION", "ERROR_MESSAGE",
+                            {});
+    device_tracker->LogTest("TRUE_TEST", "TRUE_DESCRIPTION", std::nullopt,
+                            {"TAG"});
+  }
+  EXPECT_EQ(stream_tracker.GenerateResultsJson("c0", "2020-01-01"),
+            memory_tracker.GenerateResultsJson("c0", "2020-01-01"));
+  EXPECT_TRUE(std::filesystem::exists(results_dir / "P_S.jsonl"));
+  std::filesystem::remove_all(results_dir);
+}
+
 }  // namespace
 }  // namespace fido2_tests
 
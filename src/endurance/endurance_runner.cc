@@ -0,0 +1,297 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/endurance/endurance_runner.h"
+
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+#include "absl/base/internal/endian.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/types/variant.h"
+#include "glog/logging.h"
+#include "src/cbor_builders.h"
+#include "src/constants.h"
+#include "src/endurance/latency_recorder.h"
+#include "src/fido2_commands.h"
+#include "src/request_template.h"
+#include "src/tests/test_helpers.h"
+#include "third_party/chromium_components_cbor/values.h"
+
+namespace fido2_tests {
+namespace {
+constexpr std::string_view kRelyingParty = "endurance.example.com";
+constexpr std::string_view kFileSuffix = "_endurance.jsonl";
+// The signature counter follows the RP ID hash and flags in authData.
+constexpr size_t kCounterOffset = 33;
+
+// Returns a unique user ID for each credential in a run. The cycle and index
+// are written in big endian into an otherwise zero user ID.
+cbor::Value::BinaryValue UserId(int cycle, int index) {
+  cbor::Value::BinaryValue user_id(32, 0x00);
+  for (int i = 0; i < 4; ++i) {
+    user_id[i] = (cycle >> (24 - 8 * i)) & 0xFF;
+    user_id[4 + i] = (index >> (24 - 8 * i)) & 0xFF;
+  }
+  return user_id;
+}
+
+// Reads the signature counter from a response that was already checked by
+// the positive test for the respective command.
+uint32_t ExtractSignatureCounter(const cbor::Value& response,
+                                 const cbor::Value& auth_data_key) {
+  const auto& response_map = response.GetMap();
+  auto map_iter = response_map.find(auth_data_key);
+  CHECK(map_iter != response_map.end()) << "no authData - TEST SUITE BUG";
+  const cbor::Value::BinaryValue& auth_data = map_iter->second.GetBytestring();
+  CHECK_GE(auth_data.size(), kCounterOffset + 4)
+      << "authData does not fit the counter - TEST SUITE BUG";
+  return absl::big_endian::Load32(auth_data.data() + kCounterOffset);
+}
+
+// Returns whether the value exceeds the baseline by more than the factor. A
+// zero baseline is treated as unknown.
+bool IsSlowerThan(absl::Duration value, absl::Duration baseline,
+                  double factor) {
+  return baseline > absl::ZeroDuration() &&
+         absl::FDivDuration(value, baseline) > factor;
+}
+}  // namespace
+
+EnduranceRunner::EnduranceRunner(DeviceInterface* device,
+                                 DeviceTracker* device_tracker,
+                                 CommandState* command_state,
+                                 const EnduranceOptions& options,
+                                 std::string_view results_dir)
+    : device_(device),
+      device_tracker_(device_tracker),
+      command_state_(command_state),
+      options_(options) {
+  std::string series_dir = std::string(results_dir);
+  if (const char* env_dir = std::getenv("BUILD_WORKSPACE_DIRECTORY")) {
+    series_dir = absl::StrCat(env_dir, "/", series_dir);
+  }
+  std::filesystem::create_directories(series_dir);
+  const DeviceIdentifiers& identifiers =
+      device_tracker_->GetDeviceIdentifiers();
+  const std::filesystem::path series_path =
+      std::filesystem::path(series_dir) /
+      absl::StrCat(identifiers.product_name, "_", identifiers.serial_number,
+                   kFileSuffix);
+  series_file_.open(series_path, std::ios::app);
+  CHECK(series_file_.is_open()) << "Unable to open file: " << series_path;
+  std::cout << "Writing the endurance time series to " << series_path
+            << std::endl;
+}
+
+int EnduranceRunner::Run() {
+  // Credentials are made without user verification.
+  command_state_->Prepare();
+  int cycles_with_warnings = 0;
+  for (int cycle = 0; cycle < options_.num_cycles; ++cycle) {
+    nlohmann::json record = RunCycle(cycle);
+    // std::endl flushes, so that every finished cycle is persisted.
+    series_file_ << record.dump() << std::endl;
+
+    std::cout << "Cycle " << cycle + 1 << "/" << options_.num_cycles << ": "
+              << record["credentials_created"] << " credentials, "
+              << record["make_credential"]["mean_ms"]
+              << " ms mean MakeCredential, "
+              << record["get_assertion"]["mean_ms"]
+              << " ms mean GetAssertion." << std::endl;
+    for (const auto& warning : record["warnings"]) {
+      std::cout << "\x1b[0;33m" << warning.get<std::string>() << "\x1b[0m"
+                << std::endl;
+    }
+    if (!record["warnings"].empty()) {
+      cycles_with_warnings += 1;
+    }
+  }
+  std::cout << "\nENDURANCE RESULTS\n"
+            << cycles_with_warnings << " of " << options_.num_cycles
+            << " cycles had warnings.\n"
+            << device_tracker_->GetCounterChecker()->ReportFindings()
+            << std::endl;
+  return cycles_with_warnings;
+}
+
+nlohmann::json EnduranceRunner::RunCycle(int cycle) {
+  const std::string rp_id(kRelyingParty);
+  std::vector<std::string> warnings;
+  absl::Time cycle_start = absl::Now();
+
+  // Fill the store until the authenticator refuses or the limit is reached.
+  LatencyRecorder make_credential_latencies;
+  std::vector<cbor::Value::BinaryValue> credential_ids;
+  std::vector<uint32_t> creation_counters;
+  int duplicate_credential_ids = 0;
+  MakeCredentialCborBuilder make_credential_builder;
+  make_credential_builder.AddDefaultsForRequiredFields(rp_id);
+  make_credential_builder.SetResidentKeyOptions(true);
+  make_credential_builder.SetPublicKeyCredentialUserEntity(UserId(cycle, 0),
+                                                           "Enduring Erin");
+  // Only the user ID changes between requests, so the request is encoded once.
+  RequestTemplate make_credential_template(make_credential_builder.GetCbor());
+  Status fill_status = Status::kErrNone;
+  const size_t max_credentials =
+      options_.max_credentials > 0
+          ? static_cast<size_t>(options_.max_credentials)
+          : std::numeric_limits<size_t>::max();
+  while (credential_ids.size() < max_credentials) {
+    make_credential_template.Patch(
+        static_cast<int>(MakeCredentialParameters::kUser), "id",
+        UserId(cycle, credential_ids.size()));
+    absl::Time start = absl::Now();
+    absl::variant<cbor::Value, Status> response =
+        fido2_commands::MakeCredentialPositiveTest(device_, device_tracker_,
+                                                   make_credential_template);
+    absl::Duration latency = absl::Now() - start;
+    if (absl::holds_alternative<Status>(response)) {
+      fill_status = absl::get<Status>(response);
+      break;
+    }
+    make_credential_latencies.Record(latency);
+    const cbor::Value& credential_response = absl::get<cbor::Value>(response);
+    cbor::Value::BinaryValue credential_id =
+        test_helpers::ExtractCredentialId(credential_response);
+    if (!credential_ids_.insert(credential_id).second) {
+      duplicate_credential_ids += 1;
+    }
+    creation_counters.push_back(ExtractSignatureCounter(
+        credential_response, CborValue(MakeCredentialResponse::kAuthData)));
+    credential_ids.push_back(std::move(credential_id));
+  }
+
+  // Assert every stored credential once. Counters must increase over the value
+  // returned at creation.
+  LatencyRecorder get_assertion_latencies;
+  int assertion_failures = 0;
+  int non_increasing_counters = 0;
+  GetAssertionCborBuilder get_assertion_builder;
+  get_assertion_builder.AddDefaultsForRequiredFields(rp_id);
+  get_assertion_builder.SetUserPresenceOptions(false);
+  for (size_t i = 0; i < credential_ids.size(); ++i) {
+    get_assertion_builder.SetAllowListCredential(credential_ids[i]);
+    absl::Time start = absl::Now();
+    absl::variant<cbor::Value, Status> response =
+        fido2_commands::GetAssertionPositiveTest(
+            device_, device_tracker_, get_assertion_builder.GetCbor());
+    absl::Duration latency = absl::Now() - start;
+    if (absl::holds_alternative<Status>(response)) {
+      assertion_failures += 1;
+      continue;
+    }
+    get_assertion_latencies.Record(latency);
+    uint32_t counter =
+        ExtractSignatureCounter(absl::get<cbor::Value>(response),
+                                CborValue(GetAssertionResponse::kAuthData));
+    // A constant zero counter is allowed by the specification.
+    if (counter <= creation_counters[i] && counter != 0) {
+      non_increasing_counters += 1;
+    }
+  }
+
+  // Signatures were verified in the background while the device was busy.
+  const int invalid_signatures =
+      device_tracker_->GetSignatureVerifier()->Join().size();
+
+  absl::Time reset_start = absl::Now();
+  std::string reset_method = ResetDevice();
+  absl::Duration reset_latency = absl::Now() - reset_start;
+
+  const int capacity = credential_ids.size();
+  if (cycle == 0) {
+    first_write_mean_ = make_credential_latencies.Mean();
+    first_read_mean_ = get_assertion_latencies.Mean();
+    first_capacity_ = capacity;
+  }
+  if (fill_status != Status::kErrNone &&
+      fill_status != Status::kErrKeyStoreFull) {
+    warnings.push_back(absl::StrCat("Filling the key store failed with `",
+                                    StatusToString(fill_status), "`."));
+  }
+  if (capacity != first_capacity_) {
+    warnings.push_back(absl::StrCat("The store held ", capacity,
+                                    " credentials, the first cycle held ",
+                                    first_capacity_, "."));
+  }
+  if (make_credential_latencies.SlowdownRatio() > options_.slowdown_threshold) {
+    warnings.push_back(absl::StrCat(
+        "MakeCredential got slower by a factor of ",
+        make_credential_latencies.SlowdownRatio(),
+        " while filling the store."));
+  }
+  if (IsSlowerThan(make_credential_latencies.Mean(), first_write_mean_,
+                   options_.slowdown_threshold)) {
+    warnings.push_back(
+        "MakeCredential is slower on average than in the first cycle.");
+  }
+  if (IsSlowerThan(get_assertion_latencies.Mean(), first_read_mean_,
+                   options_.slowdown_threshold)) {
+    warnings.push_back(
+        "GetAssertion is slower on average than in the first cycle.");
+  }
+  if (assertion_failures > 0) {
+    warnings.push_back(absl::StrCat(assertion_failures,
+                                    " stored credentials failed to assert."));
+  }
+  if (non_increasing_counters > 0) {
+    warnings.push_back(absl::StrCat(non_increasing_counters,
+                                    " signature counters did not increase."));
+  }
+  if (invalid_signatures > 0) {
+    warnings.push_back(absl::StrCat(invalid_signatures,
+                                    " signatures did not verify."));
+  }
+  if (duplicate_credential_ids > 0) {
+    warnings.push_back(absl::StrCat(duplicate_credential_ids,
+                                    " credential IDs were seen before."));
+  }
+
+  return {
+      {"cycle", cycle},
+      {"start_time", absl::FormatTime(absl::RFC3339_sec, cycle_start,
+                                      absl::LocalTimeZone())},
+      {"duration_s", absl::ToDoubleSeconds(absl::Now() - cycle_start)},
+      {"credentials_created", capacity},
+      {"fill_status", StatusToString(fill_status)},
+      {"make_credential", make_credential_latencies.ToJson()},
+      {"get_assertion", get_assertion_latencies.ToJson()},
+      {"assertion_failures", assertion_failures},
+      {"non_increasing_counters", non_increasing_counters},
+      {"invalid_signatures", invalid_signatures},
+      {"duplicate_credential_ids", duplicate_credential_ids},
+      {"counter_findings",
+       device_tracker_->GetCounterChecker()->ReportFindings()},
+      {"reset", reset_method},
+      {"reset_ms", absl::ToDoubleMilliseconds(reset_latency)},
+      {"warnings", warnings},
+  };
+}
+
+std::string EnduranceRunner::ResetDevice() {
+  if (!options_.replug_for_reset) {
+    // Some authenticators only allow resets shortly after power up, so a
+    // failure falls back to the replug prompt.
+    if (command_state_->AttemptReset() == Status::kErrNone) {
+      return "direct";
+    }
+  }
+  command_state_->Reset();
+  return "replug";
+}
+
+}  // namespace fido2_tests
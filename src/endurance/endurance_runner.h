@@ -0,0 +1,87 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ENDURANCE_ENDURANCE_RUNNER_H_
+#define ENDURANCE_ENDURANCE_RUNNER_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/time/time.h"
+#include "nlohmann/json.hpp"
+#include "src/command_state.h"
+#include "src/device_interface.h"
+#include "src/device_tracker.h"
+#include "src/parameter_check.h"
+
+namespace fido2_tests {
+
+struct EnduranceOptions {
+  // Number of fill-store/GetAssertion-all/Reset cycles.
+  int num_cycles = 10;
+  // Stops filling the store after this many credentials, for authenticators
+  // that never report a full key store. Zero fills until the store is full.
+  int max_credentials = 0;
+  // If true, every Reset is preceded by a replug prompt. Otherwise, the Reset
+  // command is attempted directly, and only prompts for a replug if the
+  // authenticator refuses.
+  bool replug_for_reset = false;
+  // Writes that are slower than this factor compared to the first cycle, or
+  // within a cycle, are reported as possible flash wear.
+  double slowdown_threshold = 1.5;
+};
+
+// Repeatedly fills the credential store of an authenticator, asserts each
+// stored credential and resets, to qualify the device for long term use.
+// Every cycle is appended as one JSON line to a time series file as soon as it
+// finishes, so that aborted runs keep all data until the failure. Results are
+// not stored in the DeviceTracker's test list, which would grow with the
+// number of cycles. Counter and key checks use the tracker's CounterChecker and
+// KeyChecker, and internal failures terminate the program like in the
+// conformance tests.
+class EnduranceRunner {
+ public:
+  // Opens the time series file in append mode, so multiple runs on the same
+  // device form one series. The results directory is created if necessary.
+  EnduranceRunner(DeviceInterface* device, DeviceTracker* device_tracker,
+                  CommandState* command_state, const EnduranceOptions& options,
+                  std::string_view results_dir = "endurance_results/");
+  // Executes all cycles and prints a summary. Returns the number of cycles that
+  // showed at least one warning.
+  int Run();
+
+ private:
+  // Executes a single cycle and returns its record for the time series.
+  nlohmann::json RunCycle(int cycle);
+  // Resets the authenticator as configured, and returns how it happened.
+  std::string ResetDevice();
+
+  DeviceInterface* device_;
+  DeviceTracker* device_tracker_;
+  CommandState* command_state_;
+  EnduranceOptions options_;
+  std::ofstream series_file_;
+  // Baseline values from the first cycle, to detect drift.
+  absl::Duration first_write_mean_ = absl::ZeroDuration();
+  absl::Duration first_read_mean_ = absl::ZeroDuration();
+  int first_capacity_ = 0;
+  // Credential IDs are expected to be unique across all cycles.
+  absl::flat_hash_set<std::vector<uint8_t>, ByteVectorHash> credential_ids_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // ENDURANCE_ENDURANCE_RUNNER_H_
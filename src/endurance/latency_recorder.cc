@@ -0,0 +1,92 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/endurance/latency_recorder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fido2_tests {
+namespace {
+// Fewer samples make the comparison of first and last tenth meaningless.
+constexpr size_t kMinSamplesForSlowdown = 10;
+
+absl::Duration MeanOfRange(std::vector<absl::Duration>::const_iterator begin,
+                           std::vector<absl::Duration>::const_iterator end) {
+  if (begin == end) {
+    return absl::ZeroDuration();
+  }
+  absl::Duration sum = absl::ZeroDuration();
+  for (auto iter = begin; iter != end; ++iter) {
+    sum += *iter;
+  }
+  return sum / (end - begin);
+}
+}  // namespace
+
+void LatencyRecorder::Record(absl::Duration latency) {
+  latencies_.push_back(latency);
+}
+
+size_t LatencyRecorder::Count() const { return latencies_.size(); }
+
+absl::Duration LatencyRecorder::Mean() const {
+  return MeanOfRange(latencies_.begin(), latencies_.end());
+}
+
+absl::Duration LatencyRecorder::Max() const {
+  if (latencies_.empty()) {
+    return absl::ZeroDuration();
+  }
+  return *std::max_element(latencies_.begin(), latencies_.end());
+}
+
+absl::Duration LatencyRecorder::Percentile(double percentile) const {
+  if (latencies_.empty()) {
+    return absl::ZeroDuration();
+  }
+  std::vector<absl::Duration> sorted_latencies = latencies_;
+  std::sort(sorted_latencies.begin(), sorted_latencies.end());
+  double rank = std::ceil(percentile / 100.0 * sorted_latencies.size());
+  size_t index = rank < 1.0 ? 0 : static_cast<size_t>(rank) - 1;
+  return sorted_latencies[std::min(index, sorted_latencies.size() - 1)];
+}
+
+double LatencyRecorder::SlowdownRatio() const {
+  if (latencies_.size() < kMinSamplesForSlowdown) {
+    return 1.0;
+  }
+  const size_t tenth = latencies_.size() / 10;
+  absl::Duration first_mean =
+      MeanOfRange(latencies_.begin(), latencies_.begin() + tenth);
+  absl::Duration last_mean =
+      MeanOfRange(latencies_.end() - tenth, latencies_.end());
+  if (first_mean == absl::ZeroDuration()) {
+    return 1.0;
+  }
+  return absl::FDivDuration(last_mean, first_mean);
+}
+
+nlohmann::json LatencyRecorder::ToJson() const {
+  return {
+      {"count", Count()},
+      {"mean_ms", absl::ToDoubleMilliseconds(Mean())},
+      {"median_ms", absl::ToDoubleMilliseconds(Percentile(50))},
+      {"p99_ms", absl::ToDoubleMilliseconds(Percentile(99))},
+      {"max_ms", absl::ToDoubleMilliseconds(Max())},
+      {"slowdown_ratio", SlowdownRatio()},
+  };
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,54 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ENDURANCE_LATENCY_RECORDER_H_
+#define ENDURANCE_LATENCY_RECORDER_H_
+
+#include <vector>
+
+#include "absl/time/time.h"
+#include "nlohmann/json.hpp"
+
+namespace fido2_tests {
+
+// Collects the durations of repeated operations of the same kind and
+// summarizes them. Samples are kept in order of recording, so that trends
+// within a series, like slowing flash writes, are visible.
+class LatencyRecorder {
+ public:
+  // Appends a sample.
+  void Record(absl::Duration latency);
+  // Returns the number of recorded samples.
+  size_t Count() const;
+  // Returns the average of all samples, or zero if there are none.
+  absl::Duration Mean() const;
+  // Returns the largest sample, or zero if there are none.
+  absl::Duration Max() const;
+  // Returns the sample at the given percentile in [0, 100], using the nearest
+  // rank method. Returns zero if there are no samples.
+  absl::Duration Percentile(double percentile) const;
+  // Compares the mean of the last tenth of all samples to the mean of the
+  // first tenth. Values above 1 indicate that the operation got slower over
+  // time. Returns 1 if there are not enough samples for a comparison.
+  double SlowdownRatio() const;
+  // Summarizes all samples in milliseconds.
+  nlohmann::json ToJson() const;
+
+ private:
+  std::vector<absl::Duration> latencies_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // ENDURANCE_LATENCY_RECORDER_H_
@@ -0,0 +1,65 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/endurance/latency_recorder.h"
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+TEST(LatencyRecorder, TestEmpty) {
+  LatencyRecorder recorder;
+  EXPECT_EQ(recorder.Count(), 0u);
+  EXPECT_EQ(recorder.Mean(), absl::ZeroDuration());
+  EXPECT_EQ(recorder.Max(), absl::ZeroDuration());
+  EXPECT_EQ(recorder.Percentile(50), absl::ZeroDuration());
+  EXPECT_EQ(recorder.SlowdownRatio(), 1.0);
+}
+
+TEST(LatencyRecorder, TestSummary) {
+  LatencyRecorder recorder;
+  for (int i = 1; i <= 4; ++i) {
+    recorder.Record(absl::Milliseconds(10 * i));
+  }
+  EXPECT_EQ(recorder.Count(), 4u);
+  EXPECT_EQ(recorder.Mean(), absl::Milliseconds(25));
+  EXPECT_EQ(recorder.Max(), absl::Milliseconds(40));
+  EXPECT_EQ(recorder.Percentile(0), absl::Milliseconds(10));
+  EXPECT_EQ(recorder.Percentile(50), absl::Milliseconds(20));
+  EXPECT_EQ(recorder.Percentile(100), absl::Milliseconds(40));
+}
+
+TEST(LatencyRecorder, TestSlowdownRatio) {
+  LatencyRecorder constant_recorder;
+  LatencyRecorder slowing_recorder;
+  for (int i = 0; i < 20; ++i) {
+    constant_recorder.Record(absl::Milliseconds(10));
+    slowing_recorder.Record(absl::Milliseconds(i < 10 ? 10 : 30));
+  }
+  EXPECT_EQ(constant_recorder.SlowdownRatio(), 1.0);
+  EXPECT_EQ(slowing_recorder.SlowdownRatio(), 3.0);
+}
+
+TEST(LatencyRecorder, TestToJson) {
+  LatencyRecorder recorder;
+  recorder.Record(absl::Milliseconds(5));
+  nlohmann::json summary = recorder.ToJson();
+  EXPECT_EQ(summary["count"], 1);
+  EXPECT_EQ(summary["mean_ms"], 5.0);
+  EXPECT_EQ(summary["max_ms"], 5.0);
+}
+
+}  // namespace
+}  // namespace fido2_tests
@@ -0,0 +1,108 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "src/command_state.h"
+#include "src/constants.h"
+#include "src/device_tracker.h"
+#include "src/endurance/endurance_runner.h"
+#include "src/hid/hid_device.h"
+
+static bool ValidatePositive(const char* flagname, gflags::int32 value) {
+  return value > 0;
+}
+
+static bool ValidateNonNegative(const char* flagname, gflags::int32 value) {
+  return value >= 0;
+}
+
+static bool ValidateThreshold(const char* flagname, double value) {
+  return value > 1.0;
+}
+
+DEFINE_string(
+    token_path, "",
+    "The path to the device on your operating system, usually /dev/hidraw*.");
+
+DEFINE_int32(cycles, 10, "Number of fill-store/assert/reset cycles.");
+
+DEFINE_int32(max_credentials, 0,
+             "Upper bound for credentials created in a single cycle, 0 fills "
+             "the store until it is full.");
+
+DEFINE_bool(replug_for_reset, false,
+            "Prompt for a replug before every Reset instead of trying it "
+            "directly first.");
+
+DEFINE_double(slowdown_threshold, 1.5,
+              "Factor by which operations may slow down before a warning.");
+
+DEFINE_string(results_dir, "endurance_results/",
+              "The directory for the time series file.");
+
+DEFINE_bool(verbose, false, "Printing debug logs, i.e. transmitted packets.");
+
+DEFINE_validator(cycles, &ValidatePositive);
+DEFINE_validator(max_credentials, &ValidateNonNegative);
+DEFINE_validator(slowdown_threshold, &ValidateThreshold);
+
+// Repeatedly fills the credential store, asserts all credentials and resets the
+// device. Each cycle is appended to a time series file.
+// Usage example:
+//   ./endurance_test --token_path=/dev/hidraw4 --cycles=100
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_token_path.empty()) {
+    std::cout << "Please add the --token_path flag for one of these devices:"
+              << std::endl;
+    fido2_tests::hid::PrintFidoDevices();
+    return 0;
+  }
+  if (FLAGS_token_path == "_") {
+    // This magic value is used by the run script for comfort.
+    FLAGS_token_path = fido2_tests::hid::FindFirstFidoDevicePath();
+    std::cout << "Testing device at path: " << FLAGS_token_path << std::endl;
+  }
+
+  fido2_tests::DeviceTracker tracker;
+  std::unique_ptr<fido2_tests::DeviceInterface> device =
+      std::make_unique<fido2_tests::hid::HidDevice>(&tracker, FLAGS_token_path,
+                                                    FLAGS_verbose);
+  CHECK(fido2_tests::Status::kErrNone == device->Init())
+      << "CTAPHID initialization failed";
+  device->Wink();
+  std::cout << "This tool will irreversibly delete all credentials on your "
+               "device. If one of your plugged security keys stores anything "
+               "important, unplug it now before continuing."
+            << std::endl;
+
+  // Resets and initializes.
+  fido2_tests::CommandState command_state(device.get(), &tracker);
+  tracker.AssertCondition(tracker.HasOption("rk"),
+                          "Resident key support expected.");
+
+  fido2_tests::EnduranceOptions options = {
+      .num_cycles = FLAGS_cycles,
+      .max_credentials = FLAGS_max_credentials,
+      .replug_for_reset = FLAGS_replug_for_reset,
+      .slowdown_threshold = FLAGS_slowdown_threshold,
+  };
+  fido2_tests::EnduranceRunner runner(device.get(), &tracker, &command_state,
+                                      options, FLAGS_results_dir);
+  return runner.Run() == 0 ? 0 : 1;
+}
@@ -16,15 +16,18 @@
 
 #include <cstdint>
 #include <iostream>
+#include <optional>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "glog/logging.h"
+#include "src/cbor_view.h"
 #include "src/constants.h"
 #include "src/crypto_utility.h"
 #include "src/parameter_check.h"
+#include "src/request_template.h"
 #include "third_party/chromium_components_cbor/reader.h"
-#include "third_party/chromium_components_cbor/writer.h"
 
 namespace fido2_tests {
 namespace fido2_commands {
@@ -32,12 +35,14 @@ namespace fido2_commands {
 using ByteVector = std::vector<uint8_t>;
 
 namespace {
-void CheckExtensions(const ByteVector& extension_data) {
+void CheckExtensions(absl::Span<const uint8_t> extension_data) {
   if (extension_data.empty()) {
     return;
   }
-  absl::optional<cbor::Value> extensions = cbor::Reader::Read(extension_data);
-  CHECK(extensions.has_value()) << "CBOR decoding of extensions failed";
+  std::optional<CborView> extensions = CborView::Parse(extension_data);
+  CHECK(extensions.has_value() &&
+        extensions->GetEncoded().size() == extension_data.size())
+      << "CBOR decoding of extensions failed";
   CHECK(extensions->is_map()) << "extensions response is not a map";
 }
 
@@ -48,32 +53,29 @@ bool IsKeyInRequest(const cbor::Value& request, int map_key) {
 }
 
 size_t PubKeyDuplicateCheck(KeyChecker* key_checker,
-                            const ByteVector& pub_key_cose) {
-  size_t num_bytes_consumed;
-  absl::optional<cbor::Value> decoded_pub_key =
-      cbor::Reader::Read(pub_key_cose, &num_bytes_consumed);
-  CHECK(decoded_pub_key.has_value()) << "CBOR decoding of public key failed";
-  CHECK(decoded_pub_key->is_map()) << "CBOR response is not a map";
-  const auto& pub_key_map = decoded_pub_key->GetMap();
-
-  auto iter = pub_key_map.find(cbor::Value(3));
-  CHECK(iter != pub_key_map.end())
+                            absl::Span<const uint8_t> pub_key_cose) {
+  std::optional<CborView> pub_key = CborView::Parse(pub_key_cose);
+  CHECK(pub_key.has_value()) << "CBOR decoding of public key failed";
+  CHECK(pub_key->is_map()) << "CBOR response is not a map";
+
+  std::optional<CborView> alg_entry = pub_key->Find(3);
+  CHECK(alg_entry.has_value())
       << "no attStmt (key 3) in MakeCredential response";
-  CHECK(iter->second.is_integer()) << "alg in public key map is not an integer";
-  int64_t alg = iter->second.GetInteger();
+  CHECK(alg_entry->is_integer()) << "alg in public key map is not an integer";
+  int64_t alg = alg_entry->GetInteger();
 
   switch (alg) {
     case static_cast<int>(Algorithm::kEs256Algorithm): {
-      iter = pub_key_map.find(cbor::Value(-2));
-      CHECK(iter != pub_key_map.end()) << "key -2 not found in public key map";
-      CHECK(iter->second.is_bytestring())
+      std::optional<CborView> x_entry = pub_key->Find(-2);
+      CHECK(x_entry.has_value()) << "key -2 not found in public key map";
+      CHECK(x_entry->is_bytestring())
           << "x coordinate entry is not a bytestring";
-      ByteVector x = iter->second.GetBytestring();
-      iter = pub_key_map.find(cbor::Value(-3));
-      CHECK(iter != pub_key_map.end()) << "key -3 not found in public key map";
-      CHECK(iter->second.is_bytestring())
+      absl::Span<const uint8_t> x = x_entry->GetBytestring();
+      std::optional<CborView> y_entry = pub_key->Find(-3);
+      CHECK(y_entry.has_value()) << "key -3 not found in public key map";
+      CHECK(y_entry->is_bytestring())
           << "y coordinate entry is not a bytestring";
-      ByteVector y = iter->second.GetBytestring();
+      absl::Span<const uint8_t> y = y_entry->GetBytestring();
       ByteVector concat;
       concat.reserve(x.size() + y.size());
       concat.insert(concat.end(), x.begin(), x.end());
@@ -82,12 +84,11 @@ size_t PubKeyDuplicateCheck(KeyChecker* key_checker,
       break;
     }
     case static_cast<int>(Algorithm::kRs256Algorithm): {
-      iter = pub_key_map.find(cbor::Value(-1));
-      CHECK(iter != pub_key_map.end()) << "key -1 not found in public key map";
-      CHECK(iter->second.is_bytestring())
-          << "the public key is not a bytestring";
-      ByteVector n = iter->second.GetBytestring();
-      key_checker->CheckKey(n);
+      std::optional<CborView> n_entry = pub_key->Find(-1);
+      CHECK(n_entry.has_value()) << "key -1 not found in public key map";
+      CHECK(n_entry->is_bytestring()) << "the public key is not a bytestring";
+      absl::Span<const uint8_t> n = n_entry->GetBytestring();
+      key_checker->CheckKey(ByteVector(n.begin(), n.end()));
       break;
     }
     default: {
@@ -96,7 +97,7 @@ size_t PubKeyDuplicateCheck(KeyChecker* key_checker,
                    << " in public key map did not match anything implemented";
     }
   }
-  return num_bytes_consumed;
+  return pub_key->GetEncoded().size();
 }
 
 std::string ExtractRpIdFromMakeCredentialRequest(const cbor::Value& request) {
@@ -164,6 +165,26 @@ cbor::Value::BinaryValue ExtractUniqueCredentialFromAllowList(
   return desc_iter->second.GetBytestring();
 }
 
+// Returns the concatenation of authenticator data and client data hash, which
+// attestation and assertion signatures sign.
+ByteVector BuildSignedData(const cbor::Value& request, int client_data_hash_key,
+                           const ByteVector& auth_data) {
+  CHECK(request.is_map()) << "request is not a map - TEST SUITE BUG";
+  const auto& request_map = request.GetMap();
+  auto req_iter = request_map.find(cbor::Value(client_data_hash_key));
+  CHECK(req_iter != request_map.end())
+      << "client data hash not in request - TEST SUITE BUG";
+  CHECK(req_iter->second.is_bytestring())
+      << "client data hash is not a bytestring - TEST SUITE BUG";
+  const ByteVector& client_data_hash = req_iter->second.GetBytestring();
+  ByteVector signed_data;
+  signed_data.reserve(auth_data.size() + client_data_hash.size());
+  signed_data.insert(signed_data.end(), auth_data.begin(), auth_data.end());
+  signed_data.insert(signed_data.end(), client_data_hash.begin(),
+                     client_data_hash.end());
+  return signed_data;
+}
+
 // Default is true.
 bool ExtractUpOptionFromGetAssertionRequest(const cbor::Value& request) {
   CHECK(request.is_map()) << "request is not a map - TEST SUITE BUG";
@@ -183,21 +204,11 @@ bool ExtractUpOptionFromGetAssertionRequest(const cbor::Value& request) {
       << "option \"up\" is not a boolean - TEST SUITE BUG";
   return options_iter->second.GetBool();
 }
-}  // namespace
-
-absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
-    DeviceInterface* device, DeviceTracker* device_tracker,
-    const cbor::Value& request) {
-  auto encoded_request = cbor::Writer::Write(request);
-  CHECK(encoded_request.has_value()) << "encoding went wrong - TEST SUITE BUG";
-
-  ByteVector response_cbor;
-  Status status = device->ExchangeCbor(Command::kAuthenticatorMakeCredential,
-                                       *encoded_request, true, &response_cbor);
-  if (status != Status::kErrNone) {
-    return status;
-  }
 
+// Validates a successful response against the request.
+absl::variant<cbor::Value, Status> CheckMakeCredentialResponse(
+    DeviceTracker* device_tracker, const cbor::Value& request,
+    const ByteVector& response_cbor) {
   absl::optional<cbor::Value> decoded_response =
       cbor::Reader::Read(response_cbor);
   CHECK(decoded_response.has_value()) << "CBOR decoding failed";
@@ -215,7 +226,7 @@ absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
       << "no authData (key 2) in MakeCredential response";
   CHECK(map_iter->second.is_bytestring())
       << "authData entry is not a bytestring";
-  cbor::Value::BinaryValue auth_data = map_iter->second.GetBytestring();
+  const cbor::Value::BinaryValue& auth_data = map_iter->second.GetBytestring();
   CHECK_GE(auth_data.size(), 32u)
       << "authData is too small to fit the relying party ID hash";
   ByteVector expected_rp_id_hash =
@@ -253,17 +264,18 @@ absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
   device_tracker->GetCounterChecker()->RegisterCounter(credential_id,
                                                        signature_counter);
 
-  // This ByteVector can have extraneous data for extensions.
-  ByteVector cose_key(
-      auth_data.begin() + length_offset + 2 + credential_id_length,
-      auth_data.end());
+  // This view can have extraneous data for extensions.
+  absl::Span<const uint8_t> cose_key = absl::MakeConstSpan(auth_data).subspan(
+      length_offset + 2 + credential_id_length);
   size_t cose_key_size =
       PubKeyDuplicateCheck(device_tracker->GetKeyChecker(), cose_key);
+  absl::Span<const uint8_t> credential_key = cose_key.first(cose_key_size);
+  device_tracker->GetSignatureVerifier()->RegisterCredential(
+      credential_id, ByteVector(credential_key.begin(), credential_key.end()));
   bool has_extension_flag = flags & 0x80;
   CHECK(has_extension_flag == (cose_key_size < cose_key.size()))
       << "extension flag not matching response";
-  ByteVector extension_data(cose_key.begin() + cose_key_size, cose_key.end());
-  CheckExtensions(extension_data);
+  CheckExtensions(cose_key.subspan(cose_key_size));
 
   map_iter = decoded_map.find(CborValue(MakeCredentialResponse::kAttStmt));
   CHECK(map_iter != decoded_map.end())
@@ -289,11 +301,33 @@ absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
         << "attStmt for fmt \"packed\" does not contain key \"sig\"";
     CHECK(inner_iter->second.is_bytestring())
         << "\"sig\" in attStmt for fmt \"packed\" is not a bytestring";
+    const cbor::Value::BinaryValue& signature =
+        inner_iter->second.GetBytestring();
     if (alg == static_cast<int>(Algorithm::kEs256Algorithm)) {
       device_tracker->GetKeyChecker()->CheckKey(
-          crypto_utility::ExtractEcdsaSignatureR(
-              inner_iter->second.GetBytestring()));
+          crypto_utility::ExtractEcdsaSignatureR(signature));
     }
+
+    // Without a certificate chain, this is a self attestation.
+    std::optional<ByteVector> certificate;
+    inner_iter = att_stmt.find(cbor::Value("x5c"));
+    if (inner_iter != att_stmt.end()) {
+      CHECK(inner_iter->second.is_array() &&
+            !inner_iter->second.GetArray().empty())
+          << "\"x5c\" in attStmt for fmt \"packed\" is not a non-empty array";
+      const cbor::Value& attestation_certificate =
+          inner_iter->second.GetArray()[0];
+      CHECK(attestation_certificate.is_bytestring())
+          << "certificate in \"x5c\" is not a bytestring";
+      certificate = attestation_certificate.GetBytestring();
+    }
+    device_tracker->GetSignatureVerifier()->VerifyAttestation(
+        credential_id, alg, std::move(certificate),
+        BuildSignedData(
+            request,
+            static_cast<int>(MakeCredentialParameters::kClientDataHash),
+            auth_data),
+        signature);
   }
 
   for (const auto& map_entry : decoded_map) {
@@ -312,21 +346,11 @@ absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
   return decoded_response->Clone();
 }
 
-absl::variant<cbor::Value, Status> GetAssertionPositiveTest(
-    DeviceInterface* device, DeviceTracker* device_tracker,
-    const cbor::Value& request) {
-  auto encoded_request = cbor::Writer::Write(request);
-  CHECK(encoded_request.has_value()) << "encoding went wrong - TEST SUITE BUG";
-
+// Validates a successful response against the request.
+absl::variant<cbor::Value, Status> CheckGetAssertionResponse(
+    DeviceTracker* device_tracker, const cbor::Value& request,
+    const ByteVector& resp_cbor) {
   bool requires_up = ExtractUpOptionFromGetAssertionRequest(request);
-  ByteVector resp_cbor;
-  Status status =
-      device->ExchangeCbor(Command::kAuthenticatorGetAssertion,
-                           *encoded_request, requires_up, &resp_cbor);
-  if (status != Status::kErrNone) {
-    return status;
-  }
-
   absl::optional<cbor::Value> decoded_response = cbor::Reader::Read(resp_cbor);
   CHECK(decoded_response.has_value()) << "CBOR decoding failed";
   CHECK(decoded_response->is_map()) << "CBOR response is not a map";
@@ -356,7 +380,7 @@ absl::variant<cbor::Value, Status> GetAssertionPositiveTest(
       << "no authData (key 2) in GetAssertion response";
   CHECK(map_iter->second.is_bytestring())
       << "authData entry is not a bytestring";
-  cbor::Value::BinaryValue auth_data = map_iter->second.GetBytestring();
+  const cbor::Value::BinaryValue& auth_data = map_iter->second.GetBytestring();
   CHECK_GE(auth_data.size(), 32u)
       << "authData is too small to fit the relying party ID hash";
   ByteVector expected_rp_id_hash =
@@ -386,15 +410,19 @@ absl::variant<cbor::Value, Status> GetAssertionPositiveTest(
   bool has_extension_flag = flags & 0x80;
   CHECK(has_extension_flag == (extension_data_size > 0))
       << "extension flag not matching response";
-  ByteVector extension_data(auth_data.begin() + 37, auth_data.end());
-  CheckExtensions(extension_data);
+  CheckExtensions(absl::MakeConstSpan(auth_data).subspan(37));
 
   map_iter = decoded_map.find(CborValue(GetAssertionResponse::kSignature));
   CHECK(map_iter != decoded_map.end())
       << "no signature (key 3) in GetAssertion response";
   CHECK(map_iter->second.is_bytestring())
       << "signature entry is not a bytestring";
-  auto printed_sig = map_iter->second.GetBytestring();
+  device_tracker->GetSignatureVerifier()->VerifyAssertion(
+      credential_id,
+      BuildSignedData(
+          request, static_cast<int>(GetAssertionParameters::kClientDataHash),
+          auth_data),
+      map_iter->second.GetBytestring());
   // Since we don't send random challenges, what about deterministic signatures?
   // key_checker->CheckKey(
   // crypto_utility::ExtractEcdsaSignatureR(map_iter->second.GetBytestring()));
@@ -454,6 +482,62 @@ absl::variant<cbor::Value, Status> GetAssertionPositiveTest(
 
   return decoded_response->Clone();
 }
+}  // namespace
+
+absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    const cbor::Value& request) {
+  ByteVector response_cbor;
+  Status status = device->ExchangeCborRequest(
+      Command::kAuthenticatorMakeCredential, request, true, &response_cbor);
+  if (status != Status::kErrNone) {
+    return status;
+  }
+  return CheckMakeCredentialResponse(device_tracker, request, response_cbor);
+}
+
+absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    const RequestTemplate& request_template) {
+  ByteVector response_cbor;
+  Status status = device->ExchangeCbor(Command::kAuthenticatorMakeCredential,
+                                       request_template.GetEncoded(), true,
+                                       &response_cbor);
+  if (status != Status::kErrNone) {
+    return status;
+  }
+  return CheckMakeCredentialResponse(
+      device_tracker, request_template.GetRequest(), response_cbor);
+}
+
+absl::variant<cbor::Value, Status> GetAssertionPositiveTest(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    const cbor::Value& request) {
+  bool requires_up = ExtractUpOptionFromGetAssertionRequest(request);
+  ByteVector resp_cbor;
+  Status status = device->ExchangeCborRequest(
+      Command::kAuthenticatorGetAssertion, request, requires_up, &resp_cbor);
+  if (status != Status::kErrNone) {
+    return status;
+  }
+  return CheckGetAssertionResponse(device_tracker, request, resp_cbor);
+}
+
+absl::variant<cbor::Value, Status> GetAssertionPositiveTest(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    const RequestTemplate& request_template) {
+  const cbor::Value& request = request_template.GetRequest();
+  bool requires_up = ExtractUpOptionFromGetAssertionRequest(request);
+  ByteVector resp_cbor;
+  Status status =
+      device->ExchangeCbor(Command::kAuthenticatorGetAssertion,
+                           request_template.GetEncoded(), requires_up,
+                           &resp_cbor);
+  if (status != Status::kErrNone) {
+    return status;
+  }
+  return CheckGetAssertionResponse(device_tracker, request, resp_cbor);
+}
 
 absl::variant<cbor::Value, Status> GetNextAssertionPositiveTest(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -689,12 +773,9 @@ absl::variant<cbor::Value, Status> GetInfoPositiveTest(
 absl::variant<cbor::Value, Status> AuthenticatorClientPinPositiveTest(
     DeviceInterface* device, DeviceTracker* device_tracker,
     const cbor::Value& request) {
-  auto encoded_request = cbor::Writer::Write(request);
-  CHECK(encoded_request.has_value()) << "encoding went wrong - TEST SUITE BUG";
-
   ByteVector resp_cbor;
-  Status status = device->ExchangeCbor(Command::kAuthenticatorClientPIN,
-                                       *encoded_request, false, &resp_cbor);
+  Status status = device->ExchangeCborRequest(Command::kAuthenticatorClientPIN,
+                                              request, false, &resp_cbor);
   if (status != Status::kErrNone) {
     return status;
   }
@@ -866,14 +947,20 @@ Status ResetNegativeTest(DeviceInterface* device, const cbor::Value& request,
 
 Status GenericNegativeTest(DeviceInterface* device, const cbor::Value& request,
                            Command command, bool expect_up_check) {
-  ByteVector req_cbor;
-  if (!request.is_none()) {
-    auto encoded_request = cbor::Writer::Write(request);
-    CHECK(encoded_request.has_value())
-        << "encoding went wrong - TEST SUITE BUG";
-    req_cbor = encoded_request.value();
+  // An absent request is sent as an empty payload.
+  if (request.is_none()) {
+    return NonCborNegativeTest(device, ByteVector(), command, expect_up_check);
   }
-  return NonCborNegativeTest(device, req_cbor, command, expect_up_check);
+  ByteVector resp_cbor;
+  return device->ExchangeCborRequest(command, request, expect_up_check,
+                                     &resp_cbor);
+}
+
+Status GenericNegativeTest(DeviceInterface* device,
+                           const RequestTemplate& request_template,
+                           Command command, bool expect_up_check) {
+  return NonCborNegativeTest(device, request_template.GetEncoded(), command,
+                             expect_up_check);
 }
 
 Status NonCborNegativeTest(DeviceInterface* device,
@@ -20,6 +20,7 @@
 #include "absl/types/variant.h"
 #include "src/device_interface.h"
 #include "src/device_tracker.h"
+#include "src/request_template.h"
 #include "third_party/chromium_components_cbor/values.h"
 
 namespace fido2_tests {
@@ -34,6 +35,14 @@ absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
 absl::variant<cbor::Value, Status> GetAssertionPositiveTest(
     DeviceInterface* device, DeviceTracker* device_tracker,
     const cbor::Value& request);
+// As above, but sends the encoded request of the template. The template's
+// patched request is used to validate the response.
+absl::variant<cbor::Value, Status> MakeCredentialPositiveTest(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    const RequestTemplate& request_template);
+absl::variant<cbor::Value, Status> GetAssertionPositiveTest(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    const RequestTemplate& request_template);
 absl::variant<cbor::Value, Status> GetNextAssertionPositiveTest(
     DeviceInterface* device, DeviceTracker* device_tracker,
     const cbor::Value& request);
@@ -69,6 +78,11 @@ Status ResetNegativeTest(DeviceInterface* device, const cbor::Value& request,
 // code reuse.
 Status GenericNegativeTest(DeviceInterface* device, const cbor::Value& request,
                            Command command, bool expect_up_check);
+// As above, but sends the encoded request of the template without encoding
+// anything. Use this for requests that are sent repeatedly.
+Status GenericNegativeTest(DeviceInterface* device,
+                           const RequestTemplate& request_template,
+                           Command command, bool expect_up_check);
 
 // Sends an arbitrary byte vector to the device and expects it to fail. This
 // test is useful to try invalid CBOR.
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdlib>
 #include <iostream>
 
 #include "gflags/gflags.h"
@@ -21,7 +22,10 @@
 #include "src/device_tracker.h"
 #include "src/hid/hid_device.h"
 #include "src/parameter_check.h"
+#include "src/replay/recording_device.h"
+#include "src/replay/replay_device.h"
 #include "src/tests/base.h"
+#include "src/tests/result_cache.h"
 #include "src/tests/test_series.h"
 
 DEFINE_string(
@@ -30,32 +34,77 @@ DEFINE_string(
 
 DEFINE_bool(verbose, false, "Printing debug logs, i.e. transmitted packets.");
 
+DEFINE_bool(hidraw, false,
+            "Talks to /dev/hidraw* directly instead of through hidapi. Only "
+            "works on Linux.");
+
+DEFINE_bool(stream_results, false,
+            "Write observations and tests to a JSON Lines file as they "
+            "happen, instead of keeping them in memory until the end.");
+
+DEFINE_string(record_trace, "",
+              "Records all device calls into a trace file at this path.");
+
+DEFINE_string(replay_trace, "",
+              "Replays the trace file at this path instead of talking to a "
+              "device. Ignores --token_path.");
+
+DEFINE_bool(replay_original_timing, false,
+            "When replaying, waits as long as the recorded device did.");
+
+DEFINE_bool(incremental, false,
+            "Only run tests that failed, changed or never ran on this "
+            "firmware version, and reuse cached passes for all others.");
+
 // Calling this function first connects to the device and then executes all test
 // series listed.
 //
 // Usage example:
 //   ./fido2_conformance --token_path=/dev/hidraw4 --verbose
+//   ./fido2_conformance --token_path=_ --record_trace=run.trace
+//   ./fido2_conformance --replay_trace=run.trace
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-  if (FLAGS_token_path.empty()) {
-    std::cout << "Please add the --token_path flag for one of these devices:"
-              << std::endl;
-    fido2_tests::hid::PrintFidoDevices();
-    return 0;
-  }
+  fido2_tests::DeviceTracker tracker;
+  std::unique_ptr<fido2_tests::DeviceInterface> device;
+  fido2_tests::ReplayDevice* replay_device = nullptr;
+  if (!FLAGS_replay_trace.empty()) {
+    auto trace_device = std::make_unique<fido2_tests::ReplayDevice>(
+        &tracker, fido2_tests::ReadTrace(FLAGS_replay_trace),
+        FLAGS_replay_original_timing
+            ? fido2_tests::ReplayTiming::kOriginalTiming
+            : fido2_tests::ReplayTiming::kFullSpeed);
+    replay_device = trace_device.get();
+    device = std::move(trace_device);
+  } else {
+    if (FLAGS_token_path.empty()) {
+      std::cout << "Please add the --token_path flag for one of these devices:"
+                << std::endl;
+      fido2_tests::hid::PrintFidoDevices();
+      return 0;
+    }
 
-  if (FLAGS_token_path == "_") {
-    // This magic value is used by the run script for comfort.
-    FLAGS_token_path = fido2_tests::hid::FindFirstFidoDevicePath();
-    std::cout << "Tested device path: " << FLAGS_token_path << std::endl;
-  }
+    if (FLAGS_token_path == "_") {
+      // This magic value is used by the run script for comfort.
+      FLAGS_token_path = fido2_tests::hid::FindFirstFidoDevicePath();
+      std::cout << "Tested device path: " << FLAGS_token_path << std::endl;
+    }
 
-  fido2_tests::DeviceTracker tracker;
-  std::unique_ptr<fido2_tests::DeviceInterface> device =
-      std::make_unique<fido2_tests::hid::HidDevice>(&tracker, FLAGS_token_path,
-                                                    FLAGS_verbose);
+    device = std::make_unique<fido2_tests::hid::HidDevice>(
+        &tracker, FLAGS_token_path, FLAGS_verbose,
+        FLAGS_hidraw ? fido2_tests::hid::HidBackend::kHidraw
+                     : fido2_tests::hid::HidBackend::kHidapi);
+    if (!FLAGS_record_trace.empty()) {
+      device = std::make_unique<fido2_tests::RecordingDevice>(
+          std::move(device), FLAGS_record_trace,
+          tracker.GetDeviceIdentifiers());
+    }
+  }
+  if (FLAGS_stream_results) {
+    tracker.StreamResultsTo();
+  }
   CHECK(fido2_tests::Status::kErrNone == device->Init())
       << "CTAPHID initialization failed";
   device->Wink();
@@ -76,12 +125,40 @@ int main(int argc, char** argv) {
   // Setup and run all tests, while tracking their results.
   const std::vector<std::unique_ptr<fido2_tests::BaseTest>>& tests =
       fido2_tests::runners::GetTests();
-  fido2_tests::runners::RunTests(device.get(), &tracker, &command_state, tests);
+  std::unique_ptr<fido2_tests::ResultCache> result_cache;
+  if (FLAGS_incremental) {
+    if (tracker.GetFirmwareVersion().has_value()) {
+      const fido2_tests::DeviceIdentifiers& identifiers =
+          tracker.GetDeviceIdentifiers();
+      const char* workspace_dir = std::getenv("BUILD_WORKSPACE_DIRECTORY");
+      const std::string source_dir = workspace_dir ? workspace_dir : ".";
+      result_cache = std::make_unique<fido2_tests::ResultCache>(
+          source_dir + "/results/cache",
+          fido2_tests::FirmwareIdentity{
+              .aaguid = tracker.GetAaguid(),
+              .firmware_version = tracker.GetFirmwareVersion().value(),
+              .vendor_id = identifiers.vendor_id,
+              .product_id = identifiers.product_id,
+              .product_name = identifiers.product_name},
+          source_dir);
+    } else {
+      std::cout << "The device reports no firmware version, running all tests."
+                << std::endl;
+    }
+  }
+  fido2_tests::runners::RunTests(device.get(), &tracker, &command_state, tests,
+                                 result_cache.get());
   // Reset the device to a clean state.
   command_state.Reset();
 
   std::cout << "\nRESULTS" << std::endl;
   tracker.ReportFindings();
   tracker.SaveResultsToFile();
+  if (replay_device) {
+    std::cout << "Replay sent " << replay_device->GetRequestMismatchCount()
+              << " requests that differ from the trace, "
+              << replay_device->GetRemainingEventCount()
+              << " recorded calls were left." << std::endl;
+  }
 }
 
@@ -0,0 +1,65 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/bandit_scheduler.h"
+
+#include "glog/logging.h"
+
+namespace fido2_tests {
+namespace {
+// Returns a draw from the beta distribution with the given parameters.
+double SampleBeta(double alpha, double beta, std::mt19937* rng) {
+  const double x = std::gamma_distribution<double>(alpha)(*rng);
+  const double y = std::gamma_distribution<double>(beta)(*rng);
+  return x / (x + y);
+}
+}  // namespace
+
+BanditScheduler::BanditScheduler(size_t arm_count, double discount)
+    : arm_stats_(arm_count), discount_(discount) {
+  CHECK(discount > 0.0 && discount <= 1.0)
+      << "discount out of range - TEST SUITE BUG";
+}
+
+size_t BanditScheduler::Sample(std::mt19937* rng) const {
+  CHECK(!arm_stats_.empty()) << "no arms to sample - TEST SUITE BUG";
+  size_t best_arm = 0;
+  double best_draw = -1.0;
+  for (size_t arm = 0; arm < arm_stats_.size(); ++arm) {
+    const ArmStats& stats = arm_stats_[arm];
+    const double draw =
+        SampleBeta(1.0 + stats.successes, 1.0 + stats.failures, rng);
+    if (draw > best_draw) {
+      best_arm = arm;
+      best_draw = draw;
+    }
+  }
+  return best_arm;
+}
+
+void BanditScheduler::RecordResult(size_t arm, bool is_success) {
+  CHECK_LT(arm, arm_stats_.size()) << "unknown arm - TEST SUITE BUG";
+  for (ArmStats& stats : arm_stats_) {
+    stats.successes *= discount_;
+    stats.failures *= discount_;
+  }
+  (is_success ? arm_stats_[arm].successes : arm_stats_[arm].failures) += 1.0;
+}
+
+double BanditScheduler::GetSuccessRate(size_t arm) const {
+  const ArmStats& stats = arm_stats_[arm];
+  return (1.0 + stats.successes) / (2.0 + stats.successes + stats.failures);
+}
+
+}  // namespace fido2_tests
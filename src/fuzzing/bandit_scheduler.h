@@ -0,0 +1,54 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FUZZING_BANDIT_SCHEDULER_H_
+#define FUZZING_BANDIT_SCHEDULER_H_
+
+#include <random>
+#include <vector>
+
+namespace fido2_tests {
+
+// Picks one of several arms, e.g. input types or mutation operators, so that
+// most picks go to the arm that currently finds new device behavior most
+// often. Uses Thompson sampling: each arm's success rate has a beta
+// distribution, and the arm with the highest random draw is picked. Past
+// results are discounted on every update, so that effort moves away from
+// arms that stop finding anything.
+class BanditScheduler {
+ public:
+  // The discount is the weight that every result loses per update, in (0, 1].
+  // A discount of 1 never forgets.
+  explicit BanditScheduler(size_t arm_count, double discount = 0.995);
+  // Returns the arm to play next. Fails if there are no arms.
+  size_t Sample(std::mt19937* rng) const;
+  // Updates the arm's statistics with whether playing it was a success.
+  void RecordResult(size_t arm, bool is_success);
+  // Returns the expected success rate of the arm.
+  double GetSuccessRate(size_t arm) const;
+
+ private:
+  struct ArmStats {
+    // Discounted counts, starting from a uniform prior.
+    double successes = 0.0;
+    double failures = 0.0;
+  };
+
+  std::vector<ArmStats> arm_stats_;
+  double discount_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // FUZZING_BANDIT_SCHEDULER_H_
@@ -0,0 +1,57 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/bandit_scheduler.h"
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+// Plays the bandit for the given rounds, where each arm succeeds with its
+// rate. Returns how often each arm was played.
+std::vector<int> Play(BanditScheduler* scheduler,
+                      const std::vector<double>& success_rates, int rounds,
+                      std::mt19937* rng) {
+  std::vector<int> play_counts(success_rates.size());
+  for (int i = 0; i < rounds; ++i) {
+    const size_t arm = scheduler->Sample(rng);
+    play_counts[arm] += 1;
+    scheduler->RecordResult(
+        arm, std::bernoulli_distribution(success_rates[arm])(*rng));
+  }
+  return play_counts;
+}
+
+TEST(BanditScheduler, TestPrefersSuccessfulArm) {
+  BanditScheduler scheduler(3, /*discount=*/1.0);
+  std::mt19937 rng(0);
+  const std::vector<int> play_counts =
+      Play(&scheduler, {0.05, 0.3, 0.05}, 2000, &rng);
+  EXPECT_GT(play_counts[1], 1600);
+  EXPECT_NEAR(scheduler.GetSuccessRate(1), 0.3, 0.05);
+}
+
+TEST(BanditScheduler, TestFollowsChangingArms) {
+  BanditScheduler scheduler(2);
+  std::mt19937 rng(0);
+  std::vector<int> play_counts = Play(&scheduler, {0.5, 0.0}, 1000, &rng);
+  EXPECT_GT(play_counts[0], 900);
+  // The first arm stops yielding new behavior, the second starts.
+  play_counts = Play(&scheduler, {0.0, 0.5}, 1000, &rng);
+  EXPECT_GT(play_counts[1], 700);
+}
+
+}  // namespace
+}  // namespace fido2_tests
@@ -37,8 +37,17 @@ std::vector<uint8_t> CorpusController::GetFileData(
 
 CorpusController::CorpusController(fuzzing_helpers::InputType input_type,
                                    const std::string_view& base_corpus_path)
-    : corpus_path_(base_corpus_path) {
+    : CorpusController(input_type, base_corpus_path, /*seed=*/0) {}
+
+CorpusController::CorpusController(fuzzing_helpers::InputType input_type,
+                                   const std::string_view& base_corpus_path,
+                                   uint32_t seed)
+    : corpus_path_(base_corpus_path), scheduler_(0), rng_(seed) {
   corpus_path_ /= InputTypeToDirectoryName(input_type);
+  if (!std::filesystem::is_directory(corpus_path_)) {
+    LOG(WARNING) << "Corpus directory not found: " << corpus_path_;
+    return;
+  }
   // Construct corpus metadata and sort by file size, then by file name.
   for (auto& corpus_iter : std::filesystem::directory_iterator(corpus_path_)) {
     std::uintmax_t file_size = std::filesystem::file_size(corpus_iter.path());
@@ -46,8 +55,11 @@ CorpusController::CorpusController(fuzzing_helpers::InputType input_type,
     corpus_metadata_.push_back({file_size, file_name});
   }
   sort(corpus_metadata_.begin(), corpus_metadata_.end());
+  scheduler_ = SeedScheduler(corpus_metadata_.size());
 }
 
+bool CorpusController::IsEmpty() const { return corpus_metadata_.empty(); }
+
 bool CorpusController::HasNextInput() {
   return current_input_index_ < corpus_metadata_.size();
 }
@@ -58,11 +70,16 @@ std::tuple<std::vector<uint8_t>, std::string> CorpusController::GetNextInput() {
   return {GetFileData(input_name), input_name};
 }
 
-std::tuple<std::vector<uint8_t>, std::string>
+std::tuple<std::vector<uint8_t>, std::string, size_t>
 CorpusController::GetRandomInput() {
-  int index = std::rand() % corpus_metadata_.size();
-  return {GetFileData(corpus_metadata_[index].file_name),
-          corpus_metadata_[index].file_name};
+  const size_t input_index = scheduler_.Sample(&rng_);
+  const std::string& input_name = corpus_metadata_[input_index].file_name;
+  return {GetFileData(input_name), input_name, input_index};
+}
+
+bool CorpusController::RecordExecution(size_t input_index,
+                                       const ExecutionFeedback& feedback) {
+  return scheduler_.RecordExecution(input_index, feedback);
 }
 
 }  // namespace fido2_tests
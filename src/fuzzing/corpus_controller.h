@@ -17,10 +17,12 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <random>
 #include <tuple>
 #include <vector>
 
 #include "src/fuzzing/fuzzing_helpers.h"
+#include "src/fuzzing/seed_scheduler.h"
 
 namespace fido2_tests {
 
@@ -37,15 +39,24 @@ class CorpusController {
  public:
   CorpusController(fuzzing_helpers::InputType input_type,
                    const std::string_view& base_corpus_path);
+  // Same as above, with a seed for GetRandomInput.
+  CorpusController(fuzzing_helpers::InputType input_type,
+                   const std::string_view& base_corpus_path, uint32_t seed);
+  // Returns whether the corpus contains no files.
+  bool IsEmpty() const;
   // Returns whether there is a next input file available in an iterative
   // manner.
   bool HasNextInput();
   // Returns the content and the name of the next available input file in an
   // iterative manner.
   std::tuple<std::vector<uint8_t>, std::string> GetNextInput();
-  // Returns the content and the name of a random input file, independently from
-  // the iterative mode.
-  std::tuple<std::vector<uint8_t>, std::string> GetRandomInput();
+  // Returns the content, the name and the index of a random input file,
+  // independently from the iterative mode. Files that caused new responses are
+  // more likely.
+  std::tuple<std::vector<uint8_t>, std::string, size_t> GetRandomInput();
+  // Reports what the device did with the input at the given index. Returns
+  // whether the device showed a new behavior.
+  bool RecordExecution(size_t input_index, const ExecutionFeedback& feedback);
 
  private:
   // Returns the data of the file with the given name.
@@ -64,6 +75,8 @@ class CorpusController {
   // An index in the vector of corpus metadata pointing to the current file
   // under iteration.
   size_t current_input_index_ = 0;
+  SeedScheduler scheduler_;
+  std::mt19937 rng_;
 };
 
 }  // namespace fido2_tests
@@ -1,6 +1,8 @@
 #include "src/fuzzing/fuzzing_helpers.h"
 
+#include "absl/strings/str_cat.h"
 #include "glog/logging.h"
+#include "third_party/chromium_components_cbor/reader.h"
 
 namespace fido2_tests {
 namespace fuzzing_helpers {
@@ -24,24 +26,54 @@ std::string InputTypeToDirectoryName(InputType input_type) {
 }
 
 Status SendInput(DeviceInterface* device, InputType input_type,
-                 std::vector<uint8_t> const& input) {
-  std::vector<uint8_t> response;
+                 std::vector<uint8_t> const& input,
+                 std::vector<uint8_t>* response) {
+  response->clear();
   // TODO(#27): Extend when more input types are supported.
   switch (input_type) {
     case InputType::kCborMakeCredentialParameter:
       return device->ExchangeCbor(Command::kAuthenticatorMakeCredential, input,
-                                  false, &response);
+                                  false, response);
     case InputType::kCborGetAssertionParameter:
       return device->ExchangeCbor(Command::kAuthenticatorGetAssertion, input,
-                                  false, &response);
+                                  false, response);
     case InputType::kCborClientPinParameter:
       return device->ExchangeCbor(Command::kAuthenticatorClientPIN, input,
-                                  false, &response);
+                                  false, response);
+    case InputType::kCborRaw:
+      return device->ExchangeCborMessage(input, false, response);
+    case InputType::kRawData:
+      return device->ExchangeRawFrames(input);
     default:
       return Status::kErrOther;
   }
 }
 
+std::string ResponseShape(const std::vector<uint8_t>& response) {
+  if (response.empty()) {
+    return "";
+  }
+  absl::optional<cbor::Value> value = cbor::Reader::Read(response);
+  if (!value.has_value()) {
+    return "invalid";
+  }
+  if (!value->is_map()) {
+    return absl::StrCat("type ", static_cast<int>(value->type()));
+  }
+  std::string shape = "{";
+  for (const auto& [key, map_value] : value->GetMap()) {
+    if (key.is_integer()) {
+      absl::StrAppend(&shape, key.GetInteger());
+    } else if (key.is_string()) {
+      absl::StrAppend(&shape, "\"", key.GetString(), "\"");
+    } else {
+      absl::StrAppend(&shape, "type ", static_cast<int>(key.type()));
+    }
+    absl::StrAppend(&shape, ":", static_cast<int>(map_value.type()), ",");
+  }
+  return absl::StrCat(shape, "}");
+}
+
 }  // namespace fuzzing_helpers
 }  // namespace fido2_tests
 
@@ -40,14 +40,27 @@ struct FuzzingOptions {
   int max_length = 0;
   int max_mutation_degree = 10;
   int seed = time(NULL);
+  // Whether to make credentials before running GetAssertion inputs, and to
+  // make the inputs use them.
+  bool fix_credentials = false;
+  // Whether to set a PIN before running corpus tests, and to recompute the PIN
+  // related values of inputs for it.
+  bool fix_pin_auth = false;
 };
 
 // Converts an InputType to the corresponding directory name.
 std::string InputTypeToDirectoryName(InputType input_type);
 
-// Sends input to the given device and returns the status code.
+// Sends input to the given device and returns the status code. The response
+// is written to the last argument, which is empty for raw frames.
 Status SendInput(DeviceInterface* device, InputType input_type,
-                 std::vector<uint8_t> const& input);
+                 std::vector<uint8_t> const& input,
+                 std::vector<uint8_t>* response);
+
+// Summarizes the structure of a CBOR response, i.e. the keys of a map and the
+// types of their values. Responses that only differ in values have the same
+// shape.
+std::string ResponseShape(const std::vector<uint8_t>& response);
 
 }  // namespace fuzzing_helpers
 }  // namespace fido2_tests
@@ -0,0 +1,345 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/input_fixup.h"
+
+#include <algorithm>
+
+#include "src/crypto_utility.h"
+#include "third_party/chromium_components_cbor/reader.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+namespace fido2_tests {
+namespace {
+// Returns the parameter map of an encoded input, if it decodes.
+std::optional<cbor::Value> ReadParameters(
+    const std::vector<uint8_t>& parameters) {
+  absl::optional<cbor::Value> value = cbor::Reader::Read(parameters);
+  if (!value.has_value() || !value->is_map()) {
+    return std::nullopt;
+  }
+  return std::move(*value);
+}
+
+// Returns the encoded parameter map, or nothing if it can't be encoded.
+std::optional<std::vector<uint8_t>> WriteParameters(
+    cbor::Value::MapValue parameters) {
+  absl::optional<std::vector<uint8_t>> encoded =
+      cbor::Writer::Write(cbor::Value(std::move(parameters)));
+  if (!encoded.has_value()) {
+    return std::nullopt;
+  }
+  return std::move(*encoded);
+}
+
+cbor::Value::MapValue CloneMap(const cbor::Value::MapValue& map) {
+  cbor::Value::MapValue clone;
+  for (const auto& [key, value] : map) {
+    clone[key.Clone()] = value.Clone();
+  }
+  return clone;
+}
+
+// Returns the value at the integer key, or nullptr if there is none.
+const cbor::Value* FindValue(const cbor::Value::MapValue& map, int64_t key) {
+  auto entry = map.find(cbor::Value(key));
+  return entry == map.end() ? nullptr : &entry->second;
+}
+
+// Returns the byte string at the integer key, or nullptr if there is none.
+const cbor::Value::BinaryValue* FindBytestring(
+    const cbor::Value::MapValue& map, int64_t key) {
+  const cbor::Value* value = FindValue(map, key);
+  if (value == nullptr || !value->is_bytestring()) {
+    return nullptr;
+  }
+  return &value->GetBytestring();
+}
+
+// Returns the value of the RP ID parameter, if it is a string.
+const cbor::Value* FindRpId(const cbor::Value::MapValue& parameters) {
+  const cbor::Value* rp_id = FindValue(
+      parameters, static_cast<int64_t>(GetAssertionParameters::kRpId));
+  if (rp_id == nullptr || !rp_id->is_string()) {
+    return nullptr;
+  }
+  return rp_id;
+}
+
+// Returns a copy of the allow list, with the ID of every credential descriptor
+// replaced by one of the given credential IDs in turn.
+cbor::Value ReplaceCredentialIds(
+    const cbor::Value& allow_list,
+    const std::vector<cbor::Value::BinaryValue>& credential_ids) {
+  if (!allow_list.is_array()) {
+    return allow_list.Clone();
+  }
+  cbor::Value::ArrayValue fixed_allow_list;
+  size_t next_id = 0;
+  for (const cbor::Value& descriptor : allow_list.GetArray()) {
+    if (!descriptor.is_map()) {
+      fixed_allow_list.push_back(descriptor.Clone());
+      continue;
+    }
+    cbor::Value::MapValue fixed_descriptor;
+    for (const auto& [key, value] : descriptor.GetMap()) {
+      if (key.is_string() && key.GetString() == "id" && value.is_bytestring()) {
+        fixed_descriptor[key.Clone()] =
+            cbor::Value(credential_ids[next_id % credential_ids.size()]);
+        ++next_id;
+      } else {
+        fixed_descriptor[key.Clone()] = value.Clone();
+      }
+    }
+    fixed_allow_list.push_back(cbor::Value(std::move(fixed_descriptor)));
+  }
+  return cbor::Value(std::move(fixed_allow_list));
+}
+
+}  // namespace
+
+void InputFixup::Apply(fuzzing_helpers::InputType input_type,
+                       std::vector<uint8_t>* input) const {
+  Command command;
+  switch (input_type) {
+    case fuzzing_helpers::kCborMakeCredentialParameter:
+      command = Command::kAuthenticatorMakeCredential;
+      break;
+    case fuzzing_helpers::kCborGetAssertionParameter:
+      command = Command::kAuthenticatorGetAssertion;
+      break;
+    case fuzzing_helpers::kCborClientPinParameter:
+      command = Command::kAuthenticatorClientPIN;
+      break;
+    case fuzzing_helpers::kCborRaw: {
+      // Raw CBOR messages start with their command byte.
+      if (input->empty()) {
+        return;
+      }
+      const std::vector<uint8_t> parameters(input->begin() + 1, input->end());
+      if (auto fixed_parameters =
+              FixParameters(static_cast<Command>((*input)[0]), parameters)) {
+        input->resize(1);
+        input->insert(input->end(), fixed_parameters->begin(),
+                      fixed_parameters->end());
+      }
+      return;
+    }
+    default:
+      return;
+  }
+  if (auto fixed_input = FixParameters(command, *input)) {
+    *input = std::move(*fixed_input);
+  }
+}
+
+void ChainedFixup::Add(std::unique_ptr<InputFixup> input_fixup) {
+  input_fixups_.push_back(std::move(input_fixup));
+}
+
+std::optional<std::vector<uint8_t>> ChainedFixup::FixParameters(
+    Command command, const std::vector<uint8_t>& parameters) const {
+  std::optional<std::vector<uint8_t>> fixed_parameters;
+  for (const std::unique_ptr<InputFixup>& input_fixup : input_fixups_) {
+    if (auto fixed = input_fixup->FixParameters(
+            command, fixed_parameters.value_or(parameters))) {
+      fixed_parameters = std::move(fixed);
+    }
+  }
+  return fixed_parameters;
+}
+
+std::optional<std::string> ExtractRpId(const std::vector<uint8_t>& input) {
+  std::optional<cbor::Value> parameters = ReadParameters(input);
+  if (!parameters.has_value()) {
+    return std::nullopt;
+  }
+  const cbor::Value* rp_id = FindRpId(parameters->GetMap());
+  if (rp_id == nullptr) {
+    return std::nullopt;
+  }
+  return rp_id->GetString();
+}
+
+void CredentialFixup::AddCredential(
+    const std::string& rp_id, const cbor::Value::BinaryValue& credential_id) {
+  credential_ids_[rp_id].push_back(credential_id);
+}
+
+bool CredentialFixup::HasCredentials() const {
+  return !credential_ids_.empty();
+}
+
+std::optional<std::vector<uint8_t>> CredentialFixup::FixParameters(
+    Command command, const std::vector<uint8_t>& parameters) const {
+  if (command != Command::kAuthenticatorGetAssertion ||
+      credential_ids_.empty()) {
+    return std::nullopt;
+  }
+  std::optional<cbor::Value> value = ReadParameters(parameters);
+  if (!value.has_value()) {
+    return std::nullopt;
+  }
+  const cbor::Value::MapValue& map = value->GetMap();
+  const cbor::Value* rp_id = FindRpId(map);
+  if (rp_id == nullptr) {
+    return std::nullopt;
+  }
+  auto credentials = credential_ids_.find(rp_id->GetString());
+  // Unknown RP IDs are replaced, since credentials are bound to their RP.
+  if (credentials == credential_ids_.end()) {
+    credentials = credential_ids_.begin();
+  }
+
+  const int64_t rp_id_key = static_cast<int64_t>(GetAssertionParameters::kRpId);
+  const int64_t allow_list_key =
+      static_cast<int64_t>(GetAssertionParameters::kAllowList);
+  cbor::Value::MapValue fixed_map = CloneMap(map);
+  fixed_map[cbor::Value(rp_id_key)] = cbor::Value(credentials->first);
+  if (const cbor::Value* allow_list = FindValue(map, allow_list_key)) {
+    fixed_map[cbor::Value(allow_list_key)] =
+        ReplaceCredentialIds(*allow_list, credentials->second);
+  }
+  return WriteParameters(std::move(fixed_map));
+}
+
+PinAuthFixup::PinAuthFixup(std::unique_ptr<PinAuthState> pin_auth_state)
+    : pin_auth_state_(std::move(pin_auth_state)) {}
+
+std::optional<std::vector<uint8_t>> PinAuthFixup::FixParameters(
+    Command command, const std::vector<uint8_t>& parameters) const {
+  std::optional<cbor::Value> value = ReadParameters(parameters);
+  if (!value.has_value()) {
+    return std::nullopt;
+  }
+  cbor::Value::MapValue fixed_map = CloneMap(value->GetMap());
+  bool is_changed = false;
+  switch (command) {
+    case Command::kAuthenticatorMakeCredential:
+      is_changed = FixPinUvAuthParam(
+          static_cast<int64_t>(MakeCredentialParameters::kClientDataHash),
+          static_cast<int64_t>(MakeCredentialParameters::kPinUvAuthParam),
+          &fixed_map);
+      break;
+    case Command::kAuthenticatorGetAssertion:
+      is_changed = FixPinUvAuthParam(
+          static_cast<int64_t>(GetAssertionParameters::kClientDataHash),
+          static_cast<int64_t>(GetAssertionParameters::kPinUvAuthParam),
+          &fixed_map);
+      break;
+    case Command::kAuthenticatorClientPIN:
+      is_changed = FixClientPin(&fixed_map);
+      break;
+    default:
+      break;
+  }
+  if (!is_changed) {
+    return std::nullopt;
+  }
+  return WriteParameters(std::move(fixed_map));
+}
+
+bool PinAuthFixup::FixPinUvAuthParam(int64_t client_data_hash_key,
+                                     int64_t pin_uv_auth_param_key,
+                                     cbor::Value::MapValue* parameters) const {
+  const cbor::Value::BinaryValue* client_data_hash =
+      FindBytestring(*parameters, client_data_hash_key);
+  const cbor::Value::BinaryValue* pin_uv_auth_param =
+      FindBytestring(*parameters, pin_uv_auth_param_key);
+  const cbor::Value::BinaryValue auth_token = pin_auth_state_->GetAuthToken();
+  // An empty pinUvAuthParam asks for a touch and has no HMAC to fix.
+  if (auth_token.empty() || client_data_hash == nullptr ||
+      pin_uv_auth_param == nullptr || pin_uv_auth_param->empty()) {
+    return false;
+  }
+  (*parameters)[cbor::Value(pin_uv_auth_param_key)] = cbor::Value(
+      crypto_utility::LeftHmacSha256(auth_token, *client_data_hash));
+  return true;
+}
+
+bool PinAuthFixup::FixClientPin(cbor::Value::MapValue* parameters) const {
+  const cbor::Value::BinaryValue shared_secret =
+      pin_auth_state_->GetSharedSecret();
+  if (shared_secret.empty()) {
+    return false;
+  }
+  const cbor::Value::BinaryValue pin_utf8 = pin_auth_state_->GetPin();
+  bool is_changed = false;
+  const cbor::Value* key_agreement = FindValue(
+      *parameters, static_cast<int64_t>(ClientPinParameters::kKeyAgreement));
+  if (key_agreement != nullptr && key_agreement->is_map()) {
+    (*parameters)[cbor::Value(
+        static_cast<int64_t>(ClientPinParameters::kKeyAgreement))] =
+        cbor::Value(CloneMap(pin_auth_state_->GetPlatformCoseKey()));
+    is_changed = true;
+  }
+
+  const int64_t new_pin_enc_key =
+      static_cast<int64_t>(ClientPinParameters::kNewPinEnc);
+  const int64_t pin_hash_enc_key =
+      static_cast<int64_t>(ClientPinParameters::kPinHashEnc);
+  if (!pin_utf8.empty()) {
+    // Keeps the length of the padded PIN, unless the PIN doesn't fit.
+    const cbor::Value::BinaryValue* new_pin_enc =
+        FindBytestring(*parameters, new_pin_enc_key);
+    if (new_pin_enc != nullptr && new_pin_enc->size() % 16 == 0 &&
+        new_pin_enc->size() > pin_utf8.size()) {
+      cbor::Value::BinaryValue padded_pin(new_pin_enc->size(), 0);
+      std::copy(pin_utf8.begin(), pin_utf8.end(), padded_pin.begin());
+      (*parameters)[cbor::Value(new_pin_enc_key)] = cbor::Value(
+          crypto_utility::Aes256CbcEncrypt(shared_secret, padded_pin));
+      is_changed = true;
+    }
+    const cbor::Value::BinaryValue* pin_hash_enc =
+        FindBytestring(*parameters, pin_hash_enc_key);
+    if (pin_hash_enc != nullptr && pin_hash_enc->size() == 16) {
+      (*parameters)[cbor::Value(pin_hash_enc_key)] =
+          cbor::Value(crypto_utility::Aes256CbcEncrypt(
+              shared_secret, crypto_utility::LeftSha256Hash(pin_utf8)));
+      is_changed = true;
+    }
+  }
+
+  const int64_t pin_uv_auth_param_key =
+      static_cast<int64_t>(ClientPinParameters::kPinUvAuthParam);
+  const cbor::Value* sub_command = FindValue(
+      *parameters, static_cast<int64_t>(ClientPinParameters::kSubCommand));
+  if (FindBytestring(*parameters, pin_uv_auth_param_key) == nullptr ||
+      sub_command == nullptr || !sub_command->is_unsigned()) {
+    return is_changed;
+  }
+  // The authenticated message depends on the subcommand.
+  const cbor::Value::BinaryValue* new_pin_enc =
+      FindBytestring(*parameters, new_pin_enc_key);
+  const cbor::Value::BinaryValue* pin_hash_enc =
+      FindBytestring(*parameters, pin_hash_enc_key);
+  cbor::Value::BinaryValue message;
+  if (sub_command->GetUnsigned() ==
+          static_cast<int64_t>(PinSubCommand::kSetPin) &&
+      new_pin_enc != nullptr) {
+    message = *new_pin_enc;
+  } else if (sub_command->GetUnsigned() ==
+                 static_cast<int64_t>(PinSubCommand::kChangePin) &&
+             new_pin_enc != nullptr && pin_hash_enc != nullptr) {
+    message = *new_pin_enc;
+    message.insert(message.end(), pin_hash_enc->begin(), pin_hash_enc->end());
+  } else {
+    return is_changed;
+  }
+  (*parameters)[cbor::Value(pin_uv_auth_param_key)] =
+      cbor::Value(crypto_utility::LeftHmacSha256(shared_secret, message));
+  return true;
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,133 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FUZZING_INPUT_FIXUP_H_
+#define FUZZING_INPUT_FIXUP_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "src/constants.h"
+#include "src/fuzzing/fuzzing_helpers.h"
+#include "third_party/chromium_components_cbor/values.h"
+
+namespace fido2_tests {
+
+// Rewrites values in inputs that the device checks before it gets to the
+// interesting code, similar to fixing checksums in other fuzzers. Fix-ups only
+// change inputs that decode to the expected structure, and keep all other
+// values, so that malformed parts still reach the device. Fix-ups that only
+// read their own values are safe to call from another thread than the one that
+// set them up. Fix-ups that read device state are not.
+class InputFixup {
+ public:
+  virtual ~InputFixup() = default;
+  // Rewrites the input in place, if the fix-up applies to it. Applies to the
+  // CBOR parameter input types, and to raw CBOR messages by their command
+  // byte.
+  void Apply(fuzzing_helpers::InputType input_type,
+             std::vector<uint8_t>* input) const;
+  // Returns the rewritten encoded parameters of the command, or nothing if the
+  // fix-up does not apply to them.
+  virtual std::optional<std::vector<uint8_t>> FixParameters(
+      Command command, const std::vector<uint8_t>& parameters) const = 0;
+};
+
+// Applies several fix-ups in the order they were added.
+class ChainedFixup : public InputFixup {
+ public:
+  void Add(std::unique_ptr<InputFixup> input_fixup);
+  std::optional<std::vector<uint8_t>> FixParameters(
+      Command command, const std::vector<uint8_t>& parameters) const override;
+
+ private:
+  std::vector<std::unique_ptr<InputFixup>> input_fixups_;
+};
+
+// Returns the RP ID of an encoded GetAssertion parameter map, if it has one.
+std::optional<std::string> ExtractRpId(const std::vector<uint8_t>& input);
+
+// Makes GetAssertion inputs reference credentials that exist on the device.
+// Otherwise, the device rejects nearly all of them for missing credentials,
+// before it checks options, extensions or signs anything.
+class CredentialFixup : public InputFixup {
+ public:
+  // Remembers a credential that exists on the device.
+  void AddCredential(const std::string& rp_id,
+                     const cbor::Value::BinaryValue& credential_id);
+  // Returns whether any credential was added.
+  bool HasCredentials() const;
+  // Replaces the IDs of all allow list entries with IDs of credentials for the
+  // input's RP ID. If there are none for this RP ID, replaces the RP ID, too.
+  std::optional<std::vector<uint8_t>> FixParameters(
+      Command command, const std::vector<uint8_t>& parameters) const override;
+
+ private:
+  // Ordered, so that replacements don't depend on the hash seed.
+  std::map<std::string, std::vector<cbor::Value::BinaryValue>>
+      credential_ids_;
+};
+
+// The PIN related state of a device, like CommandState tracks it. Unknown
+// values are empty.
+class PinAuthState {
+ public:
+  virtual ~PinAuthState() = default;
+  // Returns the platform key of the last key agreement.
+  virtual const cbor::Value::MapValue& GetPlatformCoseKey() const = 0;
+  // Returns the shared secret of the last key agreement.
+  virtual cbor::Value::BinaryValue GetSharedSecret() const = 0;
+  // Returns the PIN that is currently set.
+  virtual cbor::Value::BinaryValue GetPin() const = 0;
+  // Returns the PIN token the device currently accepts.
+  virtual cbor::Value::BinaryValue GetAuthToken() const = 0;
+};
+
+// Recomputes the PIN related values of inputs from the state of a device with
+// a PIN, so that they pass the HMAC and PIN checks. MakeCredential and
+// GetAssertion get a pinUvAuthParam from the PIN token. ClientPin gets the
+// platform key for the key agreement, and newPinEnc and pinHashEnc of the
+// current PIN, with a matching pinUvAuthParam. The PIN therefore stays the
+// same even if a ChangePin input succeeds.
+//
+// The state is read again for every input, because inputs with a wrong
+// pinHashEnc make the device renew its key agreement. Apply this fix-up on the
+// thread that talks to the device, just before sending the input.
+class PinAuthFixup : public InputFixup {
+ public:
+  // Values that depend on empty state are not changed.
+  explicit PinAuthFixup(std::unique_ptr<PinAuthState> pin_auth_state);
+  std::optional<std::vector<uint8_t>> FixParameters(
+      Command command, const std::vector<uint8_t>& parameters) const override;
+
+ private:
+  // Replaces the pinUvAuthParam at the key with the HMAC of the client data
+  // hash at the other key. Returns whether the map changed.
+  bool FixPinUvAuthParam(int64_t client_data_hash_key,
+                         int64_t pin_uv_auth_param_key,
+                         cbor::Value::MapValue* parameters) const;
+  // Fixes the parameters of a ClientPin input. Returns whether the map
+  // changed.
+  bool FixClientPin(cbor::Value::MapValue* parameters) const;
+
+  const std::unique_ptr<PinAuthState> pin_auth_state_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // FUZZING_INPUT_FIXUP_H_
@@ -0,0 +1,307 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/input_fixup.h"
+
+#include "gtest/gtest.h"
+#include "src/constants.h"
+#include "src/crypto_utility.h"
+#include "third_party/chromium_components_cbor/reader.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+namespace fido2_tests {
+namespace {
+
+const cbor::Value::BinaryValue kCredentialA = {0xAA, 0xAA};
+const cbor::Value::BinaryValue kCredentialB = {0xBB, 0xBB};
+const cbor::Value::BinaryValue kSharedSecret(32, 0x5E);
+const cbor::Value::BinaryValue kPin = {0x31, 0x32, 0x33, 0x34};
+const cbor::Value::BinaryValue kAuthToken(16, 0x70);
+const cbor::Value::BinaryValue kStale(16, 0xEE);
+
+// Returns encoded GetAssertion parameters with an allow list of the IDs.
+std::vector<uint8_t> EncodeParameters(
+    const std::string& rp_id,
+    const std::vector<cbor::Value::BinaryValue>& credential_ids) {
+  cbor::Value::ArrayValue allow_list;
+  for (const cbor::Value::BinaryValue& credential_id : credential_ids) {
+    cbor::Value::MapValue descriptor;
+    descriptor[cbor::Value("type")] = cbor::Value("public-key");
+    descriptor[cbor::Value("id")] = cbor::Value(credential_id);
+    allow_list.push_back(cbor::Value(std::move(descriptor)));
+  }
+  cbor::Value::MapValue parameters;
+  parameters[cbor::Value(1)] = cbor::Value(rp_id);
+  parameters[cbor::Value(2)] = cbor::Value(cbor::Value::BinaryValue(32, 0x01));
+  parameters[cbor::Value(3)] = cbor::Value(std::move(allow_list));
+  return cbor::Writer::Write(cbor::Value(std::move(parameters))).value();
+}
+
+// Returns the decoded parameter map.
+cbor::Value Decode(const std::vector<uint8_t>& parameters) {
+  return cbor::Reader::Read(parameters).value();
+}
+
+// Returns the byte string at the integer key of the decoded map.
+cbor::Value::BinaryValue GetBytes(const cbor::Value& map, int64_t key) {
+  return map.GetMap().find(cbor::Value(key))->second.GetBytestring();
+}
+
+// Holds PIN state that tests can change between inputs.
+class FakePinAuthState : public PinAuthState {
+ public:
+  FakePinAuthState() { platform_cose_key_[cbor::Value(1)] = cbor::Value(2); }
+  const cbor::Value::MapValue& GetPlatformCoseKey() const override {
+    return platform_cose_key_;
+  }
+  cbor::Value::BinaryValue GetSharedSecret() const override {
+    return shared_secret_;
+  }
+  cbor::Value::BinaryValue GetPin() const override { return kPin; }
+  cbor::Value::BinaryValue GetAuthToken() const override {
+    return auth_token_;
+  }
+  // Simulates a new key agreement that also got a new PIN token.
+  void Renew(const cbor::Value::BinaryValue& shared_secret,
+             const cbor::Value::BinaryValue& auth_token) {
+    platform_cose_key_[cbor::Value(1)] = cbor::Value(3);
+    shared_secret_ = shared_secret;
+    auth_token_ = auth_token;
+  }
+
+ private:
+  cbor::Value::MapValue platform_cose_key_;
+  cbor::Value::BinaryValue shared_secret_ = kSharedSecret;
+  cbor::Value::BinaryValue auth_token_ = kAuthToken;
+};
+
+std::unique_ptr<PinAuthFixup> MakePinAuthFixup() {
+  return std::make_unique<PinAuthFixup>(std::make_unique<FakePinAuthState>());
+}
+
+// Returns encoded MakeCredential parameters with a stale pinUvAuthParam.
+std::vector<uint8_t> EncodeMakeCredential(
+    const cbor::Value::BinaryValue& client_data_hash) {
+  cbor::Value::MapValue parameters;
+  parameters[cbor::Value(1)] = cbor::Value(client_data_hash);
+  parameters[cbor::Value(8)] = cbor::Value(kStale);
+  return cbor::Writer::Write(cbor::Value(std::move(parameters))).value();
+}
+
+// Returns encoded GetPinToken parameters with a stale key and pinHashEnc.
+std::vector<uint8_t> EncodeGetPinToken() {
+  cbor::Value::MapValue stale_key;
+  stale_key[cbor::Value(1)] = cbor::Value(5);
+  cbor::Value::MapValue parameters;
+  parameters[cbor::Value(1)] = cbor::Value(1);
+  parameters[cbor::Value(2)] =
+      cbor::Value(static_cast<int64_t>(PinSubCommand::kGetPinToken));
+  parameters[cbor::Value(3)] = cbor::Value(std::move(stale_key));
+  parameters[cbor::Value(6)] = cbor::Value(kStale);
+  return cbor::Writer::Write(cbor::Value(std::move(parameters))).value();
+}
+
+CredentialFixup MakeFixup() {
+  CredentialFixup fixup;
+  fixup.AddCredential("example.com", kCredentialA);
+  fixup.AddCredential("example.com", kCredentialB);
+  fixup.AddCredential("other.com", kCredentialB);
+  return fixup;
+}
+
+TEST(InputFixup, TestExtractRpId) {
+  EXPECT_EQ(ExtractRpId(EncodeParameters("example.com", {})), "example.com");
+  EXPECT_EQ(ExtractRpId({0xA0}), std::nullopt);
+  EXPECT_EQ(ExtractRpId({0xFF}), std::nullopt);
+}
+
+TEST(InputFixup, TestReplacesCredentialIds) {
+  const CredentialFixup fixup = MakeFixup();
+  std::vector<uint8_t> input =
+      EncodeParameters("example.com", {{0x01}, {0x02}, {0x03}});
+  fixup.Apply(fuzzing_helpers::kCborGetAssertionParameter, &input);
+  EXPECT_EQ(input,
+            EncodeParameters("example.com",
+                             {kCredentialA, kCredentialB, kCredentialA}));
+}
+
+TEST(InputFixup, TestReplacesUnknownRpId) {
+  const CredentialFixup fixup = MakeFixup();
+  std::vector<uint8_t> input = EncodeParameters("unknown.com", {{0x01}});
+  fixup.Apply(fuzzing_helpers::kCborGetAssertionParameter, &input);
+  EXPECT_EQ(input, EncodeParameters("example.com", {kCredentialA}));
+}
+
+TEST(InputFixup, TestKeepsMalformedInputs) {
+  const CredentialFixup fixup = MakeFixup();
+  const std::vector<std::vector<uint8_t>> inputs = {
+      {}, {0xFF}, {0xA1, 0x01, 0x02}, {0xA1, 0x03, 0x01}};
+  for (const std::vector<uint8_t>& original : inputs) {
+    std::vector<uint8_t> input = original;
+    fixup.Apply(fuzzing_helpers::kCborGetAssertionParameter, &input);
+    EXPECT_EQ(input, original);
+  }
+  // Other input types are never changed.
+  std::vector<uint8_t> input = EncodeParameters("example.com", {{0x01}});
+  const std::vector<uint8_t> original = input;
+  fixup.Apply(fuzzing_helpers::kCborMakeCredentialParameter, &input);
+  EXPECT_EQ(input, original);
+}
+
+TEST(InputFixup, TestRawGetAssertion) {
+  const CredentialFixup fixup = MakeFixup();
+  std::vector<uint8_t> input = EncodeParameters("other.com", {{0x01}});
+  input.insert(input.begin(),
+               static_cast<uint8_t>(Command::kAuthenticatorGetAssertion));
+  fixup.Apply(fuzzing_helpers::kCborRaw, &input);
+  std::vector<uint8_t> expected = EncodeParameters("other.com", {kCredentialB});
+  expected.insert(expected.begin(),
+                  static_cast<uint8_t>(Command::kAuthenticatorGetAssertion));
+  EXPECT_EQ(input, expected);
+}
+
+TEST(InputFixup, TestWithoutCredentials) {
+  const CredentialFixup fixup;
+  EXPECT_FALSE(fixup.HasCredentials());
+  std::vector<uint8_t> input = EncodeParameters("example.com", {{0x01}});
+  const std::vector<uint8_t> original = input;
+  fixup.Apply(fuzzing_helpers::kCborGetAssertionParameter, &input);
+  EXPECT_EQ(input, original);
+}
+
+TEST(InputFixup, TestPinUvAuthParam) {
+  const std::unique_ptr<PinAuthFixup> fixup = MakePinAuthFixup();
+  const cbor::Value::BinaryValue client_data_hash(32, 0x01);
+  cbor::Value::MapValue parameters;
+  parameters[cbor::Value(1)] = cbor::Value(client_data_hash);
+  parameters[cbor::Value(8)] = cbor::Value(kStale);
+  std::vector<uint8_t> input =
+      cbor::Writer::Write(cbor::Value(std::move(parameters))).value();
+  fixup->Apply(fuzzing_helpers::kCborMakeCredentialParameter, &input);
+  EXPECT_EQ(GetBytes(Decode(input), 8),
+            crypto_utility::LeftHmacSha256(kAuthToken, client_data_hash));
+
+  // An empty pinUvAuthParam is sent unchanged.
+  parameters[cbor::Value(1)] = cbor::Value(client_data_hash);
+  parameters[cbor::Value(8)] = cbor::Value(cbor::Value::BinaryValue());
+  input = cbor::Writer::Write(cbor::Value(std::move(parameters))).value();
+  const std::vector<uint8_t> original = input;
+  fixup->Apply(fuzzing_helpers::kCborMakeCredentialParameter, &input);
+  EXPECT_EQ(input, original);
+}
+
+TEST(InputFixup, TestChangePin) {
+  const std::unique_ptr<PinAuthFixup> fixup = MakePinAuthFixup();
+  cbor::Value::MapValue stale_key;
+  stale_key[cbor::Value(1)] = cbor::Value(5);
+  cbor::Value::MapValue parameters;
+  parameters[cbor::Value(1)] = cbor::Value(1);
+  parameters[cbor::Value(2)] =
+      cbor::Value(static_cast<int64_t>(PinSubCommand::kChangePin));
+  parameters[cbor::Value(3)] = cbor::Value(std::move(stale_key));
+  parameters[cbor::Value(4)] = cbor::Value(kStale);
+  parameters[cbor::Value(5)] =
+      cbor::Value(cbor::Value::BinaryValue(64, 0xEE));
+  parameters[cbor::Value(6)] = cbor::Value(kStale);
+  std::vector<uint8_t> input =
+      cbor::Writer::Write(cbor::Value(std::move(parameters))).value();
+  fixup->Apply(fuzzing_helpers::kCborClientPinParameter, &input);
+
+  const cbor::Value fixed = Decode(input);
+  EXPECT_EQ(fixed.GetMap().find(cbor::Value(3))->second.GetMap().size(), 1);
+  EXPECT_EQ(fixed.GetMap()
+                .find(cbor::Value(3))
+                ->second.GetMap()
+                .find(cbor::Value(1))
+                ->second.GetInteger(),
+            2);
+  cbor::Value::BinaryValue padded_pin(64, 0);
+  std::copy(kPin.begin(), kPin.end(), padded_pin.begin());
+  const cbor::Value::BinaryValue new_pin_enc = GetBytes(fixed, 5);
+  EXPECT_EQ(crypto_utility::Aes256CbcDecrypt(kSharedSecret, new_pin_enc),
+            padded_pin);
+  const cbor::Value::BinaryValue pin_hash_enc = GetBytes(fixed, 6);
+  EXPECT_EQ(crypto_utility::Aes256CbcDecrypt(kSharedSecret, pin_hash_enc),
+            crypto_utility::LeftSha256Hash(kPin));
+  cbor::Value::BinaryValue message = new_pin_enc;
+  message.insert(message.end(), pin_hash_enc.begin(), pin_hash_enc.end());
+  EXPECT_EQ(GetBytes(fixed, 4),
+            crypto_utility::LeftHmacSha256(kSharedSecret, message));
+}
+
+TEST(InputFixup, TestReadsStateForEachInput) {
+  auto pin_auth_state = std::make_unique<FakePinAuthState>();
+  FakePinAuthState* state = pin_auth_state.get();
+  const PinAuthFixup fixup(std::move(pin_auth_state));
+  const cbor::Value::BinaryValue client_data_hash(32, 0x01);
+
+  std::vector<uint8_t> input = EncodeMakeCredential(client_data_hash);
+  fixup.Apply(fuzzing_helpers::kCborMakeCredentialParameter, &input);
+  EXPECT_EQ(GetBytes(Decode(input), 8),
+            crypto_utility::LeftHmacSha256(kAuthToken, client_data_hash));
+
+  // A wrong pinHashEnc made the device renew its key agreement, and the
+  // monitor got a new PIN token.
+  const cbor::Value::BinaryValue new_shared_secret(32, 0x6E);
+  const cbor::Value::BinaryValue new_auth_token(16, 0x71);
+  state->Renew(new_shared_secret, new_auth_token);
+
+  input = EncodeMakeCredential(client_data_hash);
+  fixup.Apply(fuzzing_helpers::kCborMakeCredentialParameter, &input);
+  EXPECT_EQ(GetBytes(Decode(input), 8),
+            crypto_utility::LeftHmacSha256(new_auth_token, client_data_hash));
+
+  input = EncodeGetPinToken();
+  fixup.Apply(fuzzing_helpers::kCborClientPinParameter, &input);
+  const cbor::Value fixed = Decode(input);
+  EXPECT_EQ(fixed.GetMap()
+                .find(cbor::Value(3))
+                ->second.GetMap()
+                .find(cbor::Value(1))
+                ->second.GetInteger(),
+            3);
+  EXPECT_EQ(crypto_utility::Aes256CbcDecrypt(new_shared_secret,
+                                             GetBytes(fixed, 6)),
+            crypto_utility::LeftSha256Hash(kPin));
+}
+
+TEST(InputFixup, TestChainedFixup) {
+  ChainedFixup fixup;
+  auto credential_fixup = std::make_unique<CredentialFixup>();
+  credential_fixup->AddCredential("example.com", kCredentialA);
+  fixup.Add(std::move(credential_fixup));
+  fixup.Add(MakePinAuthFixup());
+
+  // EncodeParameters uses this client data hash.
+  const cbor::Value::BinaryValue client_data_hash(32, 0x01);
+  std::vector<uint8_t> input = EncodeParameters("example.com", {{0x01}});
+  // Appends key 6 to the map of 3 entries.
+  input[0] = 0xA4;
+  input.insert(input.end(), {0x06, 0x50});
+  input.insert(input.end(), kStale.begin(), kStale.end());
+  fixup.Apply(fuzzing_helpers::kCborGetAssertionParameter, &input);
+
+  const cbor::Value fixed = Decode(input);
+  const cbor::Value& allow_list = fixed.GetMap().find(cbor::Value(3))->second;
+  EXPECT_EQ(allow_list.GetArray()[0]
+                .GetMap()
+                .find(cbor::Value("id"))
+                ->second.GetBytestring(),
+            kCredentialA);
+  EXPECT_EQ(GetBytes(fixed, 6),
+            crypto_utility::LeftHmacSha256(kAuthToken, client_data_hash));
+}
+
+}  // namespace
+}  // namespace fido2_tests
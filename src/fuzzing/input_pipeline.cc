@@ -0,0 +1,191 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/input_pipeline.h"
+
+#include <iterator>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "glog/logging.h"
+#include "src/fuzzing/mutator.h"
+
+namespace fido2_tests {
+namespace {
+// The input types that the pipeline picks from.
+constexpr fuzzing_helpers::InputType kPipelineInputTypes[] = {
+    fuzzing_helpers::InputType::kCborMakeCredentialParameter,
+    fuzzing_helpers::InputType::kCborGetAssertionParameter,
+    fuzzing_helpers::InputType::kCborClientPinParameter,
+    fuzzing_helpers::InputType::kCborRaw,
+    fuzzing_helpers::InputType::kRawData,
+};
+// How many inputs the producer prepares ahead of the device. Preparing an
+// input takes far less time than a device round trip, so a few are enough to
+// never let the device wait. More would delay the reaction to feedback.
+constexpr size_t kPipelineDepth = 8;
+// Polls of an empty ring buffer that only yield. Later polls sleep, because
+// the other side usually waits for the device, and spinning through a long
+// fuzzing run would keep a core busy.
+constexpr int kSpinPollCount = 64;
+constexpr absl::Duration kPollInterval = absl::Microseconds(100);
+
+// Waits before polling a ring buffer again, for the given number of times it
+// was already empty.
+void WaitBeforePoll(int failed_poll_count) {
+  if (failed_poll_count < kSpinPollCount) {
+    std::this_thread::yield();
+  } else {
+    absl::SleepFor(kPollInterval);
+  }
+}
+}  // namespace
+
+InputPipeline::InputPipeline(const fuzzing_helpers::FuzzingOptions& options,
+                             const InputFixup* input_fixup)
+    : options_(options),
+      input_fixup_(input_fixup),
+      input_type_scheduler_(0),
+      rng_(options.seed),
+      inputs_(kPipelineDepth),
+      feedbacks_(kPipelineDepth) {
+  for (fuzzing_helpers::InputType input_type : kPipelineInputTypes) {
+    CorpusController corpus_controller(input_type, options_.corpus_path,
+                                       options_.seed + input_type);
+    if (!corpus_controller.IsEmpty()) {
+      input_types_.push_back(input_type);
+      corpus_controllers_.push_back(std::move(corpus_controller));
+    }
+  }
+  input_type_scheduler_ = BanditScheduler(input_types_.size());
+  // Each input type has its own operators, since an operator that is useful
+  // on CBOR parameters might not be useful on raw reports.
+  operator_schedulers_.assign(
+      input_types_.size(), BanditScheduler(std::size(kAllMutationOperators)));
+  if (HasInputs()) {
+    producer_ = std::thread(&InputPipeline::Produce, this);
+  }
+}
+
+InputPipeline::~InputPipeline() {
+  is_stopping_.store(true, std::memory_order_release);
+  if (producer_.joinable()) {
+    producer_.join();
+  }
+}
+
+bool InputPipeline::HasInputs() const {
+  return options_.num_runs > 0 && !input_types_.empty();
+}
+
+PreparedInput InputPipeline::GetNextInput() {
+  CHECK(producer_.joinable()) << "no inputs to get - TEST SUITE BUG";
+  PreparedInput input;
+  if (inputs_.TryPop(&input)) {
+    return input;
+  }
+  const absl::Time start = absl::Now();
+  for (int failed_poll_count = 0; !inputs_.TryPop(&input);
+       ++failed_poll_count) {
+    WaitBeforePoll(failed_poll_count);
+  }
+  wait_time_ += absl::Now() - start;
+  return input;
+}
+
+void InputPipeline::RecordExecution(ExecutionFeedback feedback) {
+  // The producer never has more inputs in flight than the buffer holds.
+  CHECK(feedbacks_.TryPush(std::move(feedback)))
+      << "more feedback than inputs - TEST SUITE BUG";
+}
+
+std::vector<std::pair<fuzzing_helpers::InputType, double>>
+InputPipeline::Join() {
+  if (producer_.joinable()) {
+    producer_.join();
+  }
+  std::vector<std::pair<fuzzing_helpers::InputType, double>> success_rates;
+  for (size_t type_index = 0; type_index < input_types_.size(); ++type_index) {
+    success_rates.push_back(
+        {input_types_[type_index],
+         input_type_scheduler_.GetSuccessRate(type_index)});
+  }
+  return success_rates;
+}
+
+absl::Duration InputPipeline::GetWaitTime() const { return wait_time_; }
+
+void InputPipeline::Produce() {
+  for (int run = 0; run < options_.num_runs; ++run) {
+    // Input number run uses all feedback up to run - kPipelineDepth, no
+    // matter how fast the device is.
+    while (input_origins_.size() >= kPipelineDepth) {
+      if (!ApplyFeedback()) return;
+    }
+    PreparedInput input = Prepare(run);
+    // Inputs in flight are fewer than the buffer capacity, so it has space.
+    CHECK(inputs_.TryPush(std::move(input)))
+        << "input buffer overflow - TEST SUITE BUG";
+  }
+  while (!input_origins_.empty()) {
+    if (!ApplyFeedback()) return;
+  }
+}
+
+PreparedInput InputPipeline::Prepare(int run) {
+  const size_t type_index = input_type_scheduler_.Sample(&rng_);
+  const size_t operator_index = operator_schedulers_[type_index].Sample(&rng_);
+  const MutationOperator mutation_operator =
+      kAllMutationOperators[operator_index];
+  auto [data, name, seed_index] =
+      corpus_controllers_[type_index].GetRandomInput();
+  if (mutation_operator != MutationOperator::kNone) {
+    Mutate(mutation_operator, options_.max_mutation_degree,
+           options_.max_length, &rng_, &data);
+    // Saved crash files must not overwrite their seed.
+    name = absl::StrCat(name, "_", MutationOperatorToString(mutation_operator),
+                        "_", run);
+  }
+  if (input_fixup_ != nullptr) {
+    input_fixup_->Apply(input_types_[type_index], &data);
+  }
+  input_origins_.push_back({.type_index = type_index,
+                            .operator_index = operator_index,
+                            .seed_index = seed_index});
+  return {.input_type = input_types_[type_index],
+          .data = std::move(data),
+          .name = std::move(name)};
+}
+
+bool InputPipeline::ApplyFeedback() {
+  ExecutionFeedback feedback;
+  for (int failed_poll_count = 0; !feedbacks_.TryPop(&feedback);
+       ++failed_poll_count) {
+    if (is_stopping_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    WaitBeforePoll(failed_poll_count);
+  }
+  const InputOrigin origin = input_origins_.front();
+  input_origins_.pop_front();
+  const bool is_discovery =
+      corpus_controllers_[origin.type_index].RecordExecution(origin.seed_index,
+                                                             feedback);
+  input_type_scheduler_.RecordResult(origin.type_index, is_discovery);
+  operator_schedulers_[origin.type_index].RecordResult(origin.operator_index,
+                                                       is_discovery);
+  return true;
+}
+
+}  // namespace fido2_tests
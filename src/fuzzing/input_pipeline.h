@@ -0,0 +1,120 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FUZZING_INPUT_PIPELINE_H_
+#define FUZZING_INPUT_PIPELINE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "src/fuzzing/bandit_scheduler.h"
+#include "src/fuzzing/corpus_controller.h"
+#include "src/fuzzing/fuzzing_helpers.h"
+#include "src/fuzzing/input_fixup.h"
+#include "src/fuzzing/seed_scheduler.h"
+#include "src/fuzzing/spsc_ring_buffer.h"
+
+namespace fido2_tests {
+
+// An input that is ready to be sent.
+struct PreparedInput {
+  fuzzing_helpers::InputType input_type;
+  std::vector<uint8_t> data;
+  std::string name;
+};
+
+// Prepares options.num_runs mutated inputs from all corpora on a producer
+// thread, while the calling thread sends earlier inputs to the device. Every
+// input needs a corpus, a mutation operator and a seed file. Corpora and
+// operators are picked by bandit schedulers, so that most inputs go to the
+// corpus and operator that recently found new device behavior. Seed files are
+// picked with preference for files that caused new responses.
+//
+// The threads only exchange inputs and feedback through ring buffers, and
+// sleep briefly while a buffer stays empty. All scheduling state belongs to
+// the producer, which stays at most a fixed number of inputs ahead of the
+// device. Each decision uses the feedback of exactly the inputs up to that
+// distance, so thread timing does not change decisions. Device timing does,
+// because the execution time in the feedback weighs the seed files.
+//
+// All public functions must be called from the same thread.
+class InputPipeline {
+ public:
+  // Starts the producer thread, if any corpus has files. The optional fix-up
+  // is applied to inputs after mutation on the producer thread, so it must not
+  // read device state. It must outlive the pipeline.
+  explicit InputPipeline(const fuzzing_helpers::FuzzingOptions& options,
+                         const InputFixup* input_fixup = nullptr);
+  // Stops the producer, even if it did not get all feedback.
+  ~InputPipeline();
+  InputPipeline(const InputPipeline&) = delete;
+  InputPipeline& operator=(const InputPipeline&) = delete;
+
+  // Returns whether the pipeline will produce inputs, i.e. whether there are
+  // runs to do and corpus files to mutate.
+  bool HasInputs() const;
+  // Blocks until the next input is prepared. Call at most options.num_runs
+  // times.
+  PreparedInput GetNextInput();
+  // Reports what the device did with the oldest input without feedback.
+  void RecordExecution(ExecutionFeedback feedback);
+  // Waits until the producer applied all feedback. Returns the expected rate of
+  // new behavior for each input type. Call after the last feedback.
+  std::vector<std::pair<fuzzing_helpers::InputType, double>> Join();
+  // Returns how long GetNextInput waited for the producer in total.
+  absl::Duration GetWaitTime() const;
+
+ private:
+  // The scheduling decisions of an input, to route its feedback.
+  struct InputOrigin {
+    size_t type_index;
+    size_t operator_index;
+    size_t seed_index;
+  };
+
+  void Produce();
+  // Picks, reads and mutates the input with the given number.
+  PreparedInput Prepare(int run);
+  // Blocks until the next feedback arrives, and updates the schedulers with
+  // it. Returns false if the pipeline is stopping instead.
+  bool ApplyFeedback();
+
+  const fuzzing_helpers::FuzzingOptions options_;
+  const InputFixup* input_fixup_;
+  // Only accessed from the producer thread while it runs.
+  std::vector<fuzzing_helpers::InputType> input_types_;
+  std::vector<CorpusController> corpus_controllers_;
+  BanditScheduler input_type_scheduler_;
+  std::vector<BanditScheduler> operator_schedulers_;
+  std::mt19937 rng_;
+  std::deque<InputOrigin> input_origins_;
+
+  SpscRingBuffer<PreparedInput> inputs_;
+  SpscRingBuffer<ExecutionFeedback> feedbacks_;
+  std::atomic<bool> is_stopping_ = false;
+  // Only accessed from the calling thread.
+  absl::Duration wait_time_ = absl::ZeroDuration();
+  std::thread producer_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // FUZZING_INPUT_PIPELINE_H_
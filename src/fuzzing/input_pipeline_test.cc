@@ -0,0 +1,85 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/input_pipeline.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+// Writes a corpus with a few Cbor_Raw files and returns its path.
+std::string WriteCorpus() {
+  const std::filesystem::path corpus_path =
+      std::filesystem::path(testing::TempDir()) / "input_pipeline_corpus";
+  const std::filesystem::path type_path =
+      corpus_path /
+      fuzzing_helpers::InputTypeToDirectoryName(fuzzing_helpers::kCborRaw);
+  std::filesystem::create_directories(type_path);
+  for (int i = 0; i < 4; ++i) {
+    std::ofstream file(type_path / absl::StrCat("seed_", i),
+                       std::ios::out | std::ios::binary);
+    file << static_cast<char>(0x04 + i) << "\xA1\x01\x02";
+  }
+  return corpus_path.string();
+}
+
+// Runs the pipeline with a fake device whose status depends on the first
+// byte, and returns the names of all inputs.
+std::vector<std::string> RunPipeline(
+    const fuzzing_helpers::FuzzingOptions& options) {
+  InputPipeline pipeline(options);
+  std::vector<std::string> names;
+  for (int i = 0; i < options.num_runs; ++i) {
+    PreparedInput input = pipeline.GetNextInput();
+    EXPECT_EQ(input.input_type, fuzzing_helpers::kCborRaw);
+    names.push_back(input.name);
+    pipeline.RecordExecution(
+        {.status = input.data.empty() ? Status::kErrInvalidLength
+                                      : static_cast<Status>(input.data[0]),
+         .response_shape = "",
+         .execution_time = absl::Milliseconds(1)});
+  }
+  auto success_rates = pipeline.Join();
+  EXPECT_EQ(success_rates.size(), 1);
+  return names;
+}
+
+TEST(InputPipeline, TestNoCorpus) {
+  InputPipeline pipeline({.corpus_path = "/nonexistent", .num_runs = 10});
+  EXPECT_FALSE(pipeline.HasInputs());
+}
+
+TEST(InputPipeline, TestReproducible) {
+  const fuzzing_helpers::FuzzingOptions options = {
+      .corpus_path = WriteCorpus(), .num_runs = 200, .seed = 7};
+  const std::vector<std::string> names = RunPipeline(options);
+  EXPECT_EQ(names.size(), 200);
+  EXPECT_EQ(RunPipeline(options), names);
+}
+
+TEST(InputPipeline, TestStopsWithoutAllFeedback) {
+  InputPipeline pipeline(
+      {.corpus_path = WriteCorpus(), .num_runs = 100, .seed = 7});
+  ASSERT_TRUE(pipeline.HasInputs());
+  pipeline.GetNextInput();
+  // The destructor must not wait for the missing feedback.
+}
+
+}  // namespace
+}  // namespace fido2_tests
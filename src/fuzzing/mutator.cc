@@ -0,0 +1,131 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/mutator.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "glog/logging.h"
+
+namespace fido2_tests {
+namespace {
+// Boundary values of integers and CBOR headers announcing 1 to 8 byte
+// arguments, indefinite lengths or a break. Each value appears once, so that
+// all are picked equally often.
+constexpr uint8_t kInterestingBytes[] = {0x00, 0x01, 0x7F, 0x80, 0xFF, 0x18,
+                                         0x19, 0x1A, 0x1B, 0x5F, 0x9F, 0xBF};
+// Inserted and erased ranges are at most this long.
+constexpr size_t kMaxRangeLength = 16;
+
+// Returns a random index into a container of the given size, which must not
+// be empty.
+size_t RandomIndex(size_t size, std::mt19937* rng) {
+  return std::uniform_int_distribution<size_t>(0, size - 1)(*rng);
+}
+
+// Returns a random length for a range starting at the position.
+size_t RandomRangeLength(size_t size, size_t position, std::mt19937* rng) {
+  return std::uniform_int_distribution<size_t>(
+      1, std::min(kMaxRangeLength, size - position))(*rng);
+}
+
+void MutateOnce(MutationOperator mutation_operator, std::mt19937* rng,
+                std::vector<uint8_t>* data) {
+  if (data->empty() &&
+      mutation_operator != MutationOperator::kInsertRandomBytes) {
+    return;
+  }
+  std::uniform_int_distribution<int> byte_distribution(0, 255);
+  switch (mutation_operator) {
+    case MutationOperator::kNone:
+      return;
+    case MutationOperator::kFlipBit:
+      (*data)[RandomIndex(data->size(), rng)] ^=
+          1 << std::uniform_int_distribution<int>(0, 7)(*rng);
+      return;
+    case MutationOperator::kSetRandomByte:
+      (*data)[RandomIndex(data->size(), rng)] = byte_distribution(*rng);
+      return;
+    case MutationOperator::kSetInterestingByte:
+      (*data)[RandomIndex(data->size(), rng)] = kInterestingBytes[RandomIndex(
+          std::size(kInterestingBytes), rng)];
+      return;
+    case MutationOperator::kInsertRandomBytes: {
+      const size_t position = RandomIndex(data->size() + 1, rng);
+      const size_t length = std::uniform_int_distribution<size_t>(
+          1, kMaxRangeLength)(*rng);
+      std::vector<uint8_t> bytes(length);
+      for (uint8_t& byte : bytes) {
+        byte = byte_distribution(*rng);
+      }
+      data->insert(data->begin() + position, bytes.begin(), bytes.end());
+      return;
+    }
+    case MutationOperator::kEraseBytes: {
+      const size_t position = RandomIndex(data->size(), rng);
+      const size_t length = RandomRangeLength(data->size(), position, rng);
+      data->erase(data->begin() + position, data->begin() + position + length);
+      return;
+    }
+    case MutationOperator::kDuplicateBytes: {
+      const size_t source = RandomIndex(data->size(), rng);
+      const size_t length = RandomRangeLength(data->size(), source, rng);
+      const size_t destination = RandomIndex(data->size() + 1, rng);
+      const std::vector<uint8_t> bytes(data->begin() + source,
+                                       data->begin() + source + length);
+      data->insert(data->begin() + destination, bytes.begin(), bytes.end());
+      return;
+    }
+    default:
+      CHECK(false) << "unreachable default - TEST SUITE BUG";
+  }
+}
+
+}  // namespace
+
+std::string MutationOperatorToString(MutationOperator mutation_operator) {
+  switch (mutation_operator) {
+    case MutationOperator::kNone:
+      return "none";
+    case MutationOperator::kFlipBit:
+      return "flip_bit";
+    case MutationOperator::kSetRandomByte:
+      return "set_random_byte";
+    case MutationOperator::kSetInterestingByte:
+      return "set_interesting_byte";
+    case MutationOperator::kInsertRandomBytes:
+      return "insert_random_bytes";
+    case MutationOperator::kEraseBytes:
+      return "erase_bytes";
+    case MutationOperator::kDuplicateBytes:
+      return "duplicate_bytes";
+    default:
+      CHECK(false) << "unreachable default - TEST SUITE BUG";
+  }
+}
+
+void Mutate(MutationOperator mutation_operator, int max_degree,
+            int max_length, std::mt19937* rng, std::vector<uint8_t>* data) {
+  CHECK_GT(max_degree, 0) << "degree must be positive - TEST SUITE BUG";
+  const int degree = std::uniform_int_distribution<int>(1, max_degree)(*rng);
+  for (int i = 0; i < degree; ++i) {
+    MutateOnce(mutation_operator, rng, data);
+  }
+  if (max_length > 0 && data->size() > static_cast<size_t>(max_length)) {
+    data->resize(max_length);
+  }
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,60 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FUZZING_MUTATOR_H_
+#define FUZZING_MUTATOR_H_
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fido2_tests {
+
+// Ways to change an input before sending it.
+enum class MutationOperator {
+  // Sends the input unchanged.
+  kNone,
+  kFlipBit,
+  kSetRandomByte,
+  // Sets a byte to a boundary value or a CBOR header with a long argument.
+  kSetInterestingByte,
+  kInsertRandomBytes,
+  kEraseBytes,
+  // Copies a part of the input to another position.
+  kDuplicateBytes,
+};
+
+constexpr MutationOperator kAllMutationOperators[] = {
+    MutationOperator::kNone,
+    MutationOperator::kFlipBit,
+    MutationOperator::kSetRandomByte,
+    MutationOperator::kSetInterestingByte,
+    MutationOperator::kInsertRandomBytes,
+    MutationOperator::kEraseBytes,
+    MutationOperator::kDuplicateBytes,
+};
+
+// Returns a name suitable for file names.
+std::string MutationOperatorToString(MutationOperator mutation_operator);
+
+// Applies the operator between 1 and max_degree times to the data. Results
+// longer than a positive max_length are truncated. Operators that need bytes
+// leave empty data unchanged.
+void Mutate(MutationOperator mutation_operator, int max_degree,
+            int max_length, std::mt19937* rng, std::vector<uint8_t>* data);
+
+}  // namespace fido2_tests
+
+#endif  // FUZZING_MUTATOR_H_
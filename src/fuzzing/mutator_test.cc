@@ -0,0 +1,69 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/mutator.h"
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+const std::vector<uint8_t> kSeed = {0xA1, 0x01, 0x58, 0x20, 0x00, 0x01,
+                                    0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+
+TEST(Mutator, TestNoneKeepsInput) {
+  std::mt19937 rng(0);
+  std::vector<uint8_t> data = kSeed;
+  Mutate(MutationOperator::kNone, 10, 0, &rng, &data);
+  EXPECT_EQ(data, kSeed);
+}
+
+TEST(Mutator, TestOperatorsChangeInput) {
+  for (MutationOperator mutation_operator : kAllMutationOperators) {
+    if (mutation_operator == MutationOperator::kNone) continue;
+    std::mt19937 rng(0);
+    int changed_count = 0;
+    for (int i = 0; i < 100; ++i) {
+      std::vector<uint8_t> data = kSeed;
+      Mutate(mutation_operator, 1, 0, &rng, &data);
+      changed_count += data != kSeed;
+    }
+    // Setting a byte to the value it already has is rare.
+    EXPECT_GE(changed_count, 90)
+        << MutationOperatorToString(mutation_operator);
+  }
+}
+
+TEST(Mutator, TestMaxLength) {
+  std::mt19937 rng(0);
+  for (int i = 0; i < 100; ++i) {
+    std::vector<uint8_t> data = kSeed;
+    Mutate(MutationOperator::kInsertRandomBytes, 10, 16, &rng, &data);
+    EXPECT_LE(data.size(), 16);
+  }
+}
+
+TEST(Mutator, TestEmptyInput) {
+  for (MutationOperator mutation_operator : kAllMutationOperators) {
+    std::mt19937 rng(0);
+    std::vector<uint8_t> data;
+    Mutate(mutation_operator, 10, 0, &rng, &data);
+    EXPECT_EQ(data.empty(),
+              mutation_operator != MutationOperator::kInsertRandomBytes)
+        << MutationOperatorToString(mutation_operator);
+  }
+}
+
+}  // namespace
+}  // namespace fido2_tests
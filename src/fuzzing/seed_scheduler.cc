@@ -0,0 +1,132 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/seed_scheduler.h"
+
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+#include "glog/logging.h"
+
+namespace fido2_tests {
+namespace {
+// Each discovery multiplies the base energy of a seed by this much.
+constexpr double kDiscoveryWeight = 4.0;
+// Limits how much faster or slower than average a seed counts.
+constexpr double kMaxSpeedFactor = 4.0;
+// The alias table is rebuilt after this fraction of seeds was updated.
+constexpr size_t kRebuildDivisor = 4;
+}  // namespace
+
+SeedScheduler::SeedScheduler(size_t seed_count)
+    : seed_stats_(seed_count),
+      probabilities_(seed_count),
+      aliases_(seed_count) {
+  RebuildAliasTable();
+}
+
+bool SeedScheduler::RecordExecution(size_t seed,
+                                    const ExecutionFeedback& feedback) {
+  CHECK_LT(seed, seed_stats_.size()) << "unknown seed - TEST SUITE BUG";
+  SeedStats& stats = seed_stats_[seed];
+  stats.executions += 1;
+  stats.total_time += feedback.execution_time;
+  total_executions_ += 1;
+  total_time_ += feedback.execution_time;
+  const bool new_status = seen_statuses_.insert(feedback.status).second;
+  const bool new_shape =
+      seen_shapes_
+          .insert(absl::StrCat(static_cast<int>(feedback.status), ":",
+                               feedback.response_shape))
+          .second;
+  const bool is_discovery = new_status || new_shape;
+  if (is_discovery) {
+    stats.discoveries += 1;
+  }
+
+  updates_since_rebuild_ += 1;
+  if (updates_since_rebuild_ >=
+      std::max<size_t>(1, seed_stats_.size() / kRebuildDivisor)) {
+    RebuildAliasTable();
+  }
+  return is_discovery;
+}
+
+size_t SeedScheduler::Sample(std::mt19937* rng) {
+  CHECK(!seed_stats_.empty()) << "no seeds to sample - TEST SUITE BUG";
+  const size_t seed =
+      std::uniform_int_distribution<size_t>(0, seed_stats_.size() - 1)(*rng);
+  if (std::uniform_real_distribution<double>(0.0, 1.0)(*rng) <
+      probabilities_[seed]) {
+    return seed;
+  }
+  return aliases_[seed];
+}
+
+double SeedScheduler::GetEnergy(size_t seed) const {
+  const SeedStats& stats = seed_stats_[seed];
+  double speed_factor = 1.0;
+  if (stats.executions > 0 && stats.total_time > absl::ZeroDuration()) {
+    const double mean_time =
+        absl::FDivDuration(total_time_, absl::Nanoseconds(total_executions_));
+    const double seed_time = absl::FDivDuration(
+        stats.total_time, absl::Nanoseconds(stats.executions));
+    speed_factor = std::clamp(mean_time / seed_time, 1.0 / kMaxSpeedFactor,
+                              kMaxSpeedFactor);
+  }
+  return (1.0 + kDiscoveryWeight * stats.discoveries) * speed_factor /
+         (1.0 + stats.executions);
+}
+
+void SeedScheduler::RebuildAliasTable() {
+  updates_since_rebuild_ = 0;
+  const size_t seed_count = seed_stats_.size();
+  if (seed_count == 0) return;
+  std::vector<double> scaled_energies(seed_count);
+  double total_energy = 0.0;
+  for (size_t seed = 0; seed < seed_count; ++seed) {
+    scaled_energies[seed] = GetEnergy(seed);
+    total_energy += scaled_energies[seed];
+  }
+  // Scales energies so that their average is 1.
+  std::vector<size_t> small;
+  std::vector<size_t> large;
+  for (size_t seed = 0; seed < seed_count; ++seed) {
+    scaled_energies[seed] *= seed_count / total_energy;
+    (scaled_energies[seed] < 1.0 ? small : large).push_back(seed);
+  }
+  while (!small.empty() && !large.empty()) {
+    const size_t less = small.back();
+    small.pop_back();
+    const size_t more = large.back();
+    probabilities_[less] = scaled_energies[less];
+    aliases_[less] = more;
+    scaled_energies[more] -= 1.0 - scaled_energies[less];
+    if (scaled_energies[more] < 1.0) {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+  // Leftovers are only off from 1 by rounding errors.
+  for (size_t seed : small) {
+    probabilities_[seed] = 1.0;
+    aliases_[seed] = seed;
+  }
+  for (size_t seed : large) {
+    probabilities_[seed] = 1.0;
+    aliases_[seed] = seed;
+  }
+}
+
+}  // namespace fido2_tests
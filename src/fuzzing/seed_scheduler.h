@@ -0,0 +1,86 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FUZZING_SEED_SCHEDULER_H_
+#define FUZZING_SEED_SCHEDULER_H_
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/time/time.h"
+#include "src/constants.h"
+
+namespace fido2_tests {
+
+// What the device did with one input.
+struct ExecutionFeedback {
+  Status status;
+  // Describes the structure of the response, see
+  // fuzzing_helpers::ResponseShape.
+  std::string response_shape;
+  absl::Duration execution_time;
+};
+
+// Decides which seed of a corpus to run next. Each seed has an energy, and
+// seeds are picked with a probability proportional to it. Seeds that caused
+// responses never seen before gain energy, while slow seeds and seeds that
+// were picked often lose energy. This spends device time on productive seeds.
+// Samples come from an alias table. An alias table can not be patched for a
+// single changed energy, and every execution also changes the average
+// execution time that all energies depend on. So instead of updating entries
+// incrementally, the whole table is rebuilt in linear time after a quarter of
+// the seeds were updated. That is constant time per execution amortized, not
+// in the worst case.
+class SeedScheduler {
+ public:
+  explicit SeedScheduler(size_t seed_count);
+  // Updates the seed's statistics with the result of running it. Returns
+  // whether the execution revealed a new status or response shape.
+  bool RecordExecution(size_t seed, const ExecutionFeedback& feedback);
+  // Picks a seed in constant time. Fails if there are no seeds.
+  size_t Sample(std::mt19937* rng);
+  // Returns the current energy of the seed.
+  double GetEnergy(size_t seed) const;
+
+ private:
+  struct SeedStats {
+    uint32_t executions = 0;
+    // How many of the executions revealed a new status or response shape.
+    uint32_t discoveries = 0;
+    absl::Duration total_time = absl::ZeroDuration();
+  };
+
+  // Builds the alias table from the current energies with Vose's method.
+  void RebuildAliasTable();
+
+  std::vector<SeedStats> seed_stats_;
+  absl::Duration total_time_ = absl::ZeroDuration();
+  uint32_t total_executions_ = 0;
+  absl::flat_hash_set<Status> seen_statuses_;
+  absl::flat_hash_set<std::string> seen_shapes_;
+  // The alias table: a seed is picked uniformly, and kept with its
+  // probability, or replaced by its alias otherwise.
+  std::vector<double> probabilities_;
+  std::vector<size_t> aliases_;
+  // Counts executions since the last rebuild. In between rebuilds, samples
+  // use energies that are slightly out of date.
+  size_t updates_since_rebuild_ = 0;
+};
+
+}  // namespace fido2_tests
+
+#endif  // FUZZING_SEED_SCHEDULER_H_
@@ -0,0 +1,80 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/seed_scheduler.h"
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+const ExecutionFeedback kPlainFeedback = {
+    .status = Status::kErrInvalidCbor,
+    .response_shape = "",
+    .execution_time = absl::Milliseconds(10)};
+
+TEST(SeedScheduler, TestSamplesUniformlyAtStart) {
+  SeedScheduler scheduler(4);
+  std::mt19937 rng(0);
+  std::vector<int> counts(4);
+  for (int i = 0; i < 40000; ++i) {
+    counts[scheduler.Sample(&rng)] += 1;
+  }
+  for (int count : counts) {
+    EXPECT_NEAR(count, 10000, 500);
+  }
+}
+
+TEST(SeedScheduler, TestDiscoveriesGainEnergy) {
+  SeedScheduler scheduler(2);
+  EXPECT_TRUE(scheduler.RecordExecution(0, kPlainFeedback));
+  EXPECT_FALSE(scheduler.RecordExecution(1, kPlainFeedback));
+  // Only the first execution discovered the status.
+  const double energy = scheduler.GetEnergy(1);
+  EXPECT_GT(scheduler.GetEnergy(0), energy);
+  EXPECT_TRUE(
+      scheduler.RecordExecution(1, {.status = Status::kErrNone,
+                                    .response_shape = "{1:bytes}",
+                                    .execution_time = absl::Milliseconds(10)}));
+  EXPECT_GT(scheduler.GetEnergy(1), energy);
+
+  std::mt19937 rng(0);
+  int seed_one_count = 0;
+  for (int i = 0; i < 10000; ++i) {
+    seed_one_count += scheduler.Sample(&rng);
+  }
+  const double expected_share =
+      scheduler.GetEnergy(1) /
+      (scheduler.GetEnergy(0) + scheduler.GetEnergy(1));
+  EXPECT_NEAR(seed_one_count / 10000.0, expected_share, 0.02);
+}
+
+TEST(SeedScheduler, TestRepetitionsAndSlownessLoseEnergy) {
+  SeedScheduler scheduler(3);
+  scheduler.RecordExecution(0, kPlainFeedback);
+  const double energy = scheduler.GetEnergy(0);
+  scheduler.RecordExecution(0, kPlainFeedback);
+  EXPECT_LT(scheduler.GetEnergy(0), energy);
+
+  scheduler.RecordExecution(1, {.status = Status::kErrInvalidCbor,
+                                .response_shape = "",
+                                .execution_time = absl::Milliseconds(1)});
+  scheduler.RecordExecution(2, {.status = Status::kErrInvalidCbor,
+                                .response_shape = "",
+                                .execution_time = absl::Milliseconds(100)});
+  EXPECT_GT(scheduler.GetEnergy(1), scheduler.GetEnergy(2));
+}
+
+}  // namespace
+}  // namespace fido2_tests
@@ -0,0 +1,81 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FUZZING_SPSC_RING_BUFFER_H_
+#define FUZZING_SPSC_RING_BUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace fido2_tests {
+
+// A bounded queue between exactly one producer thread and one consumer
+// thread. Neither side ever takes a lock, so the consumer is never blocked by
+// a producer that was descheduled while holding one.
+template <typename T>
+class SpscRingBuffer {
+ public:
+  // The capacity must be a power of two.
+  explicit SpscRingBuffer(size_t capacity)
+      : slots_(capacity), mask_(capacity - 1) {
+    CHECK(capacity > 0 && (capacity & mask_) == 0)
+        << "capacity must be a power of two - TEST SUITE BUG";
+  }
+  SpscRingBuffer(const SpscRingBuffer&) = delete;
+  SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+  // Appends the item, unless the buffer is full. Only the producer thread may
+  // call this. The item is only moved from on success.
+  bool TryPush(T&& item) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[tail & mask_] = std::move(item);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves the oldest item to the argument, unless the buffer is empty. Only
+  // the consumer thread may call this.
+  bool TryPop(T* item) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *item = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  // Keeps the indices on separate cache lines, so that both threads don't
+  // invalidate each other's cache on every operation.
+  static constexpr size_t kCacheLineSize = 64;
+
+  std::vector<T> slots_;
+  const size_t mask_;
+  // The number of items popped so far, written by the consumer.
+  alignas(kCacheLineSize) std::atomic<size_t> head_ = 0;
+  // The number of items pushed so far, written by the producer.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_ = 0;
+};
+
+}  // namespace fido2_tests
+
+#endif  // FUZZING_SPSC_RING_BUFFER_H_
@@ -0,0 +1,63 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/fuzzing/spsc_ring_buffer.h"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+TEST(SpscRingBuffer, TestFullAndEmpty) {
+  SpscRingBuffer<int> ring_buffer(2);
+  int item;
+  EXPECT_FALSE(ring_buffer.TryPop(&item));
+  EXPECT_TRUE(ring_buffer.TryPush(1));
+  EXPECT_TRUE(ring_buffer.TryPush(2));
+  EXPECT_FALSE(ring_buffer.TryPush(3));
+  ASSERT_TRUE(ring_buffer.TryPop(&item));
+  EXPECT_EQ(item, 1);
+  EXPECT_TRUE(ring_buffer.TryPush(3));
+  ASSERT_TRUE(ring_buffer.TryPop(&item));
+  EXPECT_EQ(item, 2);
+  ASSERT_TRUE(ring_buffer.TryPop(&item));
+  EXPECT_EQ(item, 3);
+  EXPECT_FALSE(ring_buffer.TryPop(&item));
+}
+
+TEST(SpscRingBuffer, TestKeepsOrderAcrossThreads) {
+  constexpr int kItemCount = 100000;
+  SpscRingBuffer<std::vector<int>> ring_buffer(8);
+  std::thread producer([&ring_buffer] {
+    for (int i = 0; i < kItemCount; ++i) {
+      std::vector<int> item = {i, -i};
+      while (!ring_buffer.TryPush(std::move(item))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::vector<int> item;
+  for (int i = 0; i < kItemCount; ++i) {
+    while (!ring_buffer.TryPop(&item)) {
+      std::this_thread::yield();
+    }
+    ASSERT_EQ(item, std::vector<int>({i, -i}));
+  }
+  producer.join();
+}
+
+}  // namespace
+}  // namespace fido2_tests
@@ -0,0 +1,73 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/adaptive_timeout.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "glog/logging.h"
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+// Commands need this many samples before their timeout is learned.
+constexpr uint32_t kMinSamples = 20;
+// The percentile of latencies that a timeout is based on.
+constexpr double kPercentile = 99.9;
+// Timeouts are this multiple of the percentile, to tolerate rare outliers
+// beyond it, like flash garbage collection.
+constexpr double kMargin = 4.0;
+}  // namespace
+
+AdaptiveTimeout::AdaptiveTimeout(absl::Duration fallback_timeout,
+                                 absl::Duration min_timeout)
+    : fallback_timeout_(fallback_timeout), min_timeout_(min_timeout) {
+  CHECK(min_timeout <= fallback_timeout)
+      << "timeout bounds are swapped - TEST SUITE BUG";
+}
+
+void AdaptiveTimeout::Record(uint8_t command_byte, absl::Duration latency) {
+  const double micros = std::max(1.0, absl::ToDoubleMicroseconds(latency));
+  const int bucket = std::min(
+      kBucketCount - 1,
+      static_cast<int>(std::ceil(kSubBucketCount * std::log2(micros))));
+  LatencyHistogram& histogram = histograms_[command_byte];
+  histogram.counts[bucket] += 1;
+  histogram.total += 1;
+}
+
+absl::Duration AdaptiveTimeout::GetTimeout(uint8_t command_byte) const {
+  auto entry = histograms_.find(command_byte);
+  if (entry == histograms_.end() || entry->second.total < kMinSamples) {
+    return fallback_timeout_;
+  }
+  const LatencyHistogram& histogram = entry->second;
+  // The number of samples at or below the percentile, rounded up.
+  const uint32_t rank = static_cast<uint32_t>(
+      std::ceil(histogram.total * kPercentile / 100.0));
+  uint32_t count = 0;
+  int bucket = 0;
+  for (; bucket < kBucketCount - 1; ++bucket) {
+    count += histogram.counts[bucket];
+    if (count >= rank) break;
+  }
+  // Each bucket holds latencies up to its upper bound.
+  const absl::Duration percentile = absl::Microseconds(
+      std::exp2(static_cast<double>(bucket) / kSubBucketCount));
+  return std::clamp(kMargin * percentile, min_timeout_, fallback_timeout_);
+}
+
+}  // namespace hid
+}  // namespace fido2_tests
@@ -0,0 +1,64 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HID_ADAPTIVE_TIMEOUT_H_
+#define HID_ADAPTIVE_TIMEOUT_H_
+
+#include <array>
+#include <cstdint>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/time/time.h"
+
+namespace fido2_tests {
+namespace hid {
+
+// Learns how long a device takes to answer each command, and derives receive
+// timeouts from it. The timeout of a command is a multiple of the 99.9th
+// percentile of its latencies. Until a command has enough samples, and for
+// slow commands, the fallback timeout is used. Fast rejections can push a
+// timeout below the latency of a valid response, so timeouts are hints that
+// responses are late, not proof that they are lost. Record late responses as
+// well, so that the timeout grows.
+class AdaptiveTimeout {
+ public:
+  // Learned timeouts are kept between the minimum and the fallback timeout.
+  AdaptiveTimeout(absl::Duration fallback_timeout, absl::Duration min_timeout);
+  // Records the time until the first response to the command arrived.
+  void Record(uint8_t command_byte, absl::Duration latency);
+  // Returns how long the first response to the command usually takes at most.
+  absl::Duration GetTimeout(uint8_t command_byte) const;
+
+ private:
+  // Buckets grow by a factor of 2^(1/4), so a percentile is at most 19% off.
+  // The last bucket starts at 2^23 microseconds, which is about 8 seconds.
+  static constexpr int kSubBucketCount = 4;
+  static constexpr int kBucketCount = 23 * kSubBucketCount + 1;
+
+  // Latencies are counted in logarithmic buckets, so that recording is
+  // constant time and memory.
+  struct LatencyHistogram {
+    std::array<uint32_t, kBucketCount> counts = {};
+    uint32_t total = 0;
+  };
+
+  const absl::Duration fallback_timeout_;
+  const absl::Duration min_timeout_;
+  absl::flat_hash_map<uint8_t, LatencyHistogram> histograms_;
+};
+
+}  // namespace hid
+}  // namespace fido2_tests
+
+#endif  // HID_ADAPTIVE_TIMEOUT_H_
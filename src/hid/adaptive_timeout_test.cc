@@ -0,0 +1,83 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/adaptive_timeout.h"
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+
+constexpr absl::Duration kFallback = absl::Seconds(5);
+constexpr absl::Duration kMinimum = absl::Milliseconds(100);
+
+TEST(AdaptiveTimeout, TestFallbackWithoutSamples) {
+  AdaptiveTimeout timeout(kFallback, kMinimum);
+  for (int i = 0; i < 19; ++i) {
+    timeout.Record(0x01, absl::Milliseconds(10));
+  }
+  EXPECT_EQ(timeout.GetTimeout(0x01), kFallback);
+  EXPECT_EQ(timeout.GetTimeout(0x02), kFallback);
+}
+
+TEST(AdaptiveTimeout, TestLearnsPerCommand) {
+  AdaptiveTimeout timeout(kFallback, kMinimum);
+  for (int i = 0; i < 1000; ++i) {
+    timeout.Record(0x01, absl::Milliseconds(50));
+    timeout.Record(0x02, absl::Milliseconds(1));
+  }
+  // Buckets overestimate by less than 19%, and the margin is 4.
+  EXPECT_GE(timeout.GetTimeout(0x01), absl::Milliseconds(200));
+  EXPECT_LE(timeout.GetTimeout(0x01), absl::Milliseconds(240));
+  EXPECT_EQ(timeout.GetTimeout(0x02), kMinimum);
+}
+
+TEST(AdaptiveTimeout, TestOutliersRaiseTimeout) {
+  AdaptiveTimeout timeout(kFallback, kMinimum);
+  for (int i = 0; i < 997; ++i) {
+    timeout.Record(0x01, absl::Milliseconds(50));
+  }
+  EXPECT_LE(timeout.GetTimeout(0x01), absl::Milliseconds(240));
+  // With three slow samples in a thousand, the 99.9th percentile is slow.
+  for (int i = 0; i < 3; ++i) {
+    timeout.Record(0x01, absl::Milliseconds(600));
+  }
+  EXPECT_GE(timeout.GetTimeout(0x01), absl::Milliseconds(2400));
+  EXPECT_LE(timeout.GetTimeout(0x01), absl::Milliseconds(2880));
+  for (int i = 0; i < 3; ++i) {
+    timeout.Record(0x01, absl::Seconds(20));
+  }
+  EXPECT_EQ(timeout.GetTimeout(0x01), kFallback);
+}
+
+TEST(AdaptiveTimeout, TestSlowResponseAfterFastRejections) {
+  AdaptiveTimeout timeout(kFallback, kMinimum);
+  for (int i = 0; i < 1000; ++i) {
+    timeout.Record(0x01, absl::Milliseconds(1));
+  }
+  // A valid response that needs user presence is late, but not lost.
+  const absl::Duration slow_latency = absl::Milliseconds(800);
+  EXPECT_LT(timeout.GetTimeout(0x01), slow_latency);
+  for (int i = 0; i < 2; ++i) {
+    timeout.Record(0x01, slow_latency);
+  }
+  // Late responses are recorded, so the next slow ones are on time.
+  EXPECT_GE(timeout.GetTimeout(0x01), slow_latency);
+  EXPECT_LE(timeout.GetTimeout(0x01), kFallback);
+}
+
+}  // namespace
+}  // namespace hid
+}  // namespace fido2_tests
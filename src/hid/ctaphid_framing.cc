@@ -0,0 +1,145 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/ctaphid_framing.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+constexpr uint8_t kTypeInitMask = 0x80;
+// Offsets and sizes of the frame layout.
+constexpr size_t kInitHeaderSize = 7;
+constexpr size_t kContHeaderSize = 5;
+constexpr size_t kInitDataSize = kHidFrameSize - kInitHeaderSize;
+constexpr size_t kContDataSize = kHidFrameSize - kContHeaderSize;
+constexpr size_t kMaxDataSize = kInitDataSize + 128 * kContDataSize;
+
+uint32_t ReadChannel(absl::Span<const uint8_t> frame) {
+  return (static_cast<uint32_t>(frame[0]) << 24) |
+         (static_cast<uint32_t>(frame[1]) << 16) |
+         (static_cast<uint32_t>(frame[2]) << 8) |
+         (static_cast<uint32_t>(frame[3]) << 0);
+}
+
+RawFrame StartFrame(uint32_t cid) {
+  RawFrame frame;
+  frame.fill(0xEE);
+  frame[0] = (cid >> 24) & 0xFF;
+  frame[1] = (cid >> 16) & 0xFF;
+  frame[2] = (cid >> 8) & 0xFF;
+  frame[3] = cid & 0xFF;
+  return frame;
+}
+}  // namespace
+
+std::vector<RawFrame> SplitIntoFrames(uint32_t cid, const HidMessage& message) {
+  absl::Span<const uint8_t> payload = message.payload;
+  CHECK_LE(payload.size(), kMaxDataSize) << "message too long - TEST SUITE BUG";
+  std::vector<RawFrame> frames;
+  frames.reserve(1 + (payload.size() + kContDataSize - 1) / kContDataSize);
+
+  RawFrame frame = StartFrame(cid);
+  frame[4] = message.cmd | kTypeInitMask;
+  frame[5] = (payload.size() >> 8) & 0xFF;
+  frame[6] = payload.size() & 0xFF;
+  size_t chunk_size = std::min(payload.size(), kInitDataSize);
+  std::copy_n(payload.begin(), chunk_size, frame.begin() + kInitHeaderSize);
+  payload.remove_prefix(chunk_size);
+  frames.push_back(frame);
+
+  for (uint8_t seq = 0; !payload.empty(); ++seq) {
+    frame = StartFrame(cid);
+    frame[4] = seq;
+    chunk_size = std::min(payload.size(), kContDataSize);
+    std::copy_n(payload.begin(), chunk_size, frame.begin() + kContHeaderSize);
+    payload.remove_prefix(chunk_size);
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+MessageAssembler::MessageAssembler(uint32_t cid) : cid_(cid) {}
+
+void MessageAssembler::SetChannel(uint32_t cid) {
+  cid_ = cid;
+  Restart();
+}
+
+MessageAssembler::State MessageAssembler::AddFrame(
+    absl::Span<const uint8_t> frame) {
+  CHECK_EQ(frame.size(), kHidFrameSize) << "wrong frame size - TEST SUITE BUG";
+  if (ReadChannel(frame) != cid_) {
+    return State::kIncomplete;
+  }
+  size_t chunk_size;
+  if (frame[4] & kTypeInitMask) {
+    if (is_receiving_) {
+      Restart();
+      error_ = Status::kErrInvalidSeq;
+      return State::kError;
+    }
+    remaining_size_ = frame[5] * 256u + frame[6];
+    if (remaining_size_ > kMaxDataSize) {
+      error_ = Status::kErrInvalidLength;
+      return State::kError;
+    }
+    message_.cmd = frame[4];
+    message_.payload.clear();
+    message_.payload.reserve(remaining_size_);
+    is_receiving_ = true;
+    chunk_size = std::min(remaining_size_, kInitDataSize);
+    message_.payload.insert(message_.payload.end(),
+                            frame.begin() + kInitHeaderSize,
+                            frame.begin() + kInitHeaderSize + chunk_size);
+  } else {
+    // Continuation frames without an initialization frame are ignored.
+    if (!is_receiving_) {
+      return State::kIncomplete;
+    }
+    if (frame[4] != next_seq_++) {
+      Restart();
+      error_ = Status::kErrInvalidSeq;
+      return State::kError;
+    }
+    chunk_size = std::min(remaining_size_, kContDataSize);
+    message_.payload.insert(message_.payload.end(),
+                            frame.begin() + kContHeaderSize,
+                            frame.begin() + kContHeaderSize + chunk_size);
+  }
+  remaining_size_ -= chunk_size;
+  if (remaining_size_ > 0) {
+    return State::kIncomplete;
+  }
+  is_receiving_ = false;
+  next_seq_ = 0;
+  return State::kComplete;
+}
+
+HidMessage MessageAssembler::TakeMessage() { return std::move(message_); }
+
+Status MessageAssembler::GetError() const { return error_; }
+
+void MessageAssembler::Restart() {
+  is_receiving_ = false;
+  remaining_size_ = 0;
+  next_seq_ = 0;
+  message_.payload.clear();
+}
+
+}  // namespace hid
+}  // namespace fido2_tests
@@ -0,0 +1,75 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HID_CTAPHID_FRAMING_H_
+#define HID_CTAPHID_FRAMING_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "src/constants.h"
+#include "src/hid/hid_transport.h"
+
+namespace fido2_tests {
+namespace hid {
+
+// A CTAPHID frame as it is on the wire, with the channel ID in network order.
+using RawFrame = std::array<uint8_t, kHidFrameSize>;
+
+// A complete CTAPHID message. The command includes the initialization bit.
+struct HidMessage {
+  uint8_t cmd;
+  std::vector<uint8_t> payload;
+};
+
+// Splits a message into an initialization frame and continuation frames.
+// Unused bytes are filled with 0xEE, like HidDevice does. Fails for payloads
+// that do not fit into 128 continuation frames.
+std::vector<RawFrame> SplitIntoFrames(uint32_t cid, const HidMessage& message);
+
+// Reassembles frames from one channel into a message. Frames from other
+// channels are ignored. The assembler is ready for the next message after it
+// completed one or reported an error.
+class MessageAssembler {
+ public:
+  enum class State { kIncomplete, kComplete, kError };
+
+  explicit MessageAssembler(uint32_t cid);
+  // Changes the channel, e.g. after CTAPHID_INIT. Drops a partial message.
+  void SetChannel(uint32_t cid);
+  // Processes a single frame. On kComplete, TakeMessage returns the message.
+  // On kError, GetError describes the problem.
+  State AddFrame(absl::Span<const uint8_t> frame);
+  // Moves the last completed message out.
+  HidMessage TakeMessage();
+  // Returns the status of the last error.
+  Status GetError() const;
+
+ private:
+  void Restart();
+
+  uint32_t cid_;
+  HidMessage message_;
+  bool is_receiving_ = false;
+  size_t remaining_size_ = 0;
+  uint8_t next_seq_ = 0;
+  Status error_ = Status::kErrNone;
+};
+
+}  // namespace hid
+}  // namespace fido2_tests
+
+#endif  // HID_CTAPHID_FRAMING_H_
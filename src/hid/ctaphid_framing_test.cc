@@ -0,0 +1,103 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/ctaphid_framing.h"
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+
+constexpr uint32_t kCid = 0x01020304;
+
+std::vector<uint8_t> Payload(size_t size) {
+  std::vector<uint8_t> payload(size);
+  for (size_t i = 0; i < size; ++i) {
+    payload[i] = i & 0xFF;
+  }
+  return payload;
+}
+
+TEST(CtaphidFraming, TestSplitIntoFrames) {
+  std::vector<RawFrame> frames =
+      SplitIntoFrames(kCid, {.cmd = 0x90, .payload = Payload(100)});
+  ASSERT_EQ(frames.size(), 2);
+  EXPECT_EQ(frames[0][0], 0x01);
+  EXPECT_EQ(frames[0][3], 0x04);
+  EXPECT_EQ(frames[0][4], 0x90);
+  EXPECT_EQ(frames[0][5], 0x00);
+  EXPECT_EQ(frames[0][6], 100);
+  EXPECT_EQ(frames[0][7], 0x00);
+  EXPECT_EQ(frames[1][4], 0x00);
+  EXPECT_EQ(frames[1][5], 57);
+  EXPECT_EQ(frames[1][5 + 42], 99);
+  EXPECT_EQ(frames[1][5 + 43], 0xEE);
+
+  EXPECT_EQ(SplitIntoFrames(kCid, {.cmd = 0x81, .payload = {}}).size(), 1);
+  EXPECT_EQ(SplitIntoFrames(kCid, {.cmd = 0x81, .payload = Payload(57)}).size(),
+            1);
+  EXPECT_EQ(SplitIntoFrames(kCid, {.cmd = 0x81, .payload = Payload(58)}).size(),
+            2);
+}
+
+TEST(CtaphidFraming, TestReassembles) {
+  for (size_t size : {0, 1, 57, 58, 116, 117, 7609}) {
+    MessageAssembler assembler(kCid);
+    std::vector<RawFrame> frames =
+        SplitIntoFrames(kCid, {.cmd = 0x90, .payload = Payload(size)});
+    for (size_t i = 0; i + 1 < frames.size(); ++i) {
+      EXPECT_EQ(assembler.AddFrame(frames[i]),
+                MessageAssembler::State::kIncomplete);
+    }
+    EXPECT_EQ(assembler.AddFrame(frames.back()),
+              MessageAssembler::State::kComplete);
+    HidMessage message = assembler.TakeMessage();
+    EXPECT_EQ(message.cmd, 0x90);
+    EXPECT_EQ(message.payload, Payload(size));
+  }
+}
+
+TEST(CtaphidFraming, TestIgnoresOtherChannels) {
+  MessageAssembler assembler(kCid);
+  std::vector<RawFrame> other_frames =
+      SplitIntoFrames(0x05060708, {.cmd = 0x90, .payload = Payload(10)});
+  EXPECT_EQ(assembler.AddFrame(other_frames[0]),
+            MessageAssembler::State::kIncomplete);
+  assembler.SetChannel(0x05060708);
+  EXPECT_EQ(assembler.AddFrame(other_frames[0]),
+            MessageAssembler::State::kComplete);
+}
+
+TEST(CtaphidFraming, TestReportsSequenceErrors) {
+  MessageAssembler assembler(kCid);
+  std::vector<RawFrame> frames =
+      SplitIntoFrames(kCid, {.cmd = 0x90, .payload = Payload(200)});
+  EXPECT_EQ(assembler.AddFrame(frames[0]),
+            MessageAssembler::State::kIncomplete);
+  EXPECT_EQ(assembler.AddFrame(frames[2]), MessageAssembler::State::kError);
+  EXPECT_EQ(assembler.GetError(), Status::kErrInvalidSeq);
+
+  // A new message can start after the error.
+  for (size_t i = 0; i + 1 < frames.size(); ++i) {
+    EXPECT_EQ(assembler.AddFrame(frames[i]),
+              MessageAssembler::State::kIncomplete);
+  }
+  EXPECT_EQ(assembler.AddFrame(frames.back()),
+            MessageAssembler::State::kComplete);
+}
+
+}  // namespace
+}  // namespace hid
+}  // namespace fido2_tests
@@ -0,0 +1,403 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/ctaphid_fuzzer.h"
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
+#include "glog/logging.h"
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+constexpr uint32_t kIdBroadcast = 0xFFFFFFFF;
+constexpr size_t kInitNonceSize = 8;
+constexpr size_t kInitRespSize = 17;
+// The largest message that fits into an initialization frame and 128
+// continuation frames.
+constexpr size_t kMaxDataSize = 7609;
+// Continuation frames per message in the scenarios. Messages are kept short,
+// so that the device spends its time on state transitions.
+constexpr size_t kMaxContinuationFrames = 7;
+constexpr uint8_t kCtapHidPing = 0x80 | 0x01;
+constexpr uint8_t kCtapHidInit = 0x80 | 0x06;
+constexpr uint8_t kCtapHidCancel = 0x80 | 0x11;
+constexpr uint8_t kCtapHidKeepalive = 0x80 | 0x3b;
+constexpr uint8_t kCtapHidError = 0x80 | 0x3f;
+
+std::vector<uint8_t> ErrorPayload(Status status) {
+  return {static_cast<uint8_t>(status)};
+}
+
+// The payload size of a message with the given number of continuation
+// frames. The last frame leaves some bytes unused, but at least one is used.
+size_t MessageSize(size_t continuation_frames, size_t unused_bytes) {
+  CHECK_LT(unused_bytes, sizeof(Frame::cont.data))
+      << "last frame would be empty - TEST SUITE BUG";
+  if (continuation_frames == 0) {
+    return sizeof(Frame::init.data) - unused_bytes % sizeof(Frame::init.data);
+  }
+  return sizeof(Frame::init.data) +
+         continuation_frames * sizeof(Frame::cont.data) - unused_bytes;
+}
+}  // namespace
+
+std::string FuzzScenarioToString(FuzzScenario scenario) {
+  switch (scenario) {
+    case FuzzScenario::kOutOfOrderSeq:
+      return "out of order sequence number";
+    case FuzzScenario::kInterleavedInit:
+      return "interleaved INIT";
+    case FuzzScenario::kCidCollision:
+      return "channel collision";
+    case FuzzScenario::kTruncatedContinuation:
+      return "truncated continuation";
+    case FuzzScenario::kOversizedLength:
+      return "oversized length";
+    case FuzzScenario::kCancel:
+      return "CANCEL";
+    default:
+      CHECK(false) << "unreachable default - TEST SUITE BUG";
+  }
+}
+
+CtapHidFuzzer::CtapHidFuzzer(HidTransport* transport, uint32_t seed,
+                             FuzzerTimeouts timeouts)
+    : transport_(transport),
+      rng_(seed),
+      timeouts_(timeouts),
+      assembler_(0),
+      other_assembler_(0) {
+  frames_.reserve(2 * (kMaxContinuationFrames + 2));
+}
+
+Status CtapHidFuzzer::Init() {
+  OK_OR_RETURN(AllocateChannel(&cid_));
+  OK_OR_RETURN(AllocateChannel(&other_cid_));
+  assembler_.SetChannel(cid_);
+  other_assembler_.SetChannel(other_cid_);
+  return Status::kErrNone;
+}
+
+ScenarioOutcome CtapHidFuzzer::Run(FuzzScenario scenario) {
+  // Drops partial messages from earlier sequences.
+  assembler_.SetChannel(cid_);
+  other_assembler_.SetChannel(other_cid_);
+  ScenarioOutcome outcome = {.scenario = scenario,
+                             .conforms = false,
+                             .deviation = "",
+                             .recovery_time = absl::ZeroDuration(),
+                             .locked_up = false};
+  const Expectation expectation = BuildSequence(scenario);
+  if (SendFrames() != Status::kErrNone) {
+    outcome.deviation = "the device stopped accepting frames";
+    outcome.locked_up = true;
+    return outcome;
+  }
+  const absl::Time sent = absl::Now();
+
+  const absl::Duration window =
+      scenario == FuzzScenario::kTruncatedContinuation
+          ? timeouts_.transaction_timeout
+          : timeouts_.response_window;
+  outcome.deviation = CollectAnswers(expectation, window);
+  outcome.conforms = outcome.deviation.empty();
+  outcome.locked_up = !AwaitRecovery(absl::Now() + timeouts_.lockup_timeout);
+  outcome.recovery_time = absl::Now() - sent;
+  return outcome;
+}
+
+ScenarioOutcome CtapHidFuzzer::RunRandom() {
+  return Run(kAllFuzzScenarios[RandomIndex(std::size(kAllFuzzScenarios))]);
+}
+
+Status CtapHidFuzzer::AllocateChannel(uint32_t* cid) {
+  const std::vector<uint8_t> nonce = RandomBytes(kInitNonceSize);
+  frames_.clear();
+  AppendMessage(kIdBroadcast, kCtapHidInit, nonce.size(), nonce);
+  OK_OR_RETURN(SendFrames());
+
+  MessageAssembler assembler(kIdBroadcast);
+  const absl::Time deadline = absl::Now() + timeouts_.lockup_timeout;
+  for (;;) {
+    const absl::Duration timeout = deadline - absl::Now();
+    if (timeout <= absl::ZeroDuration()) return Status::kErrTimeout;
+    OK_OR_RETURN(transport_->ReadFrame(
+        timeout,
+        absl::MakeSpan(reinterpret_cast<uint8_t*>(&response_), kHidFrameSize)));
+    if (assembler.AddFrame(absl::MakeConstSpan(
+            reinterpret_cast<const uint8_t*>(&response_), kHidFrameSize)) !=
+        MessageAssembler::State::kComplete) {
+      continue;
+    }
+    HidMessage message = assembler.TakeMessage();
+    if (message.cmd != kCtapHidInit || message.payload.size() < kInitRespSize ||
+        !std::equal(nonce.begin(), nonce.end(), message.payload.begin())) {
+      continue;
+    }
+    *cid = (static_cast<uint32_t>(message.payload[8]) << 24) |
+           (static_cast<uint32_t>(message.payload[9]) << 16) |
+           (static_cast<uint32_t>(message.payload[10]) << 8) |
+           (static_cast<uint32_t>(message.payload[11]) << 0);
+    return Status::kErrNone;
+  }
+}
+
+void CtapHidFuzzer::AppendMessage(uint32_t cid, uint8_t cmd,
+                                  size_t announced_length,
+                                  const std::vector<uint8_t>& payload) {
+  Frame& init_frame = frames_.emplace_back();
+  init_frame.cid = htonl(cid);
+  init_frame.init.cmd = cmd;
+  init_frame.init.bcnth = (announced_length >> 8) & 0xFF;
+  init_frame.init.bcntl = announced_length & 0xFF;
+  memset(init_frame.init.data, 0xEE, sizeof(init_frame.init.data));
+  size_t offset = std::min(payload.size(), sizeof(init_frame.init.data));
+  std::copy_n(payload.begin(), offset, init_frame.init.data);
+
+  for (uint8_t seq = 0; offset < payload.size(); ++seq) {
+    Frame& frame = frames_.emplace_back();
+    frame.cid = htonl(cid);
+    frame.cont.seq = seq;
+    memset(frame.cont.data, 0xEE, sizeof(frame.cont.data));
+    const size_t chunk_size =
+        std::min(payload.size() - offset, sizeof(frame.cont.data));
+    std::copy_n(payload.begin() + offset, chunk_size, frame.cont.data);
+    offset += chunk_size;
+  }
+}
+
+CtapHidFuzzer::Expectation CtapHidFuzzer::BuildSequence(
+    FuzzScenario scenario) {
+  frames_.clear();
+  switch (scenario) {
+    case FuzzScenario::kOutOfOrderSeq: {
+      const size_t continuations = 1 + RandomIndex(kMaxContinuationFrames);
+      const std::vector<uint8_t> payload = RandomBytes(
+          MessageSize(continuations, RandomIndex(sizeof(Frame::cont.data))));
+      AppendMessage(cid_, kCtapHidPing, payload.size(), payload);
+      // Any other sequence number, skipped ahead or repeated.
+      const size_t index = RandomIndex(continuations);
+      frames_[1 + index].cont.seq = (index + 1 + RandomIndex(127)) % 128;
+      return {{{cid_, kCtapHidError, ErrorPayload(Status::kErrInvalidSeq)}}};
+    }
+    case FuzzScenario::kInterleavedInit: {
+      const size_t continuations = 1 + RandomIndex(kMaxContinuationFrames);
+      const std::vector<uint8_t> payload = RandomBytes(
+          MessageSize(continuations, RandomIndex(sizeof(Frame::cont.data))));
+      AppendMessage(cid_, kCtapHidPing, payload.size(), payload);
+      frames_.resize(1 + RandomIndex(continuations));
+      // An INIT on a busy channel aborts the transaction and keeps the
+      // channel ID.
+      std::vector<uint8_t> nonce = RandomBytes(kInitNonceSize);
+      AppendMessage(cid_, kCtapHidInit, nonce.size(), nonce);
+      for (int shift = 24; shift >= 0; shift -= 8) {
+        nonce.push_back((cid_ >> shift) & 0xFF);
+      }
+      return {{{cid_, kCtapHidInit, nonce}}};
+    }
+    case FuzzScenario::kCidCollision: {
+      const size_t continuations = 1 + RandomIndex(kMaxContinuationFrames);
+      const std::vector<uint8_t> payload = RandomBytes(
+          MessageSize(continuations, RandomIndex(sizeof(Frame::cont.data))));
+      AppendMessage(cid_, kCtapHidPing, payload.size(), payload);
+      const std::vector<uint8_t> other_payload = RandomBytes(kInitNonceSize);
+      AppendMessage(other_cid_, kCtapHidPing, other_payload.size(),
+                    other_payload);
+      // Moves the other channel's frame between the continuation frames.
+      const size_t position = 1 + RandomIndex(continuations);
+      std::rotate(frames_.begin() + position, frames_.end() - 1,
+                  frames_.end());
+      return {{{other_cid_, kCtapHidError,
+                ErrorPayload(Status::kErrChannelBusy)},
+               {cid_, kCtapHidPing, payload}}};
+    }
+    case FuzzScenario::kTruncatedContinuation: {
+      const size_t continuations = 1 + RandomIndex(kMaxContinuationFrames);
+      const std::vector<uint8_t> payload = RandomBytes(
+          MessageSize(continuations, RandomIndex(sizeof(Frame::cont.data))));
+      AppendMessage(cid_, kCtapHidPing, payload.size(), payload);
+      frames_.resize(1 + RandomIndex(continuations));
+      return {{{cid_, kCtapHidError, ErrorPayload(Status::kErrTimeout)}}};
+    }
+    case FuzzScenario::kOversizedLength: {
+      const size_t continuations = RandomIndex(3);
+      const std::vector<uint8_t> payload =
+          RandomBytes(MessageSize(continuations, 0));
+      const size_t announced_length =
+          kMaxDataSize + 1 + RandomIndex(0xFFFF - kMaxDataSize);
+      // Continuation frames after the rejected frame are ignored.
+      AppendMessage(cid_, kCtapHidPing, announced_length, payload);
+      return {{{cid_, kCtapHidError, ErrorPayload(Status::kErrInvalidLength)}}};
+    }
+    case FuzzScenario::kCancel: {
+      const size_t continuations = RandomIndex(kMaxContinuationFrames + 1);
+      const std::vector<uint8_t> payload = RandomBytes(
+          MessageSize(continuations, RandomIndex(sizeof(Frame::cont.data))));
+      AppendMessage(cid_, kCtapHidPing, payload.size(), payload);
+      AppendMessage(cid_, kCtapHidCancel, 0, {});
+      // Position 0 is before the message, the last is after it.
+      const size_t position = RandomIndex(continuations + 2);
+      std::rotate(frames_.begin() + position, frames_.end() - 1,
+                  frames_.end());
+      const Answer echo = {cid_, kCtapHidPing, payload};
+      if (position == 0 || position == continuations + 1) {
+        return {{echo}};
+      }
+      // Inside a message, the specification allows to either ignore the
+      // CANCEL, or to reject it as an unexpected initialization frame.
+      return {{echo},
+              {{cid_, kCtapHidError, ErrorPayload(Status::kErrInvalidSeq)}}};
+    }
+    default:
+      CHECK(false) << "unreachable default - TEST SUITE BUG";
+  }
+}
+
+Status CtapHidFuzzer::SendFrames() {
+  for (const Frame& frame : frames_) {
+    OK_OR_RETURN(transport_->WriteFrame(absl::MakeConstSpan(
+        reinterpret_cast<const uint8_t*>(&frame), sizeof(Frame))));
+  }
+  return Status::kErrNone;
+}
+
+Status CtapHidFuzzer::ReceiveMessage(absl::Time deadline, uint32_t* cid) {
+  const absl::Span<const uint8_t> frame = absl::MakeConstSpan(
+      reinterpret_cast<const uint8_t*>(&response_), sizeof(Frame));
+  for (;;) {
+    const absl::Duration timeout = deadline - absl::Now();
+    if (timeout <= absl::ZeroDuration()) return Status::kErrTimeout;
+    OK_OR_RETURN(transport_->ReadFrame(
+        timeout,
+        absl::MakeSpan(reinterpret_cast<uint8_t*>(&response_), sizeof(Frame))));
+    for (auto [assembler, assembler_cid] :
+         {std::pair(&assembler_, cid_), std::pair(&other_assembler_,
+                                                  other_cid_)}) {
+      switch (assembler->AddFrame(frame)) {
+        case MessageAssembler::State::kIncomplete:
+          break;
+        case MessageAssembler::State::kComplete:
+          last_message_ = assembler->TakeMessage();
+          if (last_message_.cmd == kCtapHidKeepalive) break;
+          *cid = assembler_cid;
+          return Status::kErrNone;
+        case MessageAssembler::State::kError:
+          return assembler->GetError();
+      }
+    }
+  }
+}
+
+std::string CtapHidFuzzer::CollectAnswers(const Expectation& expectation,
+                                          absl::Duration window) {
+  auto matches = [this](const std::vector<Answer>& expected) {
+    if (expected.size() != answers_.size()) return false;
+    // Answers on different channels may arrive in any order.
+    return std::is_permutation(
+        expected.begin(), expected.end(), answers_.begin(),
+        [](const Answer& lhs, const Answer& rhs) {
+          if (lhs.cid != rhs.cid || lhs.cmd != rhs.cmd) return false;
+          if (lhs.cmd != kCtapHidInit) return lhs.payload == rhs.payload;
+          const auto& [shorter, longer] =
+              std::minmax(lhs.payload, rhs.payload,
+                          [](const auto& a, const auto& b) {
+                            return a.size() < b.size();
+                          });
+          return std::equal(shorter.begin(), shorter.end(), longer.begin());
+        });
+  };
+
+  answers_.clear();
+  std::string malformed;
+  const absl::Time deadline = absl::Now() + window;
+  while (std::none_of(expectation.begin(), expectation.end(), matches)) {
+    uint32_t cid;
+    Status status = ReceiveMessage(deadline, &cid);
+    if (status == Status::kErrTimeout || status == Status::kErrOther) break;
+    if (status != Status::kErrNone) {
+      malformed = absl::StrCat(", and malformed frames (error 0x",
+                               absl::Hex(static_cast<uint8_t>(status)), ")");
+      continue;
+    }
+    answers_.push_back({cid, last_message_.cmd, last_message_.payload});
+  }
+  if (std::any_of(expectation.begin(), expectation.end(), matches) &&
+      malformed.empty()) {
+    return "";
+  }
+
+  auto format_answer = [](std::string* out, const Answer& answer) {
+    absl::StrAppend(out, absl::Hex(answer.cid, absl::kZeroPad8), ":",
+                    absl::Hex(answer.cmd, absl::kZeroPad2));
+    if (answer.cmd == kCtapHidError && !answer.payload.empty()) {
+      absl::StrAppend(out, "(0x", absl::Hex(answer.payload[0]), ")");
+    } else {
+      absl::StrAppend(out, "[", answer.payload.size(), "]");
+    }
+  };
+  std::vector<std::string> alternatives;
+  for (const std::vector<Answer>& expected : expectation) {
+    alternatives.push_back(
+        absl::StrCat("{", absl::StrJoin(expected, ", ", format_answer), "}"));
+  }
+  return absl::StrCat("expected ", absl::StrJoin(alternatives, " or "),
+                      ", got {", absl::StrJoin(answers_, ", ", format_answer),
+                      "}", malformed);
+}
+
+bool CtapHidFuzzer::AwaitRecovery(absl::Time deadline) {
+  while (absl::Now() < deadline) {
+    const std::vector<uint8_t> data = RandomBytes(kInitNonceSize);
+    frames_.clear();
+    AppendMessage(cid_, kCtapHidPing, data.size(), data);
+    if (SendFrames() != Status::kErrNone) return false;
+    const absl::Time probe_deadline =
+        std::min(absl::Now() + timeouts_.probe_timeout, deadline);
+    for (;;) {
+      uint32_t cid;
+      Status status = ReceiveMessage(probe_deadline, &cid);
+      if (status == Status::kErrTimeout) break;
+      if (status == Status::kErrOther) return false;
+      if (status == Status::kErrNone && cid == cid_ &&
+          last_message_.cmd == kCtapHidPing && last_message_.payload == data) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+std::vector<uint8_t> CtapHidFuzzer::RandomBytes(size_t size) {
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<uint8_t> bytes(size);
+  for (uint8_t& byte : bytes) {
+    byte = distribution(rng_);
+  }
+  return bytes;
+}
+
+size_t CtapHidFuzzer::RandomIndex(size_t size) {
+  return std::uniform_int_distribution<size_t>(0, size - 1)(rng_);
+}
+
+}  // namespace hid
+}  // namespace fido2_tests
@@ -0,0 +1,151 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HID_CTAPHID_FUZZER_H_
+#define HID_CTAPHID_FUZZER_H_
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "src/constants.h"
+#include "src/hid/ctaphid_framing.h"
+#include "src/hid/hid_transport.h"
+
+namespace fido2_tests {
+namespace hid {
+
+// The adversarial frame sequences of the fuzzer. Each one violates a single
+// rule of the CTAPHID transaction state machine.
+enum class FuzzScenario {
+  // A continuation frame skips or repeats a sequence number.
+  kOutOfOrderSeq,
+  // A CTAPHID_INIT arrives on a channel that is busy receiving a message.
+  kInterleavedInit,
+  // A second channel starts a message while the first one is busy.
+  kCidCollision,
+  // A message stops before all announced bytes arrived.
+  kTruncatedContinuation,
+  // The announced length is larger than any message can be.
+  kOversizedLength,
+  // A CTAPHID_CANCEL arrives at a random point of a message.
+  kCancel,
+};
+
+constexpr FuzzScenario kAllFuzzScenarios[] = {
+    FuzzScenario::kOutOfOrderSeq,
+    FuzzScenario::kInterleavedInit,
+    FuzzScenario::kCidCollision,
+    FuzzScenario::kTruncatedContinuation,
+    FuzzScenario::kOversizedLength,
+    FuzzScenario::kCancel,
+};
+
+// Converts a FuzzScenario to a string for printing.
+std::string FuzzScenarioToString(FuzzScenario scenario);
+
+// How long the fuzzer waits for the device in different phases.
+struct FuzzerTimeouts {
+  // Waiting for answers to a sequence, unless they all arrived earlier.
+  absl::Duration response_window = absl::Milliseconds(50);
+  // Devices abort an incomplete message after their transaction timeout.
+  absl::Duration transaction_timeout = absl::Seconds(3);
+  // Waiting for the answer to a single recovery ping.
+  absl::Duration probe_timeout = absl::Milliseconds(100);
+  // A device that does not recover in this time is locked up.
+  absl::Duration lockup_timeout = absl::Seconds(5);
+};
+
+// The result of running one scenario.
+struct ScenarioOutcome {
+  FuzzScenario scenario;
+  // Whether the device answered as the CTAPHID state machine requires.
+  bool conforms;
+  // Describes the answers if they did not conform.
+  std::string deviation;
+  // Time from the last sent frame until the device echoed a ping again.
+  absl::Duration recovery_time;
+  bool locked_up;
+};
+
+// Sends adversarial frame sequences to a device and checks the answers
+// against a model of the CTAPHID state machine. After each sequence, pings
+// the device until it recovers. All frame buffers are reused between
+// sequences, so that the frame rate is limited by the device.
+class CtapHidFuzzer {
+ public:
+  // The transport must outlive the fuzzer. The same seed produces the same
+  // sequences, so that findings can be reproduced.
+  CtapHidFuzzer(HidTransport* transport, uint32_t seed,
+                FuzzerTimeouts timeouts = {});
+  // Allocates the two channels that the scenarios use. Call it again after
+  // a lockup.
+  Status Init();
+  // Sends a sequence of the given scenario and waits for the device.
+  ScenarioOutcome Run(FuzzScenario scenario);
+  // Same as Run, with a random scenario.
+  ScenarioOutcome RunRandom();
+
+ private:
+  // A message from the device. For expected answers to CTAPHID_INIT, the
+  // payload only needs to match up to its size.
+  struct Answer {
+    uint32_t cid;
+    uint8_t cmd;
+    std::vector<uint8_t> payload;
+  };
+  // Lists of answers that each conform to the specification.
+  using Expectation = std::vector<std::vector<Answer>>;
+
+  // Sends a CTAPHID_INIT on the broadcast channel.
+  Status AllocateChannel(uint32_t* cid);
+  // Appends a message to frames_, announcing the given length. The payload
+  // may be shorter or longer than announced.
+  void AppendMessage(uint32_t cid, uint8_t cmd, size_t announced_length,
+                     const std::vector<uint8_t>& payload);
+  // Fills frames_ and returns the conforming answers.
+  Expectation BuildSequence(FuzzScenario scenario);
+  Status SendFrames();
+  // Reads frames into response_ until one of the channels completed a
+  // message. Returns the channel of the message in last_message_.
+  Status ReceiveMessage(absl::Time deadline, uint32_t* cid);
+  // Collects answers until they match the expectation or the window passed.
+  // Returns a description of the answers if they did not match.
+  std::string CollectAnswers(const Expectation& expectation,
+                             absl::Duration window);
+  // Pings until the device echoes, returns false on a lockup.
+  bool AwaitRecovery(absl::Time deadline);
+  std::vector<uint8_t> RandomBytes(size_t size);
+  size_t RandomIndex(size_t size);
+
+  HidTransport* transport_;
+  std::mt19937 rng_;
+  const FuzzerTimeouts timeouts_;
+  uint32_t cid_ = 0;
+  uint32_t other_cid_ = 0;
+  // The frames of the next sequence, with channel IDs in network order.
+  std::vector<Frame> frames_;
+  Frame response_;
+  MessageAssembler assembler_;
+  MessageAssembler other_assembler_;
+  HidMessage last_message_;
+  std::vector<Answer> answers_;
+};
+
+}  // namespace hid
+}  // namespace fido2_tests
+
+#endif  // HID_CTAPHID_FUZZER_H_
@@ -0,0 +1,189 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/ctaphid_fuzzer.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "absl/time/clock.h"
+#include "gtest/gtest.h"
+#include "src/hid/ctaphid_framing.h"
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+
+constexpr uint32_t kIdBroadcast = 0xFFFFFFFF;
+constexpr uint8_t kCtapHidPing = 0x80 | 0x01;
+constexpr uint8_t kCtapHidInit = 0x80 | 0x06;
+constexpr uint8_t kCtapHidCancel = 0x80 | 0x11;
+constexpr uint8_t kCtapHidError = 0x80 | 0x3f;
+
+// Implements the CTAPHID transaction state machine for PING, INIT and
+// CANCEL. The transaction timeout expires as soon as the host reads while a
+// message is incomplete.
+class ModelDevice : public HidTransport {
+ public:
+  explicit ModelDevice(bool locks_up_on_oversized_length)
+      : locks_up_on_oversized_length_(locks_up_on_oversized_length) {}
+
+  Status WriteFrame(absl::Span<const uint8_t> frame) override {
+    if (locked_up_) return Status::kErrNone;
+    const uint32_t cid = (frame[0] << 24) | (frame[1] << 16) |
+                         (frame[2] << 8) | frame[3];
+    if (frame[4] & 0x80) {
+      ProcessInitFrame(cid, frame);
+    } else if (is_receiving_ && cid == busy_cid_) {
+      ProcessContinuationFrame(frame);
+    }
+    return Status::kErrNone;
+  }
+
+  Status ReadFrame(absl::Duration timeout,
+                   absl::Span<uint8_t> frame) override {
+    if (output_.empty() && is_receiving_) {
+      is_receiving_ = false;
+      Respond(busy_cid_, kCtapHidError, {0x05});
+    }
+    if (output_.empty()) {
+      absl::SleepFor(timeout);
+      return Status::kErrTimeout;
+    }
+    std::copy(output_.front().begin(), output_.front().end(), frame.begin());
+    output_.pop_front();
+    return Status::kErrNone;
+  }
+
+ private:
+  void ProcessInitFrame(uint32_t cid, absl::Span<const uint8_t> frame) {
+    const uint8_t cmd = frame[4];
+    const size_t length = frame[5] * 256u + frame[6];
+    if (cmd == kCtapHidInit) {
+      if (is_receiving_ && cid != busy_cid_) {
+        Respond(cid, kCtapHidError, {0x06});
+        return;
+      }
+      is_receiving_ = false;
+      const uint32_t new_cid = cid == kIdBroadcast ? next_cid_++ : cid;
+      std::vector<uint8_t> payload(frame.begin() + 7, frame.begin() + 15);
+      for (int shift = 24; shift >= 0; shift -= 8) {
+        payload.push_back((new_cid >> shift) & 0xFF);
+      }
+      payload.insert(payload.end(), {2, 0, 0, 0, 0x04});
+      Respond(cid, kCtapHidInit, payload);
+      return;
+    }
+    if (is_receiving_) {
+      if (cid != busy_cid_) {
+        Respond(cid, kCtapHidError, {0x06});
+      } else if (cmd != kCtapHidCancel) {
+        is_receiving_ = false;
+        Respond(cid, kCtapHidError, {0x04});
+      }
+      return;
+    }
+    if (cmd == kCtapHidCancel) return;
+    if (length > 7609) {
+      locked_up_ = locks_up_on_oversized_length_;
+      Respond(cid, kCtapHidError, {0x03});
+      return;
+    }
+    busy_cid_ = cid;
+    message_ = {.cmd = cmd, .payload = {}};
+    remaining_size_ = length;
+    next_seq_ = 0;
+    is_receiving_ = true;
+    Append(frame.subspan(7));
+  }
+
+  void ProcessContinuationFrame(absl::Span<const uint8_t> frame) {
+    if (frame[4] != next_seq_++) {
+      is_receiving_ = false;
+      Respond(busy_cid_, kCtapHidError, {0x04});
+      return;
+    }
+    Append(frame.subspan(5));
+  }
+
+  void Append(absl::Span<const uint8_t> data) {
+    const size_t chunk_size = std::min(data.size(), remaining_size_);
+    message_.payload.insert(message_.payload.end(), data.begin(),
+                            data.begin() + chunk_size);
+    remaining_size_ -= chunk_size;
+    if (remaining_size_ == 0) {
+      is_receiving_ = false;
+      if (message_.cmd == kCtapHidPing) {
+        Respond(busy_cid_, kCtapHidPing, message_.payload);
+      } else {
+        Respond(busy_cid_, kCtapHidError, {0x01});
+      }
+    }
+  }
+
+  void Respond(uint32_t cid, uint8_t cmd, std::vector<uint8_t> payload) {
+    for (const RawFrame& frame :
+         SplitIntoFrames(cid, {.cmd = cmd, .payload = std::move(payload)})) {
+      output_.push_back(frame);
+    }
+  }
+
+  const bool locks_up_on_oversized_length_;
+  bool locked_up_ = false;
+  uint32_t next_cid_ = 1;
+  std::deque<RawFrame> output_;
+  bool is_receiving_ = false;
+  uint32_t busy_cid_ = 0;
+  HidMessage message_;
+  size_t remaining_size_ = 0;
+  uint8_t next_seq_ = 0;
+};
+
+TEST(CtapHidFuzzer, TestConformingDevice) {
+  ModelDevice device(/*locks_up_on_oversized_length=*/false);
+  CtapHidFuzzer fuzzer(&device, /*seed=*/1);
+  ASSERT_EQ(fuzzer.Init(), Status::kErrNone);
+  for (FuzzScenario scenario : kAllFuzzScenarios) {
+    for (int i = 0; i < 50; ++i) {
+      ScenarioOutcome outcome = fuzzer.Run(scenario);
+      EXPECT_TRUE(outcome.conforms)
+          << FuzzScenarioToString(scenario) << ": " << outcome.deviation;
+      EXPECT_FALSE(outcome.locked_up);
+    }
+  }
+}
+
+TEST(CtapHidFuzzer, TestReportsLockup) {
+  ModelDevice device(/*locks_up_on_oversized_length=*/true);
+  CtapHidFuzzer fuzzer(&device, /*seed=*/1,
+                       {.response_window = absl::Milliseconds(5),
+                        .transaction_timeout = absl::Milliseconds(5),
+                        .probe_timeout = absl::Milliseconds(5),
+                        .lockup_timeout = absl::Milliseconds(20)});
+  ASSERT_EQ(fuzzer.Init(), Status::kErrNone);
+  EXPECT_FALSE(fuzzer.Run(FuzzScenario::kCancel).locked_up);
+  ScenarioOutcome outcome = fuzzer.Run(FuzzScenario::kOversizedLength);
+  EXPECT_TRUE(outcome.conforms);
+  EXPECT_TRUE(outcome.locked_up);
+  EXPECT_GE(outcome.recovery_time, absl::Milliseconds(20));
+
+  outcome = fuzzer.Run(FuzzScenario::kOutOfOrderSeq);
+  EXPECT_FALSE(outcome.conforms);
+  EXPECT_EQ(outcome.deviation.rfind("expected {", 0), 0u) << outcome.deviation;
+  EXPECT_TRUE(outcome.locked_up);
+}
+
+}  // namespace
+}  // namespace hid
+}  // namespace fido2_tests
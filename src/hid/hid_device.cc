@@ -17,15 +17,21 @@
 #include <arpa/inet.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 
 #include "absl/strings/str_cat.h"
 #include "absl/time/clock.h"
+#include "absl/types/span.h"
 #include "glog/logging.h"
+#include "hidapi/hidapi.h"
+#include "src/cbor_validator.h"
 #include "src/constants.h"
+#include "third_party/chromium_components_cbor/writer.h"
 
 namespace fido2_tests {
 namespace hid {
@@ -37,6 +43,13 @@ constexpr size_t kInitRespSize = 17;
 constexpr size_t kMaxDataSize = 7609;
 constexpr uint32_t kIdBroadcast = 0xFFFFFFFF;
 constexpr absl::Duration kReceiveTimeout = absl::Milliseconds(5000);
+// Adaptive timeouts never go below this, to absorb scheduling jitter.
+constexpr absl::Duration kMinAdaptiveTimeout = absl::Milliseconds(150);
+// Raw frames are answered quickly or not at all, so waiting longer would only
+// lower the frame rate.
+constexpr absl::Duration kRawDrainTimeout = absl::Milliseconds(5);
+// A device that does not even answer a ping this fast is considered stalled.
+constexpr absl::Duration kStallTimeout = absl::Milliseconds(500);
 constexpr uint8_t kWinkCapabilityMask = 0x01;
 constexpr uint8_t kCborCapabilityMask = 0x04;
 constexpr uint8_t kNmsgCapabilityMask = 0x08;
@@ -47,7 +60,7 @@ constexpr uint8_t kCtap2ErrExtensionLast = 0xEF;
 constexpr uint8_t kCtap2ErrVendorFirst = 0xF0;
 constexpr uint8_t kCtap2ErrVendorLast = 0xF8;
 // Commands in U2F
-constexpr uint8_t kCtapHidPing = Frame::kTypeInitMask | 1;  // NOLINT
+constexpr uint8_t kCtapHidPing = Frame::kTypeInitMask | 1;
 constexpr uint8_t kCtapHidMsg = Frame::kTypeInitMask | 3;   // NOLINT
 constexpr uint8_t kCtapHidLock = Frame::kTypeInitMask | 4;  // NOLINT
 constexpr uint8_t kCtapHidInit = Frame::kTypeInitMask | 6;
@@ -140,6 +153,65 @@ bool IsKnownStatusByte(uint8_t status_byte) {
       return false;
   }
 }
+// Splits a CTAPHID message into frames while it is appended, and sends each
+// frame as soon as it is full. The message length must be known in advance,
+// since it is part of the initialization frame. After a failed send, the rest
+// of the message is dropped and Finish returns the error.
+class FrameWriter : public cbor::Writer::Sink {
+ public:
+  FrameWriter(uint32_t cid, uint8_t cmd, size_t message_size,
+              std::function<Status(Frame*)> send_frame)
+      : remaining_size_(message_size), send_frame_(std::move(send_frame)) {
+    frame_.cid = cid;
+    frame_.init.cmd = Frame::kTypeInitMask | cmd;
+    frame_.init.bcnth = (message_size >> 8) & 255;
+    frame_.init.bcntl = (message_size & 255);
+    memset(frame_.init.data, 0xEE, sizeof(frame_.init.data));
+    payload_ = absl::MakeSpan(frame_.init.data);
+  }
+
+  void Append(absl::Span<const uint8_t> data) override {
+    CHECK_LE(data.size(), remaining_size_)
+        << "message longer than announced - TEST SUITE BUG";
+    remaining_size_ -= data.size();
+    while (!data.empty() && status_ == Status::kErrNone) {
+      if (payload_.empty()) {
+        SendAndStartContinuation();
+      }
+      size_t frame_len = std::min(data.size(), payload_.size());
+      std::copy_n(data.begin(), frame_len, payload_.begin());
+      payload_.remove_prefix(frame_len);
+      data.remove_prefix(frame_len);
+    }
+  }
+
+  // Sends the last frame and returns the first error, if any.
+  Status Finish() {
+    CHECK_EQ(remaining_size_, 0u)
+        << "message shorter than announced - TEST SUITE BUG";
+    if (status_ == Status::kErrNone) {
+      status_ = send_frame_(&frame_);
+    }
+    return status_;
+  }
+
+ private:
+  void SendAndStartContinuation() {
+    status_ = send_frame_(&frame_);
+    frame_.cont.seq = seq_++;
+    memset(frame_.cont.data, 0xEE, sizeof(frame_.cont.data));
+    payload_ = absl::MakeSpan(frame_.cont.data);
+  }
+
+  Frame frame_;
+  // The unused part of the frame's data.
+  absl::Span<uint8_t> payload_;
+  size_t remaining_size_;
+  uint8_t seq_ = 0;
+  Status status_ = Status::kErrNone;
+  std::function<Status(Frame*)> send_frame_;
+};
+
 }  // namespace
 
 HidDevice::HidDevice(DeviceTracker* tracker, std::string_view pathname)
@@ -147,30 +219,25 @@ HidDevice::HidDevice(DeviceTracker* tracker, std::string_view pathname)
 
 HidDevice::HidDevice(DeviceTracker* tracker, std::string_view pathname,
                      bool verbose_logging)
+    : HidDevice(tracker, pathname, verbose_logging, HidBackend::kHidapi) {}
+
+HidDevice::HidDevice(DeviceTracker* tracker, std::string_view pathname,
+                     bool verbose_logging, HidBackend backend)
     : tracker_(tracker),
       verbose_logging_(verbose_logging),
+      backend_(backend),
       device_identifiers_(ReadDeviceIdentifiers(pathname)) {
   std::cout << "Tested device name: " << device_identifiers_.product_name
             << std::endl;
   tracker_->SetDeviceIdentifiers(device_identifiers_);
 }
 
-HidDevice::~HidDevice() {
-  if (dev_) {
-    hid_close(dev_);
-    dev_ = nullptr;
-  }
-}
+HidDevice::~HidDevice() = default;
 
 Status HidDevice::Init() {
-  if (dev_) {
-    hid_close(dev_);
-    dev_ = nullptr;
-  }
-
-  std::string device_path = FindDevicePath();
-  dev_ = hid_open_path(device_path.c_str());
-  CHECK(dev_) << "Unable to open the device at the path: " << device_path;
+  // Closes the old connection first, the path might be the same.
+  transport_.reset();
+  transport_ = OpenHidTransport(backend_, FindDevicePath());
 
   Frame challenge;
   challenge.cid = kIdBroadcast;
@@ -229,14 +296,120 @@ Status HidDevice::ExchangeCbor(Command command,
   // Construct outgoing message.
   // Make sure status byte + payload fit into the allowed number of frames.
   if (1 + payload.size() > kMaxDataSize) return Status::kErrInvalidLength;
-  std::vector<uint8_t> send_data = {static_cast<uint8_t>(command)};
-  send_data.insert(send_data.end(), payload.begin(), payload.end());
+  FrameWriter writer(cid_, kCtapHidCbor, 1 + payload.size(),
+                     [this](Frame* frame) { return SendFrame(frame); });
+  const uint8_t command_byte = static_cast<uint8_t>(command);
+  writer.Append(absl::MakeConstSpan(&command_byte, 1));
+  writer.Append(payload);
+  OK_OR_RETURN(writer.Finish());
+  return ReceiveCborResponse(command_byte, expect_up_check, response_cbor);
+}
+
+Status HidDevice::ExchangeCborRequest(
+    Command command, const cbor::Value& request, bool expect_up_check,
+    std::vector<uint8_t>* response_cbor) const {
+  // The frame header needs the length, so it is computed in a pre-pass.
+  absl::optional<size_t> request_size = cbor::Writer::EncodedSize(request);
+  CHECK(request_size.has_value()) << "encoding went wrong - TEST SUITE BUG";
+  if (1 + *request_size > kMaxDataSize) return Status::kErrInvalidLength;
+  FrameWriter writer(cid_, kCtapHidCbor, 1 + *request_size,
+                     [this](Frame* frame) { return SendFrame(frame); });
+  const uint8_t command_byte = static_cast<uint8_t>(command);
+  writer.Append(absl::MakeConstSpan(&command_byte, 1));
+  cbor::Writer::WriteToSink(request, &writer);
+  OK_OR_RETURN(writer.Finish());
+  return ReceiveCborResponse(command_byte, expect_up_check, response_cbor);
+}
+
+Status HidDevice::ExchangeCborMessage(
+    const std::vector<uint8_t>& message, bool expect_up_check,
+    std::vector<uint8_t>* response_cbor) const {
+  if (message.size() > kMaxDataSize) return Status::kErrInvalidLength;
+  FrameWriter writer(cid_, kCtapHidCbor, message.size(),
+                     [this](Frame* frame) { return SendFrame(frame); });
+  writer.Append(message);
+  OK_OR_RETURN(writer.Finish());
+  // Empty messages share their latencies with the unassigned command 0x00.
+  const uint8_t command_byte = message.empty() ? 0x00 : message[0];
+  return ReceiveCborResponse(command_byte, expect_up_check, response_cbor);
+}
+
+Status HidDevice::ExchangeRawFrames(const std::vector<uint8_t>& data) const {
+  std::array<uint8_t, sizeof(Frame)> report;
+  for (size_t offset = 0; offset < data.size(); offset += report.size()) {
+    size_t report_len = std::min(report.size(), data.size() - offset);
+    std::copy_n(data.begin() + offset, report_len, report.begin());
+    std::fill(report.begin() + report_len, report.end(), 0x00);
+    OK_OR_RETURN(transport_->WriteFrame(report));
+  }
+  const size_t frame_count = (data.size() + report.size() - 1) / report.size();
+  Log(absl::StrCat(">> sent ", frame_count, " raw frames >>"));
+
+  // Drains responses without reassembling them, until the device is quiet.
+  const absl::Time end_time = absl::Now() + kStallTimeout;
+  while (absl::Now() < end_time &&
+         transport_->ReadFrame(kRawDrainTimeout, absl::MakeSpan(report)) ==
+             Status::kErrNone) {
+  }
+  return CheckResponsive();
+}
+
+Status HidDevice::Ping(const std::vector<uint8_t>& data) const {
+  OK_OR_RETURN(SendCommand(kCtapHidPing, data));
+
+  uint8_t cmd;
+  std::vector<uint8_t> recv_data;
+  OK_OR_RETURN(ReceiveCommand(kReceiveTimeout, &cmd, &recv_data));
+  if (cmd != kCtapHidPing) return Status::kErrInvalidCommand;
+  if (recv_data != data) return Status::kErrInvalidLength;
+  return Status::kErrNone;
+}
+
+Status HidDevice::CheckResponsive() const {
+  const std::vector<uint8_t> ping_data = {0x70, 0x69, 0x6E, 0x67};
+  OK_OR_RETURN(SendCommand(kCtapHidPing, ping_data));
+
+  const absl::Time end_time = absl::Now() + kStallTimeout;
+  for (;;) {
+    uint8_t cmd;
+    std::vector<uint8_t> recv_data;
+    Status status = ReceiveCommand(end_time - absl::Now(), &cmd, &recv_data);
+    if (status == Status::kErrTimeout || status == Status::kErrOther) {
+      return status;
+    }
+    if (status != Status::kErrNone) {
+      return Status::kErrNone;
+    }
+    // Late responses to raw frames on the own channel are skipped.
+    if (cmd == kCtapHidPing && recv_data == ping_data) {
+      return Status::kErrNone;
+    }
+  }
+}
 
-  uint8_t cmd = kCtapHidCbor;
-  OK_OR_RETURN(SendCommand(cmd, send_data));
+void HidDevice::EnableAdaptiveTimeouts() {
+  adaptive_timeout_.emplace(kReceiveTimeout, kMinAdaptiveTimeout);
+}
 
+Status HidDevice::ReceiveCborResponse(
+    uint8_t command_byte, bool expect_up_check,
+    std::vector<uint8_t>* response_cbor) const {
+  uint8_t cmd;
   std::vector<uint8_t> recv_data;
+  const absl::Time start = absl::Now();
+  // The learned timeout is only a hint, since a valid response can take much
+  // longer than the rejections a command usually gets.
   OK_OR_RETURN(ReceiveCommand(kReceiveTimeout, &cmd, &recv_data));
+  if (adaptive_timeout_.has_value()) {
+    const absl::Duration latency = absl::Now() - start;
+    if (latency > adaptive_timeout_->GetTimeout(command_byte)) {
+      tracker_->AddObservation(
+          "A response arrived after the learned timeout of its command.",
+          absl::StrCat("command 0x", absl::Hex(command_byte, absl::kZeroPad2),
+                       " took ", absl::ToInt64Milliseconds(latency), " ms"));
+    }
+    adaptive_timeout_->Record(command_byte, latency);
+  }
 
   // The answer might also be a keepalive.
   bool has_sent_prompt = false;
@@ -259,6 +432,7 @@ Status HidDevice::ExchangeCbor(Command command,
 
   response_cbor->insert(response_cbor->end(), recv_data.begin() + 1,
                         recv_data.end());
+  CheckCanonicalResponse(absl::MakeConstSpan(recv_data).subspan(1));
 
   if (has_sent_prompt && !expect_up_check) {
     tracker_->AddObservation("A prompt was sent unexpectedly.");
@@ -272,6 +446,20 @@ Status HidDevice::ExchangeCbor(Command command,
   return ByteToStatus(recv_data[0]);
 }
 
+void HidDevice::CheckCanonicalResponse(
+    absl::Span<const uint8_t> response_cbor) const {
+  if (response_cbor.empty()) {
+    return;
+  }
+  if (std::optional<CborViolation> violation =
+          ValidateCanonicalCbor(response_cbor)) {
+    tracker_->AddObservation(
+        absl::StrCat("A response is not canonical CBOR: ",
+                     violation->KindToString()),
+        absl::StrCat("byte ", violation->offset));
+  }
+}
+
 KeepaliveStatus HidDevice::ProcessKeepalive(
     const std::vector<uint8_t>& data) const {
   if (data.size() != 1) return KeepaliveStatus::kStatusError;
@@ -288,31 +476,10 @@ KeepaliveStatus HidDevice::ProcessKeepalive(
 
 Status HidDevice::SendCommand(uint8_t cmd,
                               const std::vector<uint8_t>& data) const {
-  size_t remaining_data_size = data.size();
-  Frame frame;
-  frame.cid = cid_;
-  frame.init.cmd = Frame::kTypeInitMask | cmd;
-  frame.init.bcnth = (remaining_data_size >> 8) & 255;
-  frame.init.bcntl = (remaining_data_size & 255);
-  int frame_len = std::min(data.size(), sizeof(frame.init.data));
-  memset(frame.init.data, 0xEE, sizeof(frame.init.data));
-  auto data_it = data.begin();
-  std::copy_n(data_it, frame_len, frame.init.data);
-
-  uint8_t seq = 0;
-  do {
-    OK_OR_RETURN(SendFrame(&frame));
-
-    remaining_data_size -= frame_len;
-    data_it += frame_len;
-
-    frame.cont.seq = seq++;
-    frame_len = std::min(remaining_data_size, sizeof(frame.cont.data));
-    memset(frame.cont.data, 0xEE, sizeof(frame.cont.data));
-    std::copy_n(data_it, frame_len, frame.cont.data);
-  } while (remaining_data_size);
-
-  return Status::kErrNone;
+  FrameWriter writer(cid_, cmd, data.size(),
+                     [this](Frame* frame) { return SendFrame(frame); });
+  writer.Append(data);
+  return writer.Finish();
 }
 
 Status HidDevice::ReceiveCommand(absl::Duration timeout, uint8_t* cmd,
@@ -355,37 +522,30 @@ Status HidDevice::ReceiveCommand(absl::Duration timeout, uint8_t* cmd,
 }
 
 Status HidDevice::SendFrame(Frame* frame) const {
-  uint8_t d[1 + sizeof(Frame)];
-  d[0] = 0;                        // un-numbered report
   frame->cid = htonl(frame->cid);  // cid is in network order on the wire
-  std::copy_n(reinterpret_cast<uint8_t*>(frame), sizeof(Frame), d + 1);
+  Status status = transport_->WriteFrame(
+      absl::MakeConstSpan(reinterpret_cast<uint8_t*>(frame), sizeof(Frame)));
   frame->cid = ntohl(frame->cid);
 
-  int hidapi_status = hid_write(dev_, d, sizeof(d));
-  if (hidapi_status == sizeof(d)) {
+  if (status == Status::kErrNone) {
     Log(">> send >>", frame);
-    return Status::kErrNone;
   }
-
-  return Status::kErrOther;
+  return status;
 }
 
 Status HidDevice::ReceiveFrame(absl::Duration timeout, Frame* frame) const {
   if (timeout <= absl::ZeroDuration()) return Status::kErrTimeout;
 
-  int hidapi_status =
-      hid_read_timeout(dev_, reinterpret_cast<uint8_t*>(frame), sizeof(Frame),
-                       absl::ToInt64Milliseconds(timeout));
-  if (hidapi_status == sizeof(Frame)) {
+  Status status = transport_->ReadFrame(
+      timeout,
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(frame), sizeof(Frame)));
+  if (status == Status::kErrNone) {
     frame->cid = ntohl(frame->cid);
     Log("<< recv <<", frame);
-    return Status::kErrNone;
+  } else if (status == Status::kErrTimeout) {
+    Log("timeout");
   }
-
-  if (hidapi_status == -1) return Status::kErrOther;
-
-  Log("timeout");
-  return Status::kErrTimeout;
+  return status;
 }
 
 void HidDevice::Log(std::string_view message) const {
@@ -506,6 +666,18 @@ std::string FindFirstFidoDevicePath() {
   return device_path;
 }
 
+std::vector<std::string> FindAllFidoDevicePaths() {
+  hid_device_info* devs = hid_enumerate(0, 0);  // 0 means all devices.
+  std::vector<std::string> device_paths;
+  for (hid_device_info* cur_dev = devs; cur_dev; cur_dev = cur_dev->next) {
+    if (cur_dev->usage_page == 0xf1d0 /* FIDO specific usage page*/) {
+      device_paths.push_back(cur_dev->path);
+    }
+  }
+  hid_free_enumeration(devs);
+  return device_paths;
+}
+
 }  // namespace hid
 }  // namespace fido2_tests
 
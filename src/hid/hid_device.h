@@ -16,47 +16,24 @@
 #define HID_HID_DEVICE_H_
 
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
-#include "hidapi/hidapi.h"
+#include "absl/types/span.h"
 #include "src/constants.h"
 #include "src/device_interface.h"
 #include "src/device_tracker.h"
+#include "src/hid/adaptive_timeout.h"
+#include "src/hid/hid_transport.h"
+#include "third_party/chromium_components_cbor/values.h"
 
 namespace fido2_tests {
 namespace hid {
 
-struct __attribute__((__packed__)) Frame {
-  static constexpr uint8_t kTypeInitMask = 0x80;
-  static constexpr uint8_t kSeqMask = 0x80;
-
-  uint32_t cid;
-  union {
-    uint8_t type;
-    struct {
-      uint8_t cmd;
-      uint8_t bcnth;
-      uint8_t bcntl;
-      // The frame has 64 bytes, and cid(4) + cmd(1) + and bcn(2) take away 7.
-      uint8_t data[64 - 7];
-    } init;
-    struct {
-      uint8_t seq;
-      // The frame has 64 bytes, and cid(4) + seq(1) take away 5.
-      uint8_t data[64 - 5];
-    } cont;
-  };
-
-  bool IsInitType() const { return type & Frame::kTypeInitMask; }
-
-  uint8_t MaskedSeq() const { return cont.seq & ~kSeqMask; }
-
-  size_t PayloadLength() const { return init.bcnth * 256u + init.bcntl; }
-};
-
 // Utility function that enumerates all connected HID devices that have the
 // FIDO HID usage page (i.e. 0xf1d0) and prints their details on stdout.
 void PrintFidoDevices();
@@ -64,6 +41,9 @@ void PrintFidoDevices();
 // Utility function that returns the first suitable device path found.
 std::string FindFirstFidoDevicePath();
 
+// Utility function that returns the paths of all suitable devices.
+std::vector<std::string> FindAllFidoDevicePaths();
+
 class HidDevice : public DeviceInterface {
  public:
   // The constructor without the third parameter implicitly assumes false.
@@ -74,6 +54,9 @@ class HidDevice : public DeviceInterface {
   // Prepares the object for sending packets. The pathname points to the device.
   HidDevice(DeviceTracker* tracker, std::string_view pathname,
             bool verbose_logging);
+  // Same as above, but talks to the device through the chosen backend.
+  HidDevice(DeviceTracker* tracker, std::string_view pathname,
+            bool verbose_logging, HidBackend backend);
   ~HidDevice() override;
   // In contrast to the constructor, Init sends a package to initilialize the
   // communication with the authenticator and establish a channel ID.
@@ -85,12 +68,41 @@ class HidDevice : public DeviceInterface {
   Status ExchangeCbor(Command command, const std::vector<uint8_t>& payload,
                       bool expect_up_check,
                       std::vector<uint8_t>* response_cbor) const override;
+  // Same as ExchangeCbor, but encodes the request directly into frames, so it
+  // is never buffered as a whole.
+  Status ExchangeCborRequest(
+      Command command, const cbor::Value& request, bool expect_up_check,
+      std::vector<uint8_t>* response_cbor) const override;
+  // Sends the message as is, so that empty messages are possible.
+  Status ExchangeCborMessage(
+      const std::vector<uint8_t>& message, bool expect_up_check,
+      std::vector<uint8_t>* response_cbor) const override;
+  // Writes the data as 64 byte reports, padding the last one with zeros. The
+  // device gets a short time to answer, and its responses are discarded. Then
+  // a CTAPHID_PING on the own channel checks that it is still responsive.
+  Status ExchangeRawFrames(const std::vector<uint8_t>& data) const override;
+  // Sends a CTAPHID_PING with the data and checks that it is echoed back.
+  Status Ping(const std::vector<uint8_t>& data) const;
+  // Learns the latency of each CTAP command from its responses, and reports
+  // responses that take longer than a few times their usual latency. The
+  // learned timeouts are hints only: exchanges still wait for the fixed
+  // timeout, so slow valid responses are not mistaken for hangs.
+  void EnableAdaptiveTimeouts();
 
  private:
   // A received response can be status 0, an error, or a keepalive in case the
   // authenticator still needs time for calculation or user presence. Call this
   // function with the received payload and wait for the next package.
   KeepaliveStatus ProcessKeepalive(const std::vector<uint8_t>& data) const;
+  // Waits for the response to a sent CTAPHID_CBOR command, handling keepalives
+  // and user presence prompts.
+  Status ReceiveCborResponse(uint8_t command_byte, bool expect_up_check,
+                             std::vector<uint8_t>* response_cbor) const;
+  // Pings the own channel and waits a short time for any answer. Error
+  // responses, like a busy channel, count as responsive.
+  Status CheckResponsive() const;
+  // Reports a non-empty response that is not canonical CBOR as an observation.
+  void CheckCanonicalResponse(absl::Span<const uint8_t> response_cbor) const;
   // Sends a CTAPHID command, possibly split into multiple frames.
   Status SendCommand(uint8_t cmd, const std::vector<uint8_t>& data) const;
   // Waits for incoming frames, returning their content in an output parameter.
@@ -113,8 +125,12 @@ class HidDevice : public DeviceInterface {
   DeviceTracker* tracker_;
   // Set by the constructor, decides if the Log function actually print.
   bool verbose_logging_ = false;
-  // This is the device from hdiapi.
-  hid_device* dev_ = nullptr;
+  // Decides which transport Init opens.
+  const HidBackend backend_ = HidBackend::kHidapi;
+  // Opened in Init, and again for every reconnect.
+  std::unique_ptr<HidTransport> transport_;
+  // Set by EnableAdaptiveTimeouts, learns from const exchanges.
+  mutable std::optional<AdaptiveTimeout> adaptive_timeout_;
   // Will be set in Init, starts as broadcast.
   uint32_t cid_ = 0;
   // Kept constant for determinism, might get a setter.
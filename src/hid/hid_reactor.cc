@@ -0,0 +1,292 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/hid_reactor.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+
+#include "absl/time/clock.h"
+#include "glog/logging.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+constexpr uint32_t kIdBroadcast = 0xFFFFFFFF;
+constexpr absl::Duration kReceiveTimeout = absl::Milliseconds(5000);
+constexpr size_t kInitNonceSize = 8;
+constexpr size_t kInitRespSize = 17;
+constexpr uint8_t kCtapHidInit = 0x80 | 0x06;
+constexpr uint8_t kCtapHidKeepalive = 0x80 | 0x3b;
+constexpr uint8_t kCtapHidError = 0x80 | 0x3f;
+// Events handled per epoll_wait call.
+constexpr int kMaxEvents = 64;
+}  // namespace
+
+struct HidReactor::Device {
+  explicit Device(int fd) : fd(fd), assembler(kIdBroadcast) {}
+
+  int fd;
+  bool is_open = true;
+  uint32_t cid = kIdBroadcast;
+  MessageAssembler assembler;
+  // Set while a request is outstanding.
+  Callback callback;
+  absl::Time deadline;
+  // Only set while waiting for a CTAPHID_INIT response.
+  std::vector<uint8_t> init_nonce;
+};
+
+#ifdef __linux__
+
+HidReactor::HidReactor() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+  CHECK(epoll_fd_ >= 0) << "Unable to create an epoll instance";
+}
+
+HidReactor::~HidReactor() {
+  for (const auto& device : devices_) {
+    close(device->fd);
+  }
+  close(epoll_fd_);
+}
+
+int HidReactor::AddDevice(std::string_view pathname) {
+  int fd = open(std::string(pathname).c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  CHECK(fd >= 0) << "Unable to open the device at the path: " << pathname;
+  return AddFileDescriptor(fd);
+}
+
+int HidReactor::AddFileDescriptor(int fd) {
+  const int handle = devices_.size();
+  epoll_event event = {.events = EPOLLIN,
+                       .data = {.u32 = static_cast<uint32_t>(handle)}};
+  CHECK_EQ(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event), 0)
+      << "Unable to watch a file descriptor";
+  devices_.push_back(std::make_unique<Device>(fd));
+  return handle;
+}
+
+void HidReactor::Init(int device, Callback callback) {
+  std::vector<uint8_t> nonce(kInitNonceSize);
+  uint64_t nonce_value = next_nonce_++;
+  for (size_t i = 0; i < kInitNonceSize; ++i) {
+    nonce[i] = (nonce_value >> (8 * i)) & 0xFF;
+  }
+  Device* init_device = devices_[device].get();
+  init_device->init_nonce = nonce;
+  StartRequest(init_device, kIdBroadcast,
+               {.cmd = kCtapHidInit, .payload = std::move(nonce)},
+               std::move(callback));
+}
+
+void HidReactor::Send(int device, HidMessage request, Callback callback) {
+  Device* send_device = devices_[device].get();
+  StartRequest(send_device, send_device->cid, std::move(request),
+               std::move(callback));
+}
+
+void HidReactor::Run() {
+  std::array<epoll_event, kMaxEvents> events;
+  while (outstanding_requests_ > 0) {
+    std::optional<absl::Duration> timeout = NextTimeout();
+    int timeout_ms = -1;
+    if (timeout.has_value()) {
+      timeout_ms = absl::ToInt64Milliseconds(
+          absl::Ceil(std::max(*timeout, absl::ZeroDuration()),
+                     absl::Milliseconds(1)));
+    }
+    int event_count =
+        epoll_wait(epoll_fd_, events.data(), events.size(), timeout_ms);
+    CHECK(event_count >= 0 || errno == EINTR) << "epoll_wait failed";
+    for (int i = 0; i < event_count; ++i) {
+      Device* device = devices_[events[i].data.u32].get();
+      ReadFrames(device);
+      if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+        Close(device);
+      }
+    }
+    ExpireRequests();
+  }
+}
+
+size_t HidReactor::DeviceCount() const { return devices_.size(); }
+
+void HidReactor::StartRequest(Device* device, uint32_t cid, HidMessage request,
+                              Callback callback) {
+  CHECK(!device->callback)
+      << "only one outstanding request per device - TEST SUITE BUG";
+  device->callback = std::move(callback);
+  device->deadline = absl::Now() + kReceiveTimeout;
+  device->assembler.SetChannel(cid);
+  outstanding_requests_ += 1;
+  if (!device->is_open) {
+    Finish(device, Status::kErrOther, {});
+    return;
+  }
+
+  // hidraw expects the report ID first, even for un-numbered reports.
+  std::array<uint8_t, 1 + kHidFrameSize> report;
+  report[0] = 0;
+  for (const RawFrame& frame : SplitIntoFrames(cid, request)) {
+    std::copy(frame.begin(), frame.end(), report.begin() + 1);
+    ssize_t written;
+    do {
+      written = write(device->fd, report.data(), report.size());
+    } while (written == -1 && errno == EINTR);
+    if (written != static_cast<ssize_t>(report.size())) {
+      Finish(device, Status::kErrOther, {});
+      return;
+    }
+  }
+}
+
+void HidReactor::ReadFrames(Device* device) {
+  RawFrame frame;
+  while (device->is_open) {
+    ssize_t received = read(device->fd, frame.data(), frame.size());
+    if (received == -1 && errno == EINTR) {
+      continue;
+    }
+    if (received == -1 && errno == EAGAIN) {
+      return;
+    }
+    if (received <= 0) {
+      Close(device);
+      return;
+    }
+    if (received != static_cast<ssize_t>(frame.size())) {
+      if (device->callback) {
+        Finish(device, Status::kErrOther, {});
+      }
+      continue;
+    }
+    // Frames without a request are answers to requests that timed out.
+    if (!device->callback) {
+      continue;
+    }
+    switch (device->assembler.AddFrame(frame)) {
+      case MessageAssembler::State::kIncomplete:
+        break;
+      case MessageAssembler::State::kError:
+        Finish(device, device->assembler.GetError(), {});
+        break;
+      case MessageAssembler::State::kComplete: {
+        HidMessage message = device->assembler.TakeMessage();
+        if (message.cmd == kCtapHidKeepalive) {
+          device->deadline = absl::Now() + kReceiveTimeout;
+          break;
+        }
+        if (message.cmd == kCtapHidError) {
+          Status status = message.payload.empty()
+                              ? Status::kErrOther
+                              : static_cast<Status>(message.payload[0]);
+          Finish(device, status, std::move(message));
+          break;
+        }
+        if (!device->init_nonce.empty()) {
+          // Responses to other hosts on the broadcast channel are skipped.
+          if (message.cmd != kCtapHidInit ||
+              message.payload.size() != kInitRespSize ||
+              !std::equal(device->init_nonce.begin(),
+                          device->init_nonce.end(),
+                          message.payload.begin())) {
+            break;
+          }
+          device->cid = (static_cast<uint32_t>(message.payload[8]) << 24) |
+                        (static_cast<uint32_t>(message.payload[9]) << 16) |
+                        (static_cast<uint32_t>(message.payload[10]) << 8) |
+                        (static_cast<uint32_t>(message.payload[11]) << 0);
+        }
+        Finish(device, Status::kErrNone, std::move(message));
+        break;
+      }
+    }
+  }
+}
+
+void HidReactor::Close(Device* device) {
+  if (!device->is_open) {
+    return;
+  }
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, device->fd, nullptr);
+  device->is_open = false;
+  if (device->callback) {
+    Finish(device, Status::kErrOther, {});
+  }
+}
+
+void HidReactor::Finish(Device* device, Status status, HidMessage response) {
+  Callback callback = std::move(device->callback);
+  device->callback = nullptr;
+  device->init_nonce.clear();
+  outstanding_requests_ -= 1;
+  // The callback may start the next request of this device.
+  callback(status, std::move(response));
+}
+
+void HidReactor::ExpireRequests() {
+  const absl::Time now = absl::Now();
+  for (const auto& device : devices_) {
+    if (device->callback && device->deadline <= now) {
+      Finish(device.get(), Status::kErrTimeout, {});
+    }
+  }
+}
+
+std::optional<absl::Duration> HidReactor::NextTimeout() const {
+  std::optional<absl::Time> next_deadline;
+  for (const auto& device : devices_) {
+    if (device->callback &&
+        (!next_deadline.has_value() || device->deadline < *next_deadline)) {
+      next_deadline = device->deadline;
+    }
+  }
+  if (!next_deadline.has_value()) {
+    return std::nullopt;
+  }
+  return *next_deadline - absl::Now();
+}
+
+#else
+
+HidReactor::HidReactor() : epoll_fd_(-1) {
+  CHECK(false) << "The HID reactor is only supported on Linux.";
+}
+
+HidReactor::~HidReactor() = default;
+
+int HidReactor::AddDevice(std::string_view pathname) { return -1; }
+
+int HidReactor::AddFileDescriptor(int fd) { return -1; }
+
+void HidReactor::Init(int device, Callback callback) {}
+
+void HidReactor::Send(int device, HidMessage request, Callback callback) {}
+
+void HidReactor::Run() {}
+
+size_t HidReactor::DeviceCount() const { return 0; }
+
+#endif  // __linux__
+
+}  // namespace hid
+}  // namespace fido2_tests
@@ -0,0 +1,93 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HID_HID_REACTOR_H_
+#define HID_HID_REACTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "src/constants.h"
+#include "src/hid/ctaphid_framing.h"
+
+namespace fido2_tests {
+namespace hid {
+
+// Services many HID devices from a single thread. All device file descriptors
+// share one epoll instance. Each device has its own reassembly state and at
+// most one outstanding request. Responses are delivered to callbacks, which
+// usually send the next request of the same device. This way, every device
+// runs a small state machine instead of a blocking thread. Only Linux is
+// supported.
+class HidReactor {
+ public:
+  // Receives the response to a request, or the error that ended it. Runs on
+  // the thread that calls Run.
+  using Callback = std::function<void(Status status, HidMessage response)>;
+
+  HidReactor();
+  ~HidReactor();
+  HidReactor(const HidReactor&) = delete;
+  HidReactor& operator=(const HidReactor&) = delete;
+
+  // Opens a /dev/hidraw* device and returns its handle.
+  int AddDevice(std::string_view pathname);
+  // Takes ownership of an open, nonblocking file descriptor that behaves like
+  // a hidraw device, and returns its handle.
+  int AddFileDescriptor(int fd);
+  // Allocates a channel with CTAPHID_INIT. Later requests to the device use
+  // that channel. The callback receives the INIT response.
+  void Init(int device, Callback callback);
+  // Sends a message and calls the callback with the response. Keepalives are
+  // consumed and extend the timeout. The device must not have an outstanding
+  // request.
+  void Send(int device, HidMessage request, Callback callback);
+  // Processes events until no device has an outstanding request.
+  void Run();
+  // Returns the number of added devices.
+  size_t DeviceCount() const;
+
+ private:
+  struct Device;
+
+  // Sends all frames of a request and starts waiting for the response.
+  void StartRequest(Device* device, uint32_t cid, HidMessage request,
+                    Callback callback);
+  // Reads all queued frames of a device.
+  void ReadFrames(Device* device);
+  // Stops watching a device that was unplugged, and fails its request.
+  void Close(Device* device);
+  // Ends the outstanding request with a status and response.
+  void Finish(Device* device, Status status, HidMessage response);
+  // Fails all requests whose deadline passed.
+  void ExpireRequests();
+  // Returns the time until the next deadline, if any request is outstanding.
+  std::optional<absl::Duration> NextTimeout() const;
+
+  const int epoll_fd_;
+  std::vector<std::unique_ptr<Device>> devices_;
+  size_t outstanding_requests_ = 0;
+  // Makes nonces for CTAPHID_INIT distinct per device.
+  uint64_t next_nonce_ = 0;
+};
+
+}  // namespace hid
+}  // namespace fido2_tests
+
+#endif  // HID_HID_REACTOR_H_
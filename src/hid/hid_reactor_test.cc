@@ -0,0 +1,130 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/hid_reactor.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+
+constexpr uint32_t kIdBroadcast = 0xFFFFFFFF;
+constexpr uint8_t kCtapHidPing = 0x81;
+constexpr uint8_t kCtapHidInit = 0x86;
+constexpr uint8_t kCtapHidKeepalive = 0xBB;
+
+// Answers INIT with a fixed channel, and PING with a keepalive and an echo.
+// Packets on the socket pair stand in for HID reports.
+class FakeDevice {
+ public:
+  explicit FakeDevice(uint32_t cid) : cid_(cid) {
+    int fds[2];
+    EXPECT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds), 0);
+    host_fd_ = fds[0];
+    device_fd_ = fds[1];
+    fcntl(host_fd_, F_SETFL, O_NONBLOCK);
+    thread_ = std::thread([this] { Serve(); });
+  }
+
+  ~FakeDevice() {
+    shutdown(device_fd_, SHUT_RDWR);
+    thread_.join();
+    close(device_fd_);
+  }
+
+  // The reactor takes ownership of this end.
+  int HostFd() const { return host_fd_; }
+
+ private:
+  void Serve() {
+    MessageAssembler assembler(kIdBroadcast);
+    uint8_t report[1 + kHidFrameSize];
+    while (read(device_fd_, report, sizeof(report)) == sizeof(report)) {
+      if (assembler.AddFrame(absl::MakeConstSpan(report + 1, kHidFrameSize)) !=
+          MessageAssembler::State::kComplete) {
+        continue;
+      }
+      HidMessage request = assembler.TakeMessage();
+      if (request.cmd == kCtapHidInit) {
+        HidMessage response = {.cmd = kCtapHidInit, .payload = request.payload};
+        for (int shift : {24, 16, 8, 0}) {
+          response.payload.push_back((cid_ >> shift) & 0xFF);
+        }
+        response.payload.resize(17, 0x00);
+        Respond(kIdBroadcast, response);
+        assembler.SetChannel(cid_);
+      } else {
+        Respond(cid_, {.cmd = kCtapHidKeepalive, .payload = {0x01}});
+        Respond(cid_, request);
+      }
+    }
+  }
+
+  void Respond(uint32_t cid, const HidMessage& message) {
+    for (const RawFrame& frame : SplitIntoFrames(cid, message)) {
+      EXPECT_EQ(write(device_fd_, frame.data(), frame.size()), frame.size());
+    }
+  }
+
+  const uint32_t cid_;
+  int host_fd_;
+  int device_fd_;
+  std::thread thread_;
+};
+
+TEST(HidReactor, TestServesDevicesConcurrently) {
+  constexpr int kDeviceCount = 8;
+  constexpr int kPingsPerDevice = 20;
+  std::vector<std::unique_ptr<FakeDevice>> fake_devices;
+  HidReactor reactor;
+  for (int i = 0; i < kDeviceCount; ++i) {
+    fake_devices.push_back(std::make_unique<FakeDevice>(0x100 + i));
+    reactor.AddFileDescriptor(fake_devices.back()->HostFd());
+  }
+  EXPECT_EQ(reactor.DeviceCount(), kDeviceCount);
+
+  std::vector<int> pongs(kDeviceCount, 0);
+  const std::vector<uint8_t> ping_data(150, 0x5A);
+  std::function<void(int)> ping = [&](int device) {
+    reactor.Send(device, {.cmd = kCtapHidPing, .payload = ping_data},
+                 [&, device](Status status, HidMessage response) {
+                   ASSERT_EQ(status, Status::kErrNone);
+                   EXPECT_EQ(response.cmd, kCtapHidPing);
+                   EXPECT_EQ(response.payload, ping_data);
+                   if (++pongs[device] < kPingsPerDevice) {
+                     ping(device);
+                   }
+                 });
+  };
+  for (int i = 0; i < kDeviceCount; ++i) {
+    reactor.Init(i, [&, i](Status status, HidMessage response) {
+      ASSERT_EQ(status, Status::kErrNone);
+      EXPECT_EQ(response.payload[11], (0x100 + i) & 0xFF);
+      ping(i);
+    });
+  }
+  reactor.Run();
+  EXPECT_EQ(pongs, std::vector<int>(kDeviceCount, kPingsPerDevice));
+}
+
+}  // namespace
+}  // namespace hid
+}  // namespace fido2_tests
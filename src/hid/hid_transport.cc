@@ -0,0 +1,82 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/hid/hid_transport.h"
+
+#include <algorithm>
+#include <string>
+
+#include "glog/logging.h"
+#include "hidapi/hidapi.h"
+
+namespace fido2_tests {
+namespace hid {
+namespace {
+
+class HidapiTransport : public HidTransport {
+ public:
+  explicit HidapiTransport(hid_device* dev) : dev_(dev) {}
+  ~HidapiTransport() override { hid_close(dev_); }
+
+  Status WriteFrame(absl::Span<const uint8_t> frame) override {
+    CHECK_EQ(frame.size(), kHidFrameSize)
+        << "wrong frame size - TEST SUITE BUG";
+    uint8_t report[1 + kHidFrameSize];
+    report[0] = 0;  // un-numbered report
+    std::copy(frame.begin(), frame.end(), report + 1);
+    if (hid_write(dev_, report, sizeof(report)) == sizeof(report)) {
+      return Status::kErrNone;
+    }
+    return Status::kErrOther;
+  }
+
+  Status ReadFrame(absl::Duration timeout,
+                   absl::Span<uint8_t> frame) override {
+    CHECK_EQ(frame.size(), kHidFrameSize)
+        << "wrong frame size - TEST SUITE BUG";
+    int hidapi_status = hid_read_timeout(dev_, frame.data(), frame.size(),
+                                         absl::ToInt64Milliseconds(timeout));
+    if (hidapi_status == static_cast<int>(kHidFrameSize)) {
+      return Status::kErrNone;
+    }
+    if (hidapi_status == -1) return Status::kErrOther;
+    return Status::kErrTimeout;
+  }
+
+ private:
+  hid_device* const dev_;
+};
+
+}  // namespace
+
+std::unique_ptr<HidTransport> OpenHidTransport(HidBackend backend,
+                                               std::string_view pathname) {
+  switch (backend) {
+    case HidBackend::kHidapi:
+      return OpenHidapiTransport(pathname);
+    case HidBackend::kHidraw:
+      return OpenHidrawTransport(pathname);
+    default:
+      CHECK(false) << "unreachable default - TEST SUITE BUG";
+  }
+}
+
+std::unique_ptr<HidTransport> OpenHidapiTransport(std::string_view pathname) {
+  hid_device* dev = hid_open_path(std::string(pathname).c_str());
+  CHECK(dev) << "Unable to open the device at the path: " << pathname;
+  return std::make_unique<HidapiTransport>(dev);
+}
+
+}  // namespace hid
+}  // namespace fido2_tests
@@ -0,0 +1,99 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HID_HID_TRANSPORT_H_
+#define HID_HID_TRANSPORT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "src/constants.h"
+
+namespace fido2_tests {
+namespace hid {
+
+// All CTAPHID frames have this size, without the report ID.
+constexpr size_t kHidFrameSize = 64;
+
+// A CTAPHID frame. HidDevice keeps the channel ID in host order, and converts
+// it when sending and receiving.
+struct __attribute__((__packed__)) Frame {
+  static constexpr uint8_t kTypeInitMask = 0x80;
+  static constexpr uint8_t kSeqMask = 0x80;
+
+  uint32_t cid;
+  union {
+    uint8_t type;
+    struct {
+      uint8_t cmd;
+      uint8_t bcnth;
+      uint8_t bcntl;
+      // The frame has 64 bytes, and cid(4) + cmd(1) + and bcn(2) take away 7.
+      uint8_t data[64 - 7];
+    } init;
+    struct {
+      uint8_t seq;
+      // The frame has 64 bytes, and cid(4) + seq(1) take away 5.
+      uint8_t data[64 - 5];
+    } cont;
+  };
+
+  bool IsInitType() const { return type & Frame::kTypeInitMask; }
+
+  uint8_t MaskedSeq() const { return cont.seq & ~kSeqMask; }
+
+  size_t PayloadLength() const { return init.bcnth * 256u + init.bcntl; }
+};
+static_assert(sizeof(Frame) == kHidFrameSize, "unexpected frame layout");
+
+// Chooses how frames reach the device.
+enum class HidBackend {
+  // Portable, works on all platforms supported by hidapi.
+  kHidapi,
+  // Uses /dev/hidraw* directly with nonblocking I/O and epoll. Linux only.
+  kHidraw,
+};
+
+// Sends and receives raw CTAPHID frames, as they are on the wire.
+class HidTransport {
+ public:
+  virtual ~HidTransport() = default;
+  // Sends a single frame of kHidFrameSize bytes. Returns kErrOther if it was
+  // not written completely.
+  virtual Status WriteFrame(absl::Span<const uint8_t> frame) = 0;
+  // Waits up to the timeout for a single frame of kHidFrameSize bytes.
+  // Returns kErrTimeout if none arrived, and kErrOther on I/O errors.
+  virtual Status ReadFrame(absl::Duration timeout,
+                           absl::Span<uint8_t> frame) = 0;
+};
+
+// Opens the device at the path with the chosen backend. Fails if the device
+// can not be opened.
+std::unique_ptr<HidTransport> OpenHidTransport(HidBackend backend,
+                                               std::string_view pathname);
+
+// Opens the device at the path with hidapi.
+std::unique_ptr<HidTransport> OpenHidapiTransport(std::string_view pathname);
+
+// Opens a /dev/hidraw* device directly. A single read usually suffices per
+// frame, epoll and a timerfd are only involved when the device is not ready.
+std::unique_ptr<HidTransport> OpenHidrawTransport(std::string_view pathname);
+
+}  // namespace hid
+}  // namespace fido2_tests
+
+#endif  // HID_HID_TRANSPORT_H_
@@ -0,0 +1,155 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+
+#include "glog/logging.h"
+#include "src/hid/hid_transport.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace fido2_tests {
+namespace hid {
+
+#ifdef __linux__
+namespace {
+
+// Reads and writes frames with nonblocking syscalls. A frame that is already
+// queued by the kernel costs a single read. Otherwise, a timerfd is armed with
+// the deadline and epoll waits for the device or the timer, whichever is first.
+class HidrawTransport : public HidTransport {
+ public:
+  HidrawTransport(int device_fd, int timer_fd, int epoll_fd)
+      : device_fd_(device_fd), timer_fd_(timer_fd), epoll_fd_(epoll_fd) {}
+  ~HidrawTransport() override {
+    close(epoll_fd_);
+    close(timer_fd_);
+    close(device_fd_);
+  }
+
+  Status WriteFrame(absl::Span<const uint8_t> frame) override {
+    CHECK_EQ(frame.size(), kHidFrameSize)
+        << "wrong frame size - TEST SUITE BUG";
+    // hidraw expects the report ID first, even for un-numbered reports.
+    uint8_t report[1 + kHidFrameSize];
+    report[0] = 0;
+    std::copy(frame.begin(), frame.end(), report + 1);
+    ssize_t written;
+    do {
+      written = write(device_fd_, report, sizeof(report));
+    } while (written == -1 && errno == EINTR);
+    if (written == sizeof(report)) {
+      return Status::kErrNone;
+    }
+    return Status::kErrOther;
+  }
+
+  Status ReadFrame(absl::Duration timeout,
+                   absl::Span<uint8_t> frame) override {
+    CHECK_EQ(frame.size(), kHidFrameSize)
+        << "wrong frame size - TEST SUITE BUG";
+    bool is_timer_armed = false;
+    for (;;) {
+      ssize_t received = read(device_fd_, frame.data(), frame.size());
+      if (received == static_cast<ssize_t>(kHidFrameSize)) {
+        return Status::kErrNone;
+      }
+      if (received >= 0 || (errno != EAGAIN && errno != EINTR)) {
+        return Status::kErrOther;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      if (!is_timer_armed) {
+        if (timeout <= absl::ZeroDuration()) {
+          return Status::kErrTimeout;
+        }
+        // Arming also clears expirations left over from earlier reads.
+        itimerspec deadline = {.it_interval = {},
+                               .it_value = absl::ToTimespec(timeout)};
+        CHECK_EQ(timerfd_settime(timer_fd_, 0, &deadline, nullptr), 0)
+            << "arming the timer failed";
+        is_timer_armed = true;
+      }
+      epoll_event event;
+      int event_count;
+      do {
+        event_count = epoll_wait(epoll_fd_, &event, 1, -1);
+      } while (event_count == -1 && errno == EINTR);
+      if (event_count != 1) {
+        return Status::kErrOther;
+      }
+      if (event.data.fd == timer_fd_) {
+        uint64_t expirations;
+        ssize_t timer_read;
+        do {
+          timer_read = read(timer_fd_, &expirations, sizeof(expirations));
+        } while (timer_read == -1 && errno == EINTR);
+        if (timer_read == sizeof(expirations)) {
+          return Status::kErrTimeout;
+        }
+        // The timer is nonblocking, and EAGAIN means it did not expire yet.
+        if (timer_read >= 0 || errno != EAGAIN) {
+          return Status::kErrOther;
+        }
+        continue;
+      }
+      if (event.events & (EPOLLERR | EPOLLHUP)) {
+        return Status::kErrOther;
+      }
+    }
+  }
+
+ private:
+  const int device_fd_;
+  const int timer_fd_;
+  const int epoll_fd_;
+};
+
+}  // namespace
+
+std::unique_ptr<HidTransport> OpenHidrawTransport(std::string_view pathname) {
+  int device_fd =
+      open(std::string(pathname).c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  CHECK(device_fd >= 0) << "Unable to open the device at the path: "
+                        << pathname;
+  int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  CHECK(timer_fd >= 0) << "Unable to create a timer";
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  CHECK(epoll_fd >= 0) << "Unable to create an epoll instance";
+  for (int fd : {device_fd, timer_fd}) {
+    epoll_event event = {.events = EPOLLIN, .data = {.fd = fd}};
+    CHECK_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event), 0)
+        << "Unable to watch a file descriptor";
+  }
+  return std::make_unique<HidrawTransport>(device_fd, timer_fd, epoll_fd);
+}
+
+#else
+
+std::unique_ptr<HidTransport> OpenHidrawTransport(std::string_view pathname) {
+  CHECK(false) << "The hidraw backend is only supported on Linux.";
+}
+
+#endif  // __linux__
+
+}  // namespace hid
+}  // namespace fido2_tests
@@ -0,0 +1,85 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "src/device_tracker.h"
+#include "src/endurance/latency_recorder.h"
+#include "src/hid/hid_device.h"
+#include "src/hid/hid_transport.h"
+
+DEFINE_string(
+    token_path, "",
+    "The path to the device on your operating system, usually /dev/hidraw*.");
+
+DEFINE_int32(iterations, 1000, "Number of pings per backend and size.");
+
+namespace {
+
+// A ping fills this many frames: the initialization frame holds 57 bytes, and
+// each continuation frame 59 more.
+constexpr int kFrameCounts[] = {1, 4, 16};
+
+size_t PingSize(int frame_count) { return 57 + 59 * (frame_count - 1); }
+
+void Measure(const std::string& name, fido2_tests::hid::HidBackend backend) {
+  fido2_tests::DeviceTracker tracker;
+  fido2_tests::hid::HidDevice device(&tracker, FLAGS_token_path,
+                                     /*verbose_logging=*/false, backend);
+  CHECK(fido2_tests::Status::kErrNone == device.Init())
+      << "CTAPHID initialization failed";
+  for (int frame_count : kFrameCounts) {
+    const std::vector<uint8_t> data(PingSize(frame_count), 0x5A);
+    fido2_tests::LatencyRecorder recorder;
+    for (int i = 0; i < FLAGS_iterations; ++i) {
+      absl::Time start = absl::Now();
+      CHECK(fido2_tests::Status::kErrNone == device.Ping(data))
+          << "ping failed with " << name;
+      recorder.Record(absl::Now() - start);
+    }
+    std::cout << name << ", " << frame_count << " frames each way: mean "
+              << absl::ToDoubleMicroseconds(recorder.Mean()) << " us, p50 "
+              << absl::ToDoubleMicroseconds(recorder.Percentile(50))
+              << " us, p99 "
+              << absl::ToDoubleMicroseconds(recorder.Percentile(99)) << " us"
+              << std::endl;
+  }
+}
+
+}  // namespace
+
+// Measures CTAPHID_PING round trips through hidapi and directly through
+// hidraw on the same device. Pings are answered by the transport layer of the
+// authenticator, so the difference between both is the host overhead.
+// Usage example:
+//   ./hid_benchmark --token_path=/dev/hidraw4 --iterations=500
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_token_path.empty()) {
+    std::cout << "Please add the --token_path flag for one of these devices:"
+              << std::endl;
+    fido2_tests::hid::PrintFidoDevices();
+    return 0;
+  }
+  Measure("hidapi", fido2_tests::hid::HidBackend::kHidapi);
+  Measure("hidraw", fido2_tests::hid::HidBackend::kHidraw);
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "src/endurance/latency_recorder.h"
+#include "src/hid/ctaphid_fuzzer.h"
+#include "src/hid/hid_device.h"
+#include "src/hid/hid_transport.h"
+
+DEFINE_string(
+    token_path, "",
+    "The path to the device on your operating system, usually /dev/hidraw*.");
+
+DEFINE_int32(iterations, 1000, "Number of adversarial sequences to send.");
+
+DEFINE_uint32(seed, 0, "Seed for the sequences, the same seed repeats them.");
+
+DEFINE_bool(hidraw, false,
+            "Talk to the device through /dev/hidraw* directly, Linux only.");
+
+DEFINE_int32(max_reported_deviations, 10,
+             "How many deviations from the specification are printed.");
+
+namespace {
+
+// Summarizes all runs of one scenario.
+struct ScenarioStats {
+  int runs = 0;
+  int deviations = 0;
+  int lockups = 0;
+  fido2_tests::LatencyRecorder recovery;
+};
+
+}  // namespace
+
+// Sends adversarial CTAPHID frame sequences, like out of order sequence
+// numbers or truncated messages, and checks the answers against the
+// specification. After each sequence, the device is pinged until it recovers.
+// Devices that do not recover are reported as locked up.
+// Usage example:
+//   ./hid_fuzzer --token_path=/dev/hidraw4 --iterations=10000 --seed=7
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_token_path.empty()) {
+    std::cout << "Please add the --token_path flag for one of these devices:"
+              << std::endl;
+    fido2_tests::hid::PrintFidoDevices();
+    return 0;
+  }
+
+  std::unique_ptr<fido2_tests::hid::HidTransport> transport =
+      fido2_tests::hid::OpenHidTransport(
+          FLAGS_hidraw ? fido2_tests::hid::HidBackend::kHidraw
+                       : fido2_tests::hid::HidBackend::kHidapi,
+          FLAGS_token_path);
+  fido2_tests::hid::CtapHidFuzzer fuzzer(transport.get(), FLAGS_seed);
+  CHECK(fido2_tests::Status::kErrNone == fuzzer.Init())
+      << "CTAPHID initialization failed";
+
+  std::map<fido2_tests::hid::FuzzScenario, ScenarioStats> stats;
+  int reported_deviations = 0;
+  const absl::Time start = absl::Now();
+  int iteration = 0;
+  for (; iteration < FLAGS_iterations; ++iteration) {
+    fido2_tests::hid::ScenarioOutcome outcome = fuzzer.RunRandom();
+    ScenarioStats& scenario_stats = stats[outcome.scenario];
+    scenario_stats.runs += 1;
+    if (!outcome.conforms) {
+      scenario_stats.deviations += 1;
+      if (reported_deviations++ < FLAGS_max_reported_deviations) {
+        std::cout << "Iteration " << iteration << ", "
+                  << FuzzScenarioToString(outcome.scenario) << ": "
+                  << outcome.deviation << std::endl;
+      }
+    }
+    if (outcome.locked_up) {
+      scenario_stats.lockups += 1;
+      std::cout << "Iteration " << iteration << ", "
+                << FuzzScenarioToString(outcome.scenario)
+                << ": the device locked up." << std::endl;
+      if (fuzzer.Init() != fido2_tests::Status::kErrNone) {
+        std::cout << "The device does not answer CTAPHID_INIT anymore. Please "
+                     "replug it and rerun with --seed="
+                  << FLAGS_seed << "." << std::endl;
+        ++iteration;
+        break;
+      }
+      continue;
+    }
+    scenario_stats.recovery.Record(outcome.recovery_time);
+  }
+  const absl::Duration elapsed = absl::Now() - start;
+
+  std::cout << "Ran " << iteration << " sequences in " << elapsed << ", "
+            << iteration / absl::ToDoubleSeconds(elapsed)
+            << " sequences per second." << std::endl;
+  for (const auto& [scenario, scenario_stats] : stats) {
+    std::cout << FuzzScenarioToString(scenario) << ": " << scenario_stats.runs
+              << " runs, " << scenario_stats.deviations << " deviations, "
+              << scenario_stats.lockups << " lockups, recovery p50 "
+              << scenario_stats.recovery.Percentile(50) << ", max "
+              << scenario_stats.recovery.Max() << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,102 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "src/hid/hid_device.h"
+#include "src/hid/hid_reactor.h"
+
+DEFINE_int32(seconds, 10, "How long each device is pinged.");
+
+DEFINE_int32(ping_size, 57,
+             "Payload bytes per ping, 57 fit into a single frame.");
+
+namespace {
+constexpr uint8_t kCtapHidPing = 0x81;
+
+// Counts the round trips of one device.
+struct DeviceStats {
+  std::string path;
+  int pings = 0;
+  // Stays at most 1, failing devices are dropped.
+  int failures = 0;
+};
+}  // namespace
+
+// Pings all plugged FIDO devices at the same time from a single thread, to
+// check that a test hub can be saturated without a thread per device.
+// Usage example:
+//   ./hub_ping --seconds=30 --ping_size=1024
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  fido2_tests::hid::HidReactor reactor;
+  std::vector<DeviceStats> stats;
+  for (const std::string& path : fido2_tests::hid::FindAllFidoDevicePaths()) {
+    reactor.AddDevice(path);
+    stats.push_back({.path = path});
+  }
+  if (stats.empty()) {
+    std::cout << "No FIDO devices found." << std::endl;
+    return 0;
+  }
+
+  const absl::Time end_time = absl::Now() + absl::Seconds(FLAGS_seconds);
+  const std::vector<uint8_t> ping_data(FLAGS_ping_size, 0x5A);
+  // Each device pings again as soon as its last ping returned.
+  std::function<void(int)> ping = [&](int device) {
+    if (absl::Now() >= end_time) {
+      return;
+    }
+    reactor.Send(device, {.cmd = kCtapHidPing, .payload = ping_data},
+                 [&, device](fido2_tests::Status status,
+                             fido2_tests::hid::HidMessage response) {
+                   // A failing device is not pinged again.
+                   if (status != fido2_tests::Status::kErrNone ||
+                       response.payload != ping_data) {
+                     stats[device].failures += 1;
+                     return;
+                   }
+                   stats[device].pings += 1;
+                   ping(device);
+                 });
+  };
+  for (size_t device = 0; device < stats.size(); ++device) {
+    reactor.Init(device, [&, device](fido2_tests::Status status,
+                                     fido2_tests::hid::HidMessage response) {
+      if (status == fido2_tests::Status::kErrNone) {
+        ping(device);
+      } else {
+        stats[device].failures += 1;
+      }
+    });
+  }
+  reactor.Run();
+
+  for (const DeviceStats& device_stats : stats) {
+    std::cout << device_stats.path << ": "
+              << device_stats.pings / static_cast<double>(FLAGS_seconds)
+              << " pings per second, " << device_stats.failures << " failures"
+              << std::endl;
+  }
+  return 0;
+}
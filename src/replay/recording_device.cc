@@ -0,0 +1,105 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/replay/recording_device.h"
+
+#include "absl/time/clock.h"
+
+namespace fido2_tests {
+
+RecordingDevice::RecordingDevice(std::unique_ptr<DeviceInterface> device,
+                                 std::string_view trace_path,
+                                 const DeviceIdentifiers& device_identifiers)
+    : device_(std::move(device)),
+      trace_start_(absl::Now()),
+      trace_writer_(trace_path, device_identifiers) {}
+
+Status RecordingDevice::Init() {
+  const absl::Time start = absl::Now();
+  Status status = device_->Init();
+  trace_writer_.Append({.type = TraceEventType::kInit,
+                        .start = start - trace_start_,
+                        .duration = absl::Now() - start,
+                        .status = status,
+                        .command = {},
+                        .expect_up_check = false,
+                        .request = {},
+                        .response = {}});
+  return status;
+}
+
+Status RecordingDevice::Wink() {
+  const absl::Time start = absl::Now();
+  Status status = device_->Wink();
+  trace_writer_.Append({.type = TraceEventType::kWink,
+                        .start = start - trace_start_,
+                        .duration = absl::Now() - start,
+                        .status = status,
+                        .command = {},
+                        .expect_up_check = false,
+                        .request = {},
+                        .response = {}});
+  return status;
+}
+
+Status RecordingDevice::ExchangeCbor(
+    Command command, const std::vector<uint8_t>& payload, bool expect_up_check,
+    std::vector<uint8_t>* response_cbor) const {
+  const absl::Time start = absl::Now();
+  Status status =
+      device_->ExchangeCbor(command, payload, expect_up_check, response_cbor);
+  trace_writer_.Append({.type = TraceEventType::kExchangeCbor,
+                        .start = start - trace_start_,
+                        .duration = absl::Now() - start,
+                        .status = status,
+                        .command = command,
+                        .expect_up_check = expect_up_check,
+                        .request = payload,
+                        .response = *response_cbor});
+  return status;
+}
+
+Status RecordingDevice::ExchangeCborMessage(
+    const std::vector<uint8_t>& message, bool expect_up_check,
+    std::vector<uint8_t>* response_cbor) const {
+  const absl::Time start = absl::Now();
+  Status status =
+      device_->ExchangeCborMessage(message, expect_up_check, response_cbor);
+  trace_writer_.Append({.type = TraceEventType::kExchangeCborMessage,
+                        .start = start - trace_start_,
+                        .duration = absl::Now() - start,
+                        .status = status,
+                        .command = {},
+                        .expect_up_check = expect_up_check,
+                        .request = message,
+                        .response = *response_cbor});
+  return status;
+}
+
+Status RecordingDevice::ExchangeRawFrames(
+    const std::vector<uint8_t>& data) const {
+  const absl::Time start = absl::Now();
+  Status status = device_->ExchangeRawFrames(data);
+  trace_writer_.Append({.type = TraceEventType::kExchangeRawFrames,
+                        .start = start - trace_start_,
+                        .duration = absl::Now() - start,
+                        .status = status,
+                        .command = {},
+                        .expect_up_check = false,
+                        .request = data,
+                        .response = {}});
+  return status;
+}
+
+}  // namespace fido2_tests
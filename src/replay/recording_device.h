@@ -0,0 +1,57 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REPLAY_RECORDING_DEVICE_H_
+#define REPLAY_RECORDING_DEVICE_H_
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "src/constants.h"
+#include "src/device_interface.h"
+#include "src/replay/trace.h"
+
+namespace fido2_tests {
+
+// Forwards all calls to another device and records them in a trace file, so
+// that the run can be replayed with a ReplayDevice.
+class RecordingDevice : public DeviceInterface {
+ public:
+  // The device identifiers are written into the trace, so that replays report
+  // the same device.
+  RecordingDevice(std::unique_ptr<DeviceInterface> device,
+                  std::string_view trace_path,
+                  const DeviceIdentifiers& device_identifiers);
+  Status Init() override;
+  Status Wink() override;
+  Status ExchangeCbor(Command command, const std::vector<uint8_t>& payload,
+                      bool expect_up_check,
+                      std::vector<uint8_t>* response_cbor) const override;
+  Status ExchangeCborMessage(
+      const std::vector<uint8_t>& message, bool expect_up_check,
+      std::vector<uint8_t>* response_cbor) const override;
+  Status ExchangeRawFrames(const std::vector<uint8_t>& data) const override;
+
+ private:
+  const std::unique_ptr<DeviceInterface> device_;
+  const absl::Time trace_start_;
+  // Written from const calls, recording does not change the device state.
+  mutable TraceWriter trace_writer_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // REPLAY_RECORDING_DEVICE_H_
@@ -0,0 +1,104 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/replay/replay_device.h"
+
+#include "absl/time/clock.h"
+#include "glog/logging.h"
+
+namespace fido2_tests {
+
+ReplayDevice::ReplayDevice(DeviceTracker* tracker, Trace trace,
+                           ReplayTiming timing)
+    : trace_(std::move(trace)), timing_(timing) {
+  tracker->SetDeviceIdentifiers(trace_.device_identifiers);
+}
+
+Status ReplayDevice::Init() {
+  const TraceEvent& event = NextEvent(TraceEventType::kInit);
+  Wait(event);
+  return event.status;
+}
+
+Status ReplayDevice::Wink() {
+  const TraceEvent& event = NextEvent(TraceEventType::kWink);
+  Wait(event);
+  return event.status;
+}
+
+Status ReplayDevice::ExchangeCbor(Command command,
+                                  const std::vector<uint8_t>& payload,
+                                  bool expect_up_check,
+                                  std::vector<uint8_t>* response_cbor) const {
+  const TraceEvent& event = NextEvent(TraceEventType::kExchangeCbor);
+  CHECK(event.command == command)
+      << "replay diverged at event " << next_event_ - 1 << ", expected command "
+      << static_cast<int>(event.command) << " instead of "
+      << static_cast<int>(command);
+  if (event.request != payload) {
+    request_mismatch_count_ += 1;
+  }
+  Wait(event);
+  *response_cbor = event.response;
+  return event.status;
+}
+
+Status ReplayDevice::ExchangeCborMessage(
+    const std::vector<uint8_t>& message, bool expect_up_check,
+    std::vector<uint8_t>* response_cbor) const {
+  const TraceEvent& event = NextEvent(TraceEventType::kExchangeCborMessage);
+  if (event.request != message) {
+    request_mismatch_count_ += 1;
+  }
+  Wait(event);
+  *response_cbor = event.response;
+  return event.status;
+}
+
+Status ReplayDevice::ExchangeRawFrames(const std::vector<uint8_t>& data) const {
+  const TraceEvent& event = NextEvent(TraceEventType::kExchangeRawFrames);
+  if (event.request != data) {
+    request_mismatch_count_ += 1;
+  }
+  Wait(event);
+  return event.status;
+}
+
+size_t ReplayDevice::GetRequestMismatchCount() const {
+  return request_mismatch_count_;
+}
+
+size_t ReplayDevice::GetRemainingEventCount() const {
+  return trace_.events.size() - next_event_;
+}
+
+const TraceEvent& ReplayDevice::NextEvent(TraceEventType type) const {
+  CHECK(next_event_ < trace_.events.size())
+      << "replay diverged, the trace has no more events";
+  const TraceEvent& event = trace_.events[next_event_];
+  CHECK(event.type == type)
+      << "replay diverged at event " << next_event_ << ", expected type "
+      << static_cast<int>(event.type) << " instead of "
+      << static_cast<int>(type);
+  next_event_ += 1;
+  return event;
+}
+
+void ReplayDevice::Wait(const TraceEvent& event) const {
+  if (timing_ == ReplayTiming::kOriginalTiming) {
+    absl::SleepFor(event.duration);
+  }
+}
+
+}  // namespace fido2_tests
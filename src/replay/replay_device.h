@@ -0,0 +1,74 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REPLAY_REPLAY_DEVICE_H_
+#define REPLAY_REPLAY_DEVICE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "src/constants.h"
+#include "src/device_interface.h"
+#include "src/device_tracker.h"
+#include "src/replay/trace.h"
+
+namespace fido2_tests {
+
+// Decides how fast a ReplayDevice answers.
+enum class ReplayTiming {
+  // Returns responses immediately, to profile the host side.
+  kFullSpeed,
+  // Waits as long as the recorded device did for each call.
+  kOriginalTiming,
+};
+
+// Answers calls with the responses from a recorded trace, in order. The calls
+// must match the recording in type and command, otherwise the replay diverged
+// and fails. Requests may differ, because the host uses fresh randomness, e.g.
+// for key agreement. Responses that depend on it, like encrypted PIN tokens,
+// do not decrypt then.
+class ReplayDevice : public DeviceInterface {
+ public:
+  // Reports the recorded device identifiers to the tracker, like a real device.
+  ReplayDevice(DeviceTracker* tracker, Trace trace, ReplayTiming timing);
+  Status Init() override;
+  Status Wink() override;
+  Status ExchangeCbor(Command command, const std::vector<uint8_t>& payload,
+                      bool expect_up_check,
+                      std::vector<uint8_t>* response_cbor) const override;
+  Status ExchangeCborMessage(
+      const std::vector<uint8_t>& message, bool expect_up_check,
+      std::vector<uint8_t>* response_cbor) const override;
+  Status ExchangeRawFrames(const std::vector<uint8_t>& data) const override;
+  // Returns how many exchanges sent a different request than recorded.
+  size_t GetRequestMismatchCount() const;
+  // Returns how many recorded calls were not replayed yet.
+  size_t GetRemainingEventCount() const;
+
+ private:
+  // Returns the next event, which must have the given type.
+  const TraceEvent& NextEvent(TraceEventType type) const;
+  // Waits for the recorded duration, if the timing asks for it.
+  void Wait(const TraceEvent& event) const;
+
+  const Trace trace_;
+  const ReplayTiming timing_;
+  // Replaying is a const operation for ExchangeCbor, but advances the trace.
+  mutable size_t next_event_ = 0;
+  mutable size_t request_mismatch_count_ = 0;
+};
+
+}  // namespace fido2_tests
+
+#endif  // REPLAY_REPLAY_DEVICE_H_
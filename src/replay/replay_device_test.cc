@@ -0,0 +1,120 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/replay/replay_device.h"
+
+#include <filesystem>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "src/replay/recording_device.h"
+
+namespace fido2_tests {
+namespace {
+
+// Echoes requests with the command byte prepended.
+class EchoDevice : public DeviceInterface {
+ public:
+  Status Init() override { return Status::kErrNone; }
+  Status Wink() override { return Status::kErrInvalidCommand; }
+  Status ExchangeCbor(Command command, const std::vector<uint8_t>& payload,
+                      bool expect_up_check,
+                      std::vector<uint8_t>* response_cbor) const override {
+    *response_cbor = {static_cast<uint8_t>(command)};
+    response_cbor->insert(response_cbor->end(), payload.begin(),
+                          payload.end());
+    return Status::kErrNone;
+  }
+  // Echoes messages unchanged and also accepts empty ones, unlike the default.
+  Status ExchangeCborMessage(
+      const std::vector<uint8_t>& message, bool expect_up_check,
+      std::vector<uint8_t>* response_cbor) const override {
+    *response_cbor = message;
+    return Status::kErrNone;
+  }
+};
+
+const DeviceIdentifiers kIdentifiers = {.manufacturer = "M",
+                                        .product_name = "P",
+                                        .serial_number = "S",
+                                        .vendor_id = 1,
+                                        .product_id = 2};
+
+std::string TracePath() {
+  return (std::filesystem::path(::testing::TempDir()) / "replay.trace")
+      .string();
+}
+
+void RecordExample() {
+  RecordingDevice device(std::make_unique<EchoDevice>(), TracePath(),
+                         kIdentifiers);
+  std::vector<uint8_t> response;
+  EXPECT_EQ(device.Init(), Status::kErrNone);
+  EXPECT_EQ(device.Wink(), Status::kErrInvalidCommand);
+  EXPECT_EQ(device.ExchangeCbor(Command::kAuthenticatorGetInfo, {0xAA}, false,
+                                &response),
+            Status::kErrNone);
+  EXPECT_EQ(response, std::vector<uint8_t>({0x04, 0xAA}));
+  EXPECT_EQ(device.ExchangeRawFrames({0xCC}), Status::kErrInvalidCommand);
+}
+
+TEST(ReplayDevice, TestReplaysRecording) {
+  RecordExample();
+  DeviceTracker tracker;
+  ReplayDevice device(&tracker, ReadTrace(TracePath()),
+                      ReplayTiming::kFullSpeed);
+  EXPECT_EQ(tracker.GetDeviceIdentifiers().product_name, "P");
+  EXPECT_EQ(device.GetRemainingEventCount(), 4);
+  std::vector<uint8_t> response;
+  EXPECT_EQ(device.Init(), Status::kErrNone);
+  EXPECT_EQ(device.Wink(), Status::kErrInvalidCommand);
+  EXPECT_EQ(device.ExchangeCbor(Command::kAuthenticatorGetInfo, {0xBB}, false,
+                                &response),
+            Status::kErrNone);
+  EXPECT_EQ(response, std::vector<uint8_t>({0x04, 0xAA}));
+  EXPECT_EQ(device.ExchangeRawFrames({0xCC}), Status::kErrInvalidCommand);
+  EXPECT_EQ(device.GetRequestMismatchCount(), 1);
+  EXPECT_EQ(device.GetRemainingEventCount(), 0);
+  std::filesystem::remove(TracePath());
+}
+
+TEST(ReplayDevice, TestReplaysUnknownCommandBytes) {
+  {
+    RecordingDevice device(std::make_unique<EchoDevice>(), TracePath(),
+                           kIdentifiers);
+    std::vector<uint8_t> response;
+    EXPECT_EQ(device.ExchangeCborMessage({0x41, 0xAA}, false, &response),
+              Status::kErrNone);
+    EXPECT_EQ(response, std::vector<uint8_t>({0x41, 0xAA}));
+    EXPECT_EQ(device.ExchangeCborMessage({}, false, &response),
+              Status::kErrNone);
+    EXPECT_TRUE(response.empty());
+  }
+  DeviceTracker tracker;
+  ReplayDevice device(&tracker, ReadTrace(TracePath()),
+                      ReplayTiming::kFullSpeed);
+  std::vector<uint8_t> response;
+  EXPECT_EQ(device.ExchangeCborMessage({0x41, 0xAA}, false, &response),
+            Status::kErrNone);
+  EXPECT_EQ(response, std::vector<uint8_t>({0x41, 0xAA}));
+  EXPECT_EQ(device.ExchangeCborMessage({}, false, &response),
+            Status::kErrNone);
+  EXPECT_TRUE(response.empty());
+  EXPECT_EQ(device.GetRequestMismatchCount(), 0);
+  EXPECT_EQ(device.GetRemainingEventCount(), 0);
+  std::filesystem::remove(TracePath());
+}
+
+}  // namespace
+}  // namespace fido2_tests
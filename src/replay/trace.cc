@@ -0,0 +1,173 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/replay/trace.h"
+
+#include <iterator>
+#include <optional>
+#include <string>
+
+#include "glog/logging.h"
+
+namespace fido2_tests {
+namespace {
+constexpr std::string_view kMagic = "FIDOTRC1";
+
+void AppendVarint(uint64_t value, std::string* buffer) {
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<char>(value));
+}
+
+void AppendBytes(std::string_view bytes, std::string* buffer) {
+  AppendVarint(bytes.size(), buffer);
+  buffer->append(bytes);
+}
+
+void AppendBytes(const std::vector<uint8_t>& bytes, std::string* buffer) {
+  AppendBytes(std::string_view(reinterpret_cast<const char*>(bytes.data()),
+                               bytes.size()),
+              buffer);
+}
+
+// Reads values from a trace in memory. All reads return std::nullopt once the
+// input is exhausted.
+class TraceReader {
+ public:
+  explicit TraceReader(std::string_view data) : data_(data) {}
+
+  bool IsAtEnd() const { return data_.empty(); }
+
+  std::optional<uint64_t> ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (data_.empty()) {
+        return std::nullopt;
+      }
+      const uint8_t byte = data_.front();
+      data_.remove_prefix(1);
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::optional<std::string_view> ReadBytes() {
+    std::optional<uint64_t> size = ReadVarint();
+    if (!size.has_value() || *size > data_.size()) {
+      return std::nullopt;
+    }
+    std::string_view bytes = data_.substr(0, *size);
+    data_.remove_prefix(*size);
+    return bytes;
+  }
+
+ private:
+  std::string_view data_;
+};
+
+std::optional<TraceEvent> ReadEvent(TraceReader* reader) {
+  std::optional<uint64_t> type = reader->ReadVarint();
+  std::optional<uint64_t> start_us = reader->ReadVarint();
+  std::optional<uint64_t> duration_us = reader->ReadVarint();
+  std::optional<uint64_t> status = reader->ReadVarint();
+  std::optional<uint64_t> command = reader->ReadVarint();
+  std::optional<uint64_t> expect_up_check = reader->ReadVarint();
+  std::optional<std::string_view> request = reader->ReadBytes();
+  std::optional<std::string_view> response = reader->ReadBytes();
+  if (!type || !start_us || !duration_us || !status || !command ||
+      !expect_up_check || !request || !response) {
+    return std::nullopt;
+  }
+  CHECK(*type <= static_cast<uint64_t>(TraceEventType::kExchangeCborMessage))
+      << "unknown trace event type " << *type;
+  return TraceEvent{
+      .type = static_cast<TraceEventType>(*type),
+      .start = absl::Microseconds(*start_us),
+      .duration = absl::Microseconds(*duration_us),
+      .status = static_cast<Status>(*status),
+      .command = static_cast<Command>(*command),
+      .expect_up_check = *expect_up_check != 0,
+      .request = std::vector<uint8_t>(request->begin(), request->end()),
+      .response = std::vector<uint8_t>(response->begin(), response->end())};
+}
+}  // namespace
+
+TraceWriter::TraceWriter(std::string_view path,
+                         const DeviceIdentifiers& device_identifiers)
+    : file_(std::string(path), std::ios::binary | std::ios::trunc) {
+  CHECK(file_.is_open()) << "Unable to open file: " << path;
+  std::string header(kMagic);
+  AppendBytes(device_identifiers.manufacturer, &header);
+  AppendBytes(device_identifiers.product_name, &header);
+  AppendBytes(device_identifiers.serial_number, &header);
+  AppendVarint(device_identifiers.vendor_id, &header);
+  AppendVarint(device_identifiers.product_id, &header);
+  file_ << header << std::flush;
+}
+
+void TraceWriter::Append(const TraceEvent& event) {
+  std::string record;
+  AppendVarint(static_cast<uint64_t>(event.type), &record);
+  AppendVarint(absl::ToInt64Microseconds(event.start), &record);
+  AppendVarint(absl::ToInt64Microseconds(event.duration), &record);
+  AppendVarint(static_cast<uint64_t>(event.status), &record);
+  AppendVarint(static_cast<uint64_t>(event.command), &record);
+  AppendVarint(event.expect_up_check ? 1 : 0, &record);
+  AppendBytes(event.request, &record);
+  AppendBytes(event.response, &record);
+  file_ << record << std::flush;
+}
+
+Trace ReadTrace(std::string_view path) {
+  std::ifstream file(std::string(path), std::ios::binary);
+  CHECK(file.is_open()) << "Unable to open file: " << path;
+  const std::string data((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  CHECK(data.compare(0, kMagic.size(), kMagic) == 0)
+      << "Not a trace file: " << path;
+
+  TraceReader reader(std::string_view(data).substr(kMagic.size()));
+  std::optional<std::string_view> manufacturer = reader.ReadBytes();
+  std::optional<std::string_view> product_name = reader.ReadBytes();
+  std::optional<std::string_view> serial_number = reader.ReadBytes();
+  std::optional<uint64_t> vendor_id = reader.ReadVarint();
+  std::optional<uint64_t> product_id = reader.ReadVarint();
+  CHECK(manufacturer && product_name && serial_number && vendor_id &&
+        product_id)
+      << "Truncated trace header: " << path;
+
+  Trace trace = {
+      .device_identifiers = {.manufacturer = std::string(*manufacturer),
+                             .product_name = std::string(*product_name),
+                             .serial_number = std::string(*serial_number),
+                             .vendor_id = static_cast<uint16_t>(*vendor_id),
+                             .product_id = static_cast<uint16_t>(*product_id)},
+      .events = {}};
+  while (!reader.IsAtEnd()) {
+    std::optional<TraceEvent> event = ReadEvent(&reader);
+    if (!event.has_value()) {
+      LOG(WARNING) << "Dropped a truncated record at the end of " << path;
+      break;
+    }
+    trace.events.push_back(std::move(*event));
+  }
+  return trace;
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,82 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REPLAY_TRACE_H_
+#define REPLAY_TRACE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "src/constants.h"
+#include "src/device_interface.h"
+
+namespace fido2_tests {
+
+// The calls to a DeviceInterface that a trace records.
+enum class TraceEventType : uint8_t {
+  kInit = 0x00,
+  kWink = 0x01,
+  kExchangeCbor = 0x02,
+  kExchangeRawFrames = 0x03,
+  kExchangeCborMessage = 0x04,
+};
+
+// A single call to a DeviceInterface and its outcome. Init and Wink leave
+// command, expect_up_check, request and response empty. Raw frames only set
+// the request. CBOR messages leave the command empty and keep the command byte
+// as part of the request.
+struct TraceEvent {
+  TraceEventType type;
+  // Time of the call since the trace started.
+  absl::Duration start;
+  // Time until the call returned.
+  absl::Duration duration;
+  Status status;
+  Command command;
+  bool expect_up_check;
+  std::vector<uint8_t> request;
+  std::vector<uint8_t> response;
+};
+
+// The content of a trace file.
+struct Trace {
+  DeviceIdentifiers device_identifiers;
+  std::vector<TraceEvent> events;
+};
+
+// Appends events to a binary trace file. The file starts with a magic string
+// and the device identifiers, followed by one record per event. All integers
+// are varints, so that a typical exchange only adds a few bytes of overhead.
+class TraceWriter {
+ public:
+  // Truncates the file at path and writes the header.
+  TraceWriter(std::string_view path,
+              const DeviceIdentifiers& device_identifiers);
+  // Writes the event and flushes, so that the trace survives crashes.
+  void Append(const TraceEvent& event);
+
+ private:
+  std::ofstream file_;
+};
+
+// Reads a trace written by TraceWriter. Fails on malformed files, except for
+// a truncated last record, which is dropped.
+Trace ReadTrace(std::string_view path);
+
+}  // namespace fido2_tests
+
+#endif  // REPLAY_TRACE_H_
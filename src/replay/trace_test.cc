@@ -0,0 +1,95 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/replay/trace.h"
+
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+const DeviceIdentifiers kIdentifiers = {.manufacturer = "M",
+                                        .product_name = "P",
+                                        .serial_number = "S",
+                                        .vendor_id = 0x1234,
+                                        .product_id = 0xABCD};
+
+TraceEvent ExampleEvent() {
+  return {.type = TraceEventType::kExchangeCbor,
+          .start = absl::Milliseconds(5),
+          .duration = absl::Microseconds(300),
+          .status = Status::kErrInvalidCbor,
+          .command = Command::kAuthenticatorGetInfo,
+          .expect_up_check = true,
+          .request = std::vector<uint8_t>(200, 0x01),
+          .response = {0x02, 0x03}};
+}
+
+void ExpectEqualEvents(const TraceEvent& actual, const TraceEvent& expected) {
+  EXPECT_EQ(actual.type, expected.type);
+  EXPECT_EQ(actual.start, expected.start);
+  EXPECT_EQ(actual.duration, expected.duration);
+  EXPECT_EQ(actual.status, expected.status);
+  EXPECT_EQ(actual.command, expected.command);
+  EXPECT_EQ(actual.expect_up_check, expected.expect_up_check);
+  EXPECT_EQ(actual.request, expected.request);
+  EXPECT_EQ(actual.response, expected.response);
+}
+
+TEST(Trace, TestRoundTrip) {
+  const std::string path =
+      (std::filesystem::path(::testing::TempDir()) / "round_trip.trace")
+          .string();
+  {
+    TraceWriter writer(path, kIdentifiers);
+    writer.Append({.type = TraceEventType::kInit,
+                   .start = absl::ZeroDuration(),
+                   .duration = absl::Milliseconds(1),
+                   .status = Status::kErrNone,
+                   .command = {},
+                   .expect_up_check = false,
+                   .request = {},
+                   .response = {}});
+    writer.Append(ExampleEvent());
+  }
+  Trace trace = ReadTrace(path);
+  EXPECT_EQ(trace.device_identifiers.product_name, "P");
+  EXPECT_EQ(trace.device_identifiers.vendor_id, 0x1234);
+  EXPECT_EQ(trace.device_identifiers.product_id, 0xABCD);
+  ASSERT_EQ(trace.events.size(), 2);
+  EXPECT_EQ(trace.events[0].type, TraceEventType::kInit);
+  ExpectEqualEvents(trace.events[1], ExampleEvent());
+  std::filesystem::remove(path);
+}
+
+TEST(Trace, TestDropsTruncatedRecord) {
+  const std::string path =
+      (std::filesystem::path(::testing::TempDir()) / "truncated.trace")
+          .string();
+  {
+    TraceWriter writer(path, kIdentifiers);
+    writer.Append(ExampleEvent());
+    writer.Append(ExampleEvent());
+  }
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 10);
+  Trace trace = ReadTrace(path);
+  ASSERT_EQ(trace.events.size(), 1);
+  ExpectEqualEvents(trace.events[0], ExampleEvent());
+  std::filesystem::remove(path);
+}
+
+}  // namespace
+}  // namespace fido2_tests
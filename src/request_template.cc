@@ -0,0 +1,134 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/request_template.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+namespace fido2_tests {
+namespace {
+
+// Returns the size of the initial byte and the argument of a data item, as
+// written by the canonical encoder.
+size_t HeaderSize(uint64_t argument) {
+  if (argument < 24) {
+    return 1;
+  }
+  if (argument <= 0xFF) {
+    return 2;
+  }
+  if (argument <= 0xFFFF) {
+    return 3;
+  }
+  if (argument <= 0xFFFFFFFF) {
+    return 5;
+  }
+  return 9;
+}
+
+size_t EncodedSize(const cbor::Value& value) {
+  absl::optional<size_t> size = cbor::Writer::EncodedSize(value);
+  CHECK(size.has_value()) << "encoding went wrong - TEST SUITE BUG";
+  return *size;
+}
+
+}  // namespace
+
+RequestTemplate::RequestTemplate(cbor::Value request)
+    : request_(std::move(request)) {
+  CHECK(request_.is_map()) << "request is not a map - TEST SUITE BUG";
+  absl::optional<std::vector<uint8_t>> encoded_request =
+      cbor::Writer::Write(request_);
+  CHECK(encoded_request.has_value()) << "encoding went wrong - TEST SUITE BUG";
+  encoded_request_ = std::move(encoded_request.value());
+
+  // The writer encodes entries in map order, so one pass finds all offsets.
+  cbor::Value::MapValue& map = request_.GetMutableMap();
+  size_t offset = HeaderSize(map.size());
+  for (auto& [key, value] : map) {
+    offset += EncodedSize(key);
+    if (!key.is_integer()) {
+      offset += EncodedSize(value);
+    } else if (value.is_map()) {
+      offset += RecordInnerFields(key.GetInteger(), &value.GetMutableMap(),
+                                  offset);
+    } else {
+      offset += RecordField(key.GetInteger(), "", &value, offset);
+    }
+  }
+  CHECK_EQ(offset, encoded_request_.size())
+      << "field offsets went wrong - TEST SUITE BUG";
+}
+
+void RequestTemplate::Patch(int map_key,
+                            const cbor::Value::BinaryValue& value) {
+  PatchField(map_key, "", value);
+}
+
+void RequestTemplate::Patch(int map_key, const std::string& inner_key,
+                            const cbor::Value::BinaryValue& value) {
+  CHECK(!inner_key.empty()) << "empty inner key - TEST SUITE BUG";
+  PatchField(map_key, inner_key, value);
+}
+
+const cbor::Value& RequestTemplate::GetRequest() const { return request_; }
+
+const std::vector<uint8_t>& RequestTemplate::GetEncoded() const {
+  return encoded_request_;
+}
+
+size_t RequestTemplate::RecordField(int map_key, const std::string& inner_key,
+                                    cbor::Value* value, size_t offset) {
+  if (!value->is_bytestring()) {
+    return EncodedSize(*value);
+  }
+  const size_t length = value->GetBytestring().size();
+  fields_[{map_key, inner_key}] = {.value = &value->GetMutableBytestring(),
+                                   .offset = offset + HeaderSize(length)};
+  return HeaderSize(length) + length;
+}
+
+size_t RequestTemplate::RecordInnerFields(int map_key,
+                                          cbor::Value::MapValue* map,
+                                          size_t offset) {
+  const size_t start = offset;
+  offset += HeaderSize(map->size());
+  for (auto& [key, value] : *map) {
+    offset += EncodedSize(key);
+    if (key.is_string() && !key.GetString().empty()) {
+      offset += RecordField(map_key, key.GetString(), &value, offset);
+    } else {
+      offset += EncodedSize(value);
+    }
+  }
+  return offset - start;
+}
+
+void RequestTemplate::PatchField(int map_key, const std::string& inner_key,
+                                 const cbor::Value::BinaryValue& value) {
+  auto field_iter = fields_.find(std::make_pair(map_key, inner_key));
+  CHECK(field_iter != fields_.end())
+      << "patched path is not a byte string - TEST SUITE BUG";
+  Field& field = field_iter->second;
+  CHECK_EQ(value.size(), field.value->size())
+      << "patch changes the field length - TEST SUITE BUG";
+  std::copy(value.begin(), value.end(),
+            encoded_request_.begin() + field.offset);
+  std::copy(value.begin(), value.end(), field.value->begin());
+}
+
+}  // namespace fido2_tests
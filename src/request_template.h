@@ -0,0 +1,87 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REQUEST_TEMPLATE_H_
+#define REQUEST_TEMPLATE_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "third_party/chromium_components_cbor/values.h"
+
+namespace fido2_tests {
+
+// Encodes a request once, so that it can be sent repeatedly with only a few
+// byte strings changing, like clientDataHash, pinUvAuthParam or the user ID.
+// Patching overwrites the bytes in the encoded buffer in place, so it requires
+// the new byte string to have the same length as the old one. The byte offsets
+// of all byte strings are recorded in one pass when the template is built. The
+// request value is patched in place too, so that responses are validated
+// against the request that was actually sent, e.g. signatures over the patched
+// clientDataHash.
+//
+// Example:
+//   MakeCredentialCborBuilder builder;
+//   builder.AddDefaultsForRequiredFields(rp_id);
+//   RequestTemplate request_template(builder.GetCbor());
+//   request_template.Patch(
+//       static_cast<int>(MakeCredentialParameters::kUser), "id", user_id);
+class RequestTemplate {
+ public:
+  // Encodes the request, which must be a map.
+  explicit RequestTemplate(cbor::Value request);
+  // Overwrites the byte string at the given key of the request map. Fails if
+  // the key does not exist, is not a byte string or has a different length.
+  void Patch(int map_key, const cbor::Value::BinaryValue& value);
+  // As above, but for a byte string in an inner map at the given string key,
+  // like the "id" of the user entity.
+  void Patch(int map_key, const std::string& inner_key,
+             const cbor::Value::BinaryValue& value);
+  // Returns the request, including all patches.
+  const cbor::Value& GetRequest() const;
+  // Returns the encoded request, including all patches.
+  const std::vector<uint8_t>& GetEncoded() const;
+
+ private:
+  // A byte string in the request value and where its content is encoded.
+  struct Field {
+    cbor::Value::BinaryValue* value;
+    size_t offset;
+  };
+
+  // Records the value at the path if it is a byte string, given the offset of
+  // its encoding. Returns the encoded size of the value.
+  size_t RecordField(int map_key, const std::string& inner_key,
+                     cbor::Value* value, size_t offset);
+  // Records the byte strings at string keys of an inner map, given the offset
+  // of its encoding. Returns the encoded size of the map.
+  size_t RecordInnerFields(int map_key, cbor::Value::MapValue* map,
+                           size_t offset);
+  // Overwrites the field at the path. An empty inner key refers to the outer
+  // map's value.
+  void PatchField(int map_key, const std::string& inner_key,
+                  const cbor::Value::BinaryValue& value);
+
+  cbor::Value request_;
+  std::vector<uint8_t> encoded_request_;
+  // Maps the path of each byte string to its field. Pointers stay valid,
+  // because patches never change the structure of the request.
+  absl::flat_hash_map<std::pair<int, std::string>, Field> fields_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // REQUEST_TEMPLATE_H_
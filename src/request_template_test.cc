@@ -0,0 +1,102 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/request_template.h"
+
+#include "gtest/gtest.h"
+#include "src/cbor_builders.h"
+#include "src/constants.h"
+#include "third_party/chromium_components_cbor/values.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+namespace fido2_tests {
+namespace {
+
+std::vector<uint8_t> Encode(const cbor::Value& value) {
+  return cbor::Writer::Write(value).value();
+}
+
+TEST(RequestTemplate, TestUnpatched) {
+  MakeCredentialCborBuilder builder;
+  builder.AddDefaultsForRequiredFields("example.com");
+  RequestTemplate request_template(builder.GetCbor());
+  EXPECT_EQ(request_template.GetEncoded(), Encode(builder.GetCbor()));
+}
+
+TEST(RequestTemplate, TestPatchOuterMap) {
+  MakeCredentialCborBuilder builder;
+  builder.AddDefaultsForRequiredFields("example.com");
+  RequestTemplate request_template(builder.GetCbor());
+
+  cbor::Value::BinaryValue client_data_hash(32, 0xAB);
+  request_template.Patch(
+      static_cast<int>(MakeCredentialParameters::kClientDataHash),
+      client_data_hash);
+  builder.SetMapEntry(MakeCredentialParameters::kClientDataHash,
+                      cbor::Value(client_data_hash));
+  EXPECT_EQ(request_template.GetEncoded(), Encode(builder.GetCbor()));
+}
+
+TEST(RequestTemplate, TestPatchInnerMap) {
+  MakeCredentialCborBuilder builder;
+  builder.AddDefaultsForRequiredFields("example.com");
+  builder.SetPublicKeyCredentialUserEntity(cbor::Value::BinaryValue(32, 0x00),
+                                           "Patched Pat");
+  RequestTemplate request_template(builder.GetCbor());
+
+  for (uint8_t i = 1; i < 4; ++i) {
+    cbor::Value::BinaryValue user_id(32, i);
+    request_template.Patch(static_cast<int>(MakeCredentialParameters::kUser),
+                           "id", user_id);
+    builder.SetPublicKeyCredentialUserEntity(user_id, "Patched Pat");
+    EXPECT_EQ(request_template.GetEncoded(), Encode(builder.GetCbor()));
+  }
+}
+
+TEST(RequestTemplate, TestPatchUpdatesRequest) {
+  GetAssertionCborBuilder builder;
+  builder.AddDefaultsForRequiredFields("example.com");
+  builder.SetPinUvAuthParam(cbor::Value::BinaryValue(16, 0x00));
+  RequestTemplate request_template(builder.GetCbor());
+
+  cbor::Value::BinaryValue client_data_hash(32, 0xAB);
+  request_template.Patch(
+      static_cast<int>(GetAssertionParameters::kClientDataHash),
+      client_data_hash);
+  request_template.Patch(
+      static_cast<int>(GetAssertionParameters::kPinUvAuthParam),
+      cbor::Value::BinaryValue(16, 0xFF));
+  builder.SetMapEntry(GetAssertionParameters::kClientDataHash,
+                      cbor::Value(client_data_hash));
+  builder.SetPinUvAuthParam(cbor::Value::BinaryValue(16, 0xFF));
+  EXPECT_EQ(Encode(request_template.GetRequest()), Encode(builder.GetCbor()));
+  EXPECT_EQ(request_template.GetEncoded(), Encode(builder.GetCbor()));
+}
+
+TEST(RequestTemplate, TestPatchInnerMapUpdatesRequest) {
+  MakeCredentialCborBuilder builder;
+  builder.AddDefaultsForRequiredFields("example.com");
+  builder.SetPublicKeyCredentialUserEntity(cbor::Value::BinaryValue(32, 0x00),
+                                           "Patched Pat");
+  RequestTemplate request_template(builder.GetCbor());
+
+  cbor::Value::BinaryValue user_id(32, 0x01);
+  request_template.Patch(static_cast<int>(MakeCredentialParameters::kUser),
+                         "id", user_id);
+  builder.SetPublicKeyCredentialUserEntity(user_id, "Patched Pat");
+  EXPECT_EQ(Encode(request_template.GetRequest()), Encode(builder.GetCbor()));
+}
+
+}  // namespace
+}  // namespace fido2_tests
@@ -0,0 +1,110 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/results_stream.h"
+
+#include <string>
+
+#include "glog/logging.h"
+
+namespace fido2_tests {
+namespace {
+struct StreamContent {
+  nlohmann::json metadata = nlohmann::json::object();
+  std::vector<nlohmann::json> tests;
+};
+
+StreamContent ReadStream(const std::filesystem::path& path) {
+  std::ifstream stream_file(path);
+  CHECK(stream_file.is_open()) << "Unable to open file: " << path;
+
+  StreamContent content;
+  std::vector<std::string> pending_observations;
+  std::string line;
+  while (std::getline(stream_file, line)) {
+    nlohmann::json record =
+        nlohmann::json::parse(line, /*cb=*/nullptr, /*allow_exceptions=*/false);
+    if (record.is_discarded() || !record.is_object()) {
+      continue;
+    }
+    const std::string type = record.value("type", "");
+    if (type == "observation") {
+      pending_observations.push_back(record.value("observation", ""));
+    } else if (type == "test") {
+      nlohmann::json test = std::move(record["test"]);
+      if (!test.contains("observations")) {
+        test["observations"] = std::move(pending_observations);
+      }
+      pending_observations = {};
+      content.tests.push_back(std::move(test));
+    } else if (type == "metadata") {
+      content.metadata = std::move(record["metadata"]);
+    }
+  }
+  return content;
+}
+}  // namespace
+
+nlohmann::json SummarizeResults(nlohmann::json metadata,
+                                const std::vector<nlohmann::json>& tests) {
+  int failed_test_count = 0;
+  for (const nlohmann::json& test : tests) {
+    if (test.value("result", "") != "pass") {
+      failed_test_count += 1;
+    }
+  }
+  int test_count = tests.size();
+  metadata["passed_test_count"] = test_count - failed_test_count;
+  metadata["total_test_count"] = test_count;
+  for (const nlohmann::json& test : tests) {
+    metadata["tests"].push_back(test);
+  }
+  return metadata;
+}
+
+ResultsStream::ResultsStream(const std::filesystem::path& path)
+    : path_(path), file_(path, std::ios::trunc) {
+  CHECK(file_.is_open()) << "Unable to open file: " << path;
+}
+
+void ResultsStream::AppendObservation(std::string_view observation) {
+  AppendRecord({{"type", "observation"}, {"observation", observation}});
+}
+
+void ResultsStream::AppendTest(nlohmann::json test) {
+  AppendRecord({{"type", "test"}, {"test", std::move(test)}});
+}
+
+void ResultsStream::AppendMetadata(nlohmann::json metadata) {
+  AppendRecord({{"type", "metadata"}, {"metadata", std::move(metadata)}});
+}
+
+const std::filesystem::path& ResultsStream::GetPath() const { return path_; }
+
+std::vector<nlohmann::json> ResultsStream::ReadTests(
+    const std::filesystem::path& path) {
+  return ReadStream(path).tests;
+}
+
+nlohmann::json ResultsStream::Compact(const std::filesystem::path& path) {
+  StreamContent content = ReadStream(path);
+  return SummarizeResults(std::move(content.metadata), content.tests);
+}
+
+void ResultsStream::AppendRecord(const nlohmann::json& record) {
+  // Flushing after every record keeps the file usable if the tool crashes.
+  file_ << record.dump() << std::endl;
+}
+
+}  // namespace fido2_tests
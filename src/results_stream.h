@@ -0,0 +1,75 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RESULTS_STREAM_H_
+#define RESULTS_STREAM_H_
+
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace fido2_tests {
+
+// Adds the test counts and the test list to the metadata, resulting in the
+// format of the results file.
+nlohmann::json SummarizeResults(nlohmann::json metadata,
+                                const std::vector<nlohmann::json>& tests);
+
+// Writes results to an append-only JSON Lines file while tests are running.
+// Each line is one record, and is flushed immediately, so that a crash of the
+// tool only loses the record being written. There are three record types:
+//   {"type": "observation", "observation": "..."}
+//   {"type": "test", "test": {...}}
+//   {"type": "metadata", "metadata": {...}}
+// Observations belong to the next test record, and are written as soon as they
+// are made, so they survive a crash. Tests are written like in the results
+// file. If a test record contains its own observations, e.g. aggregated with
+// counts, those replace the streamed ones. The last metadata record describes
+// the device and run. Compact turns a stream into the format of the results
+// file.
+class ResultsStream {
+ public:
+  // Creates the file, or truncates it if it already exists.
+  explicit ResultsStream(const std::filesystem::path& path);
+  // Appends an observation for the next test.
+  void AppendObservation(std::string_view observation);
+  // Appends a test, which owns all observations since the previous test,
+  // unless it lists its own.
+  void AppendTest(nlohmann::json test);
+  // Appends metadata, replacing all previous metadata records.
+  void AppendMetadata(nlohmann::json metadata);
+  // Returns the path of the written file.
+  const std::filesystem::path& GetPath() const;
+  // Reads all complete tests from a stream file, with their observations.
+  // Observations after the last test are ignored. Lines that fail to parse,
+  // like a partially written last line, are skipped.
+  static std::vector<nlohmann::json> ReadTests(
+      const std::filesystem::path& path);
+  // Reads a stream file and returns it in the format of the results file,
+  // using the last metadata record.
+  static nlohmann::json Compact(const std::filesystem::path& path);
+
+ private:
+  void AppendRecord(const nlohmann::json& record);
+
+  std::filesystem::path path_;
+  std::ofstream file_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // RESULTS_STREAM_H_
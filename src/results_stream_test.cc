@@ -0,0 +1,106 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/results_stream.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+std::filesystem::path TestFilePath(std::string_view file_name) {
+  return std::filesystem::temp_directory_path() / file_name;
+}
+
+TEST(ResultsStream, TestSummarizeResults) {
+  nlohmann::json metadata = {{"commit", "c0"}};
+  std::vector<nlohmann::json> tests = {{{"id", "A"}, {"result", "pass"}},
+                                       {{"id", "B"}, {"result", "fail"}}};
+  nlohmann::json expected_output = {
+      {"commit", "c0"},
+      {"passed_test_count", 1},
+      {"total_test_count", 2},
+      {"tests", tests},
+  };
+  EXPECT_EQ(SummarizeResults(metadata, tests), expected_output);
+}
+
+TEST(ResultsStream, TestCompact) {
+  std::filesystem::path path = TestFilePath("results_stream_compact.jsonl");
+  {
+    ResultsStream stream(path);
+    stream.AppendMetadata({{"commit", "old"}});
+    stream.AppendObservation("FIRST");
+    stream.AppendObservation("SECOND");
+    stream.AppendTest({{"id", "A"}, {"result", "fail"}});
+    stream.AppendTest({{"id", "B"}, {"result", "pass"}});
+    stream.AppendObservation("DANGLING");
+    stream.AppendMetadata({{"commit", "new"}});
+  }
+  nlohmann::json expected_output = {
+      {"commit", "new"},
+      {"passed_test_count", 1},
+      {"total_test_count", 2},
+      {"tests", nlohmann::json::array({
+                    {
+                        {"id", "A"},
+                        {"result", "fail"},
+                        {"observations", {"FIRST", "SECOND"}},
+                    },
+                    {
+                        {"id", "B"},
+                        {"result", "pass"},
+                        {"observations", nlohmann::json::array()},
+                    },
+                })},
+  };
+  EXPECT_EQ(ResultsStream::Compact(path), expected_output);
+  std::filesystem::remove(path);
+}
+
+TEST(ResultsStream, TestTruncatedLastLine) {
+  std::filesystem::path path = TestFilePath("results_stream_truncated.jsonl");
+  {
+    ResultsStream stream(path);
+    stream.AppendTest({{"id", "A"}, {"result", "pass"}});
+  }
+  {
+    std::ofstream file(path, std::ios::app);
+    file << "{\"type\": \"test\", \"te";
+  }
+  std::vector<nlohmann::json> tests = ResultsStream::ReadTests(path);
+  ASSERT_EQ(tests.size(), 1u);
+  EXPECT_EQ(tests[0]["id"], "A");
+  std::filesystem::remove(path);
+}
+
+TEST(ResultsStream, TestTestObservationsReplaceStreamed) {
+  std::filesystem::path path = TestFilePath("results_stream_replace.jsonl");
+  {
+    ResultsStream stream(path);
+    stream.AppendObservation("STREAMED");
+    stream.AppendObservation("STREAMED (DETAIL)");
+    stream.AppendTest({{"id", "A"}, {"observations", {"STREAMED × 2"}}});
+  }
+  std::vector<nlohmann::json> tests = ResultsStream::ReadTests(path);
+  ASSERT_EQ(tests.size(), 1u);
+  EXPECT_EQ(tests[0]["observations"], nlohmann::json({"STREAMED × 2"}));
+  std::filesystem::remove(path);
+}
+
+}  // namespace
+}  // namespace fido2_tests
@@ -0,0 +1,180 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/signature_verifier.h"
+
+#include <algorithm>
+
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "glog/logging.h"
+#include "src/crypto_utility.h"
+#include "third_party/chromium_components_cbor/reader.h"
+
+namespace fido2_tests {
+namespace {
+constexpr int kMaxDefaultThreads = 4;
+// Enough for thousands of assertions in flight, with a few hundred bytes each.
+constexpr size_t kMaxQueuedJobs = 4096;
+// Credential IDs can be long, a prefix is enough to tell them apart.
+constexpr size_t kCredentialIdPrefixSize = 8;
+
+int DefaultNumThreads() {
+  const int num_cores = std::thread::hardware_concurrency();
+  return std::clamp(num_cores, 1, kMaxDefaultThreads);
+}
+
+std::string DescribeCredential(const std::vector<uint8_t>& credential_id) {
+  const size_t prefix_size =
+      std::min(credential_id.size(), kCredentialIdPrefixSize);
+  return absl::BytesToHexString(absl::string_view(
+      reinterpret_cast<const char*>(credential_id.data()), prefix_size));
+}
+}  // namespace
+
+SignatureVerifier::SignatureVerifier()
+    : SignatureVerifier(DefaultNumThreads()) {}
+
+SignatureVerifier::SignatureVerifier(int num_threads) {
+  CHECK_GT(num_threads, 0) << "no verification threads - TEST SUITE BUG";
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(&SignatureVerifier::RunWorker, this);
+  }
+}
+
+SignatureVerifier::~SignatureVerifier() {
+  {
+    absl::MutexLock lock(&mutex_);
+    is_stopping_ = true;
+  }
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void SignatureVerifier::RegisterCredential(
+    const std::vector<uint8_t>& credential_id,
+    std::vector<uint8_t> cose_public_key) {
+  credential_keys_[credential_id] = std::move(cose_public_key);
+}
+
+void SignatureVerifier::ForgetCredentials() { credential_keys_.clear(); }
+
+void SignatureVerifier::VerifyAttestation(
+    const std::vector<uint8_t>& credential_id, int64_t alg,
+    std::optional<std::vector<uint8_t>> certificate,
+    std::vector<uint8_t> signed_data, std::vector<uint8_t> signature) {
+  Job job = {.is_certificate = certificate.has_value(),
+             .signed_data = std::move(signed_data),
+             .signature = std::move(signature)};
+  if (certificate.has_value()) {
+    job.public_key = std::move(certificate.value());
+    job.description = absl::StrCat("attestation of credential ",
+                                   DescribeCredential(credential_id));
+  } else {
+    auto key_iter = credential_keys_.find(credential_id);
+    CHECK(key_iter != credential_keys_.end())
+        << "self attestation of an unregistered credential - TEST SUITE BUG";
+    job.public_key = key_iter->second;
+    job.expected_alg = alg;
+    job.description = absl::StrCat("self attestation of credential ",
+                                   DescribeCredential(credential_id));
+  }
+  Enqueue(std::move(job));
+}
+
+void SignatureVerifier::VerifyAssertion(
+    const std::vector<uint8_t>& credential_id,
+    std::vector<uint8_t> signed_data, std::vector<uint8_t> signature) {
+  auto key_iter = credential_keys_.find(credential_id);
+  if (key_iter == credential_keys_.end()) {
+    return;
+  }
+  Enqueue({.public_key = key_iter->second,
+           .is_certificate = false,
+           .signed_data = std::move(signed_data),
+           .signature = std::move(signature),
+           .description = absl::StrCat("assertion with credential ",
+                                       DescribeCredential(credential_id))});
+}
+
+std::vector<std::string> SignatureVerifier::Join() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &SignatureVerifier::IsIdle));
+  std::vector<std::string> failures;
+  failures.swap(failures_);
+  return failures;
+}
+
+void SignatureVerifier::Enqueue(Job job) {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &SignatureVerifier::HasQueueSpace));
+  jobs_.push_back(std::move(job));
+  unfinished_jobs_ += 1;
+}
+
+void SignatureVerifier::RunWorker() {
+  while (true) {
+    Job job;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(
+          absl::Condition(this, &SignatureVerifier::HasJobOrIsStopping));
+      if (jobs_.empty()) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    bool is_valid = Verify(job);
+    absl::MutexLock lock(&mutex_);
+    if (!is_valid) {
+      failures_.push_back(std::move(job.description));
+    }
+    unfinished_jobs_ -= 1;
+  }
+}
+
+bool SignatureVerifier::IsIdle() const { return unfinished_jobs_ == 0; }
+
+bool SignatureVerifier::HasQueueSpace() const {
+  return jobs_.size() < kMaxQueuedJobs;
+}
+
+bool SignatureVerifier::HasJobOrIsStopping() const {
+  return is_stopping_ || !jobs_.empty();
+}
+
+bool SignatureVerifier::Verify(const Job& job) {
+  if (job.is_certificate) {
+    return crypto_utility::VerifyCertificateSignature(
+        job.public_key, job.signed_data, job.signature);
+  }
+  // The key was parsed when the credential was made, so it is a valid map.
+  absl::optional<cbor::Value> cose_key = cbor::Reader::Read(job.public_key);
+  CHECK(cose_key.has_value() && cose_key->is_map())
+      << "registered credential key is not a map - TEST SUITE BUG";
+  const cbor::Value::MapValue& cose_map = cose_key->GetMap();
+  if (job.expected_alg.has_value()) {
+    auto alg_iter = cose_map.find(cbor::Value(3));
+    if (alg_iter == cose_map.end() || !alg_iter->second.is_integer() ||
+        alg_iter->second.GetInteger() != job.expected_alg.value()) {
+      return false;
+    }
+  }
+  return crypto_utility::VerifyCoseSignature(cose_map, job.signed_data,
+                                             job.signature);
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,108 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIGNATURE_VERIFIER_H_
+#define SIGNATURE_VERIFIER_H_
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace fido2_tests {
+
+// Verifies attestation and assertion signatures on a pool of worker threads,
+// so that the thread talking to the device only queues them. Call Join before
+// reporting a verdict to collect the failures.
+//
+// All public functions must be called from the same thread.
+class SignatureVerifier {
+ public:
+  // Uses a few worker threads, depending on the available cores.
+  SignatureVerifier();
+  explicit SignatureVerifier(int num_threads);
+  // Waits for queued verifications, but discards their results.
+  ~SignatureVerifier();
+  SignatureVerifier(const SignatureVerifier&) = delete;
+  SignatureVerifier& operator=(const SignatureVerifier&) = delete;
+
+  // Remembers the COSE encoded public key of a new credential, so that
+  // assertions with this credential can be verified later.
+  void RegisterCredential(const std::vector<uint8_t>& credential_id,
+                          std::vector<uint8_t> cose_public_key);
+  // Forgets all registered credentials. Call it after a Reset deleted them,
+  // so that long runs don't keep every key ever made.
+  void ForgetCredentials();
+  // Queues the verification of a packed attestation statement. Without a
+  // certificate, the statement is a self attestation and uses the credential
+  // key, which must match the algorithm. The signed data is the concatenation
+  // of authenticator data and client data hash.
+  void VerifyAttestation(const std::vector<uint8_t>& credential_id,
+                         int64_t alg,
+                         std::optional<std::vector<uint8_t>> certificate,
+                         std::vector<uint8_t> signed_data,
+                         std::vector<uint8_t> signature);
+  // Queues the verification of an assertion signature with the registered key
+  // of the credential. Does nothing for unknown credentials, e.g. those created
+  // before the tool started.
+  void VerifyAssertion(const std::vector<uint8_t>& credential_id,
+                       std::vector<uint8_t> signed_data,
+                       std::vector<uint8_t> signature);
+  // Waits until all queued verifications are done. Returns a description of
+  // every signature that failed since the last call.
+  std::vector<std::string> Join();
+
+ private:
+  struct Job {
+    // Either a COSE key or a DER encoded X.509 certificate.
+    std::vector<uint8_t> public_key;
+    bool is_certificate;
+    // If set, the COSE key must use this algorithm.
+    std::optional<int64_t> expected_alg;
+    std::vector<uint8_t> signed_data;
+    std::vector<uint8_t> signature;
+    // Describes the signature in failure messages.
+    std::string description;
+  };
+
+  // Blocks while too many jobs are queued, to bound memory in long runs.
+  void Enqueue(Job job);
+  void RunWorker();
+  bool IsIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool HasQueueSpace() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool HasJobOrIsStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  static bool Verify(const Job& job);
+
+  // Only accessed from the calling thread.
+  absl::flat_hash_map<std::vector<uint8_t>, std::vector<uint8_t>>
+      credential_keys_;
+
+  absl::Mutex mutex_;
+  std::deque<Job> jobs_ ABSL_GUARDED_BY(mutex_);
+  // Counts queued jobs and jobs that workers are busy with.
+  size_t unfinished_jobs_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::vector<std::string> failures_ ABSL_GUARDED_BY(mutex_);
+  bool is_stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // SIGNATURE_VERIFIER_H_
@@ -0,0 +1,147 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/signature_verifier.h"
+
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "openssl/bn.h"
+#include "openssl/ec.h"
+#include "openssl/ecdsa.h"
+#include "openssl/nid.h"
+#include "src/constants.h"
+#include "src/crypto_utility.h"
+#include "third_party/chromium_components_cbor/values.h"
+#include "third_party/chromium_components_cbor/writer.h"
+
+namespace fido2_tests {
+namespace {
+
+using ByteVector = std::vector<uint8_t>;
+
+const ByteVector kCredentialId = {0x01, 0x02, 0x03};
+
+ByteVector BignumToCoordinate(const BIGNUM* bignum) {
+  ByteVector coordinate(32, 0);
+  BN_bn2bin(bignum, coordinate.data() + 32 - BN_num_bytes(bignum));
+  return coordinate;
+}
+
+// An ES256 credential key, with its public key in COSE format.
+class TestCredential {
+ public:
+  TestCredential() : key_(EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) {
+    CHECK(EC_KEY_generate_key(key_.get()));
+  }
+
+  ByteVector CoseKey(int alg) const {
+    bssl::UniquePtr<BIGNUM> x(BN_new());
+    bssl::UniquePtr<BIGNUM> y(BN_new());
+    CHECK(EC_POINT_get_affine_coordinates_GFp(
+        EC_KEY_get0_group(key_.get()), EC_KEY_get0_public_key(key_.get()),
+        x.get(), y.get(), nullptr));
+    cbor::Value::MapValue cose_key;
+    cose_key[cbor::Value(1)] = cbor::Value(2);
+    cose_key[cbor::Value(3)] = cbor::Value(alg);
+    cose_key[cbor::Value(-1)] = cbor::Value(1);
+    cose_key[cbor::Value(-2)] = cbor::Value(BignumToCoordinate(x.get()));
+    cose_key[cbor::Value(-3)] = cbor::Value(BignumToCoordinate(y.get()));
+    return cbor::Writer::Write(cbor::Value(std::move(cose_key))).value();
+  }
+
+  ByteVector Sign(const ByteVector& message) const {
+    ByteVector digest = crypto_utility::Sha256Hash(message);
+    ByteVector signature(ECDSA_size(key_.get()));
+    unsigned int signature_size;
+    CHECK(ECDSA_sign(0, digest.data(), digest.size(), signature.data(),
+                     &signature_size, key_.get()));
+    signature.resize(signature_size);
+    return signature;
+  }
+
+ private:
+  bssl::UniquePtr<EC_KEY> key_;
+};
+
+TEST(SignatureVerifier, TestValidSignatures) {
+  TestCredential credential;
+  SignatureVerifier verifier(2);
+  verifier.RegisterCredential(
+      kCredentialId,
+      credential.CoseKey(static_cast<int>(Algorithm::kEs256Algorithm)));
+  const ByteVector signed_data = {0x0A, 0x0B, 0x0C};
+  verifier.VerifyAttestation(
+      kCredentialId, static_cast<int>(Algorithm::kEs256Algorithm),
+      std::nullopt, signed_data, credential.Sign(signed_data));
+  for (int i = 0; i < 100; ++i) {
+    verifier.VerifyAssertion(kCredentialId, signed_data,
+                             credential.Sign(signed_data));
+  }
+  EXPECT_TRUE(verifier.Join().empty());
+}
+
+TEST(SignatureVerifier, TestInvalidSignatures) {
+  TestCredential credential;
+  // A single worker reports failures in order.
+  SignatureVerifier verifier(1);
+  verifier.RegisterCredential(
+      kCredentialId,
+      credential.CoseKey(static_cast<int>(Algorithm::kEs256Algorithm)));
+  const ByteVector signed_data = {0x0A, 0x0B, 0x0C};
+  ByteVector signature = credential.Sign(signed_data);
+  verifier.VerifyAssertion(kCredentialId, {0x0A, 0x0B}, signature);
+  verifier.VerifyAttestation(kCredentialId,
+                             static_cast<int>(Algorithm::kRs256Algorithm),
+                             std::nullopt, signed_data, signature);
+  signature.back() ^= 0x01;
+  verifier.VerifyAssertion(kCredentialId, signed_data, signature);
+  EXPECT_EQ(verifier.Join(),
+            std::vector<std::string>(
+                {"assertion with credential 010203",
+                 "self attestation of credential 010203",
+                 "assertion with credential 010203"}));
+  EXPECT_TRUE(verifier.Join().empty());
+}
+
+TEST(SignatureVerifier, TestUnknownCredential) {
+  SignatureVerifier verifier(1);
+  verifier.VerifyAssertion(kCredentialId, {0x0A}, {0x00});
+  EXPECT_TRUE(verifier.Join().empty());
+}
+
+TEST(SignatureVerifier, TestForgetCredentials) {
+  TestCredential credential;
+  SignatureVerifier verifier(1);
+  verifier.RegisterCredential(
+      kCredentialId,
+      credential.CoseKey(static_cast<int>(Algorithm::kEs256Algorithm)));
+  verifier.ForgetCredentials();
+  // The invalid signature is not checked, since the credential is unknown.
+  verifier.VerifyAssertion(kCredentialId, {0x0A}, {0x00});
+  EXPECT_TRUE(verifier.Join().empty());
+}
+
+TEST(SignatureVerifier, TestMalformedCertificate) {
+  SignatureVerifier verifier(1);
+  verifier.VerifyAttestation(kCredentialId,
+                             static_cast<int>(Algorithm::kEs256Algorithm),
+                             ByteVector({0x30, 0x00}), {0x0A}, {0x00});
+  EXPECT_EQ(verifier.Join(), std::vector<std::string>(
+                                 {"attestation of credential 010203"}));
+}
+
+}  // namespace
+}  // namespace fido2_tests
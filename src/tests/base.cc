@@ -19,11 +19,14 @@
 namespace fido2_tests {
 
 BaseTest::BaseTest(std::string test_id, std::string test_description,
-                   Preconditions preconditions, absl::flat_hash_set<Tag> tags)
+                   Preconditions preconditions, absl::flat_hash_set<Tag> tags,
+                   StateEffects state_effects, std::string source_file)
     : test_id_(std::move(test_id)),
       test_description_(std::move(test_description)),
       preconditions_(std::move(preconditions)),
-      tags_(std::move(tags)) {}
+      tags_(std::move(tags)),
+      state_effects_(std::move(state_effects)),
+      source_file_(std::move(source_file)) {}
 
 void BaseTest::Setup(CommandState* command_state) const {
   command_state->Prepare(preconditions_.has_pin);
@@ -48,6 +51,16 @@ std::string BaseTest::GetId() const { return test_id_; }
 
 std::string BaseTest::GetDescription() const { return test_description_; }
 
+const Preconditions& BaseTest::GetPreconditions() const {
+  return preconditions_;
+}
+
+const StateEffects& BaseTest::GetStateEffects() const {
+  return state_effects_;
+}
+
+const std::string& BaseTest::GetSourceFile() const { return source_file_; }
+
 bool BaseTest::HasTag(Tag tag) const { return tags_.contains(tag); }
 
 std::vector<std::string> BaseTest::ListTags() const {
@@ -27,6 +27,17 @@ struct Preconditions {
   bool has_pin;
 };
 
+// Describes how a test changes the device state beyond its preconditions. Only
+// the order of tests depends on it, tests are always prepared by Setup.
+struct StateEffects {
+  // The test leaves a PIN set, even if it did not require one.
+  bool sets_pin = false;
+  // The test calls Reset, which deletes the PIN and asks for a replug.
+  bool resets = false;
+  // Number of other replugs the test asks for, e.g. to unblock PIN retries.
+  int replugs = 0;
+};
+
 // Describes what features a test uses. Can be used to filter tests or display
 // results grouped by tag.
 enum class Tag { kClientPin, kFido2Point1, kFuzzing, kHmacSecret };
@@ -38,9 +49,12 @@ std::string TagToString(Tag tag);
 // Run tests by first calling Setup, then Execute.
 class BaseTest {
  public:
-  // A subclass is expected to pass in values describing its properties.
+  // A subclass is expected to pass in values describing its properties. The
+  // source file defaults to the file of the calling constructor.
   BaseTest(std::string test_id, std::string test_description,
-           Preconditions preconditions, absl::flat_hash_set<Tag> tags);
+           Preconditions preconditions, absl::flat_hash_set<Tag> tags,
+           StateEffects state_effects = {},
+           std::string source_file = __builtin_FILE());
   virtual ~BaseTest() = default;
   // Executes the test code. Returns std::nullopt if the test was successful, or
   // an error message if it failed. As a side effect, it can change the device
@@ -54,6 +68,12 @@ class BaseTest {
   std::string GetId() const;
   // Gets the test description.
   std::string GetDescription() const;
+  // Gets the device state required by the test.
+  const Preconditions& GetPreconditions() const;
+  // Gets the changes of the device state caused by the test.
+  const StateEffects& GetStateEffects() const;
+  // Gets the path of the file that defines the test.
+  const std::string& GetSourceFile() const;
   // Checks if the test has a specific tag.
   bool HasTag(Tag tag) const;
   // Returns a list of all tags.
@@ -69,6 +89,8 @@ class BaseTest {
   const std::string test_description_;
   const Preconditions preconditions_;
   const absl::flat_hash_set<Tag> tags_;
+  const StateEffects state_effects_;
+  const std::string source_file_;
 };
 
 // This convenience macro defines a test subclass to make headers more readable.
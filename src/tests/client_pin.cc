@@ -330,7 +330,7 @@ std::optional<std::string> GetUVRetriesMissingParameterTest::Execute(
 ClientPinRequirementsSetPinTest::ClientPinRequirementsSetPinTest()
     : BaseTest("client_pin_requirements_set_pin",
                "Tests if PIN requirement are enforced in SetPin.",
-               {.has_pin = false}, {Tag::kClientPin}) {}
+               {.has_pin = false}, {Tag::kClientPin}, {.sets_pin = true}) {}
 
 std::optional<std::string> ClientPinRequirementsSetPinTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -519,7 +519,7 @@ std::optional<std::string> ClientPinGeneralPinRetriesTest::Execute(
 ClientPinAuthBlockPinRetriesTest::ClientPinAuthBlockPinRetriesTest()
     : BaseTest("client_pin_auth_block_pin_retries",
                "Tests if PIN auth attempts are blocked correctly.",
-               {.has_pin = true}, {Tag::kClientPin}) {}
+               {.has_pin = true}, {Tag::kClientPin}, {.replugs = 1}) {}
 
 std::optional<std::string> ClientPinAuthBlockPinRetriesTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -592,7 +592,9 @@ std::optional<std::string> ClientPinAuthBlockPinRetriesTest::Execute(
 ClientPinBlockPinRetriesTest::ClientPinBlockPinRetriesTest()
     : BaseTest("client_pin_block_pin_retries",
                "Tests if PINs are blocked correctly.", {.has_pin = true},
-               {Tag::kClientPin}) {}
+               {Tag::kClientPin},
+               // Authenticators usually allow 8 retries, which need 2 replugs.
+               {.resets = true, .replugs = 2}) {}
 
 std::optional<std::string> ClientPinBlockPinRetriesTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -14,17 +14,26 @@
 
 #include "src/tests/fuzzing_corpus.h"
 
+#include <algorithm>
 #include <iostream>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
 #include "src/constants.h"
 #include "src/fuzzing/corpus_controller.h"
+#include "src/fuzzing/input_fixup.h"
+#include "src/fuzzing/input_pipeline.h"
+#include "src/tests/test_helpers.h"
 
 namespace fido2_tests {
 namespace {
 
 // Default number of retries.
 constexpr int kRetries = 3;
+// Every provisioned credential needs a touch, so only this many of the most
+// frequent RP IDs in the corpus get one.
+constexpr size_t kMaxProvisionedRpIds = 4;
 
 // Prints a line stating the file being run, rewriting the last line of output.
 void PrintRunningFile(std::string_view file_name, size_t last_file_name_len) {
@@ -33,39 +42,169 @@ void PrintRunningFile(std::string_view file_name, size_t last_file_name_len) {
   std::cout << "\rRunning file " << file_name << ". " << std::flush;
 }
 
-// Runs all files of the given type, which should be stored in a folder inside
-// the corpus under a naming convention (see src/test_input_controller.h). When
-// the monitor detects a crash, stops execution.
-std::optional<std::string> Execute(DeviceInterface* device,
-                                   DeviceTracker* device_tracker,
-                                   CommandState* command_state,
-                                   Monitor* monitor,
-                                   fuzzing_helpers::InputType input_type,
-                                   const std::string_view& base_corpus_path) {
-  CorpusController corpus_controller(input_type, base_corpus_path);
-  int passed_test_files = 0;
-  size_t last_file_name_len = 0;
-  std::cout << "\n|--- Processing corpus "
-            << InputTypeToDirectoryName(input_type) << " ---|\n\n";
-  while (corpus_controller.HasNextInput()) {
-    auto [input_data, input_name] = corpus_controller.GetNextInput();
-    PrintRunningFile(input_name, last_file_name_len);
-    SendInput(device, input_type, input_data);
+// Sends inputs to the device and checks it with the monitor afterwards.
+class InputRunner {
+ public:
+  InputRunner(DeviceInterface* device, DeviceTracker* device_tracker,
+              CommandState* command_state, Monitor* monitor)
+      : device_(device),
+        device_tracker_(device_tracker),
+        command_state_(command_state),
+        monitor_(monitor) {}
+
+  // Runs a single input. Returns an error message if it crashed the device.
+  // Otherwise, writes what the device did to the last argument.
+  std::optional<std::string> Run(fuzzing_helpers::InputType input_type,
+                                 const std::vector<uint8_t>& input_data,
+                                 const std::string& input_name,
+                                 ExecutionFeedback* feedback) {
+    PrintRunningFile(input_name, last_file_name_len_);
+    const absl::Time start = absl::Now();
+    Status status = SendInput(device_, input_type, input_data, &response_);
+    const absl::Time end = absl::Now();
+    *feedback = {.status = status,
+                 .response_shape = fuzzing_helpers::ResponseShape(response_),
+                 .execution_time = end - start};
     auto [device_crashed, observations] =
-        monitor->DeviceCrashed(command_state, kRetries);
+        monitor_->DeviceCrashed(command_state_, kRetries);
+    device_time_ += absl::Now() - start;
     for (const std::string& observation : observations) {
-      device_tracker->AddObservation(
-          absl::StrCat("In file ", input_name, " ", observation));
+      device_tracker_->AddObservation(observation,
+                                      absl::StrCat("in file ", input_name));
     }
     if (device_crashed) {
-      monitor->PrintCrashReport();
+      monitor_->PrintCrashReport();
       std::string save_path =
-          monitor->SaveCrashFile(input_type, input_data, input_name);
+          monitor_->SaveCrashFile(input_type, input_data, input_name);
       return absl::StrCat("Saved crash input to ", save_path,
-                          ". Ran a total of ", passed_test_files, " files.");
+                          ". Ran a total of ", passed_test_files_, " files.");
+    }
+    ++passed_test_files_;
+    last_file_name_len_ = input_name.size();
+    return std::nullopt;
+  }
+
+  // Returns the time spent in exchanges with the device, including the
+  // monitor's checks.
+  absl::Duration GetDeviceTime() const { return device_time_; }
+
+ private:
+  DeviceInterface* device_;
+  DeviceTracker* device_tracker_;
+  CommandState* command_state_;
+  Monitor* monitor_;
+  int passed_test_files_ = 0;
+  size_t last_file_name_len_ = 0;
+  absl::Duration device_time_ = absl::ZeroDuration();
+  std::vector<uint8_t> response_;
+};
+
+// Reads the PIN state from the command state. The monitor updates it when it
+// gets a PIN token after each input, and redoes the key agreement if needed.
+class CommandPinAuthState : public PinAuthState {
+ public:
+  explicit CommandPinAuthState(CommandState* command_state)
+      : command_state_(command_state) {}
+  const cbor::Value::MapValue& GetPlatformCoseKey() const override {
+    return command_state_->GetPlatformCoseKey();
+  }
+  cbor::Value::BinaryValue GetSharedSecret() const override {
+    return command_state_->GetSharedSecret();
+  }
+  cbor::Value::BinaryValue GetPin() const override {
+    return command_state_->GetPin();
+  }
+  cbor::Value::BinaryValue GetAuthToken() const override {
+    return command_state_->GetCurrentAuthToken();
+  }
+
+ private:
+  CommandState* command_state_;
+};
+
+// Makes credentials for the most frequent RP IDs of the GetAssertion corpus,
+// and returns a fix-up that makes inputs use them.
+std::unique_ptr<CredentialFixup> ProvisionCredentials(
+    CommandState* command_state, const std::string& corpus_path) {
+  CorpusController corpus_controller(
+      fuzzing_helpers::InputType::kCborGetAssertionParameter, corpus_path);
+  absl::flat_hash_map<std::string, int> rp_id_counts;
+  while (corpus_controller.HasNextInput()) {
+    auto [input_data, input_name] = corpus_controller.GetNextInput();
+    if (std::optional<std::string> rp_id = ExtractRpId(input_data)) {
+      rp_id_counts[*rp_id] += 1;
+    }
+  }
+  std::vector<std::pair<int, std::string>> sorted_rp_ids;
+  for (const auto& [rp_id, count] : rp_id_counts) {
+    sorted_rp_ids.push_back({-count, rp_id});
+  }
+  std::sort(sorted_rp_ids.begin(), sorted_rp_ids.end());
+  if (sorted_rp_ids.size() > kMaxProvisionedRpIds) {
+    sorted_rp_ids.resize(kMaxProvisionedRpIds);
+  }
+
+  auto credential_fixup = std::make_unique<CredentialFixup>();
+  for (const auto& [negative_count, rp_id] : sorted_rp_ids) {
+    absl::variant<cbor::Value, Status> response =
+        command_state->MakeTestCredential(rp_id, false);
+    if (absl::holds_alternative<Status>(response)) {
+      LOG(WARNING) << "Failed to make a credential for RP ID " << rp_id;
+      continue;
+    }
+    credential_fixup->AddCredential(
+        rp_id, test_helpers::ExtractCredentialId(
+                   absl::get<cbor::Value>(response)));
+  }
+  return credential_fixup;
+}
+
+// Returns a fix-up that reads the current PIN state of the command state for
+// every input. Apply it on the thread that runs the monitor.
+std::unique_ptr<PinAuthFixup> MakePinAuthFixup(CommandState* command_state) {
+  return std::make_unique<PinAuthFixup>(
+      std::make_unique<CommandPinAuthState>(command_state));
+}
+
+// Returns the fix-ups that the options ask for. Only tests that run
+// GetAssertion inputs need credentials.
+std::unique_ptr<InputFixup> MakeInputFixup(
+    CommandState* command_state,
+    const fuzzing_helpers::FuzzingOptions& options, bool needs_credentials) {
+  auto input_fixup = std::make_unique<ChainedFixup>();
+  if (options.fix_credentials && needs_credentials) {
+    input_fixup->Add(ProvisionCredentials(command_state, options.corpus_path));
+  }
+  if (options.fix_pin_auth) {
+    input_fixup->Add(MakePinAuthFixup(command_state));
+  }
+  return input_fixup;
+}
+
+// Runs all files of the given type, which should be stored in a folder inside
+// the corpus under a naming convention (see src/test_input_controller.h).
+// Inputs are rewritten by the fix-up, if there is one. When the monitor
+// detects a crash, stops execution.
+std::optional<std::string> Execute(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    CommandState* command_state, Monitor* monitor,
+    fuzzing_helpers::InputType input_type,
+    const fuzzing_helpers::FuzzingOptions& options,
+    const InputFixup* input_fixup = nullptr) {
+  CorpusController corpus_controller(input_type, options.corpus_path);
+  InputRunner input_runner(device, device_tracker, command_state, monitor);
+  std::cout << "\n|--- Processing corpus "
+            << InputTypeToDirectoryName(input_type) << " ---|\n\n";
+  while (corpus_controller.HasNextInput()) {
+    auto [input_data, input_name] = corpus_controller.GetNextInput();
+    if (input_fixup != nullptr) {
+      input_fixup->Apply(input_type, &input_data);
+    }
+    ExecutionFeedback feedback;
+    if (auto error = input_runner.Run(input_type, input_data, input_name,
+                                      &feedback)) {
+      return error;
     }
-    ++passed_test_files;
-    last_file_name_len = input_name.size();
   }
   std::cout << std::endl;
   return std::nullopt;
@@ -79,20 +218,22 @@ void Setup(CommandState* command_state, Monitor* monitor) {
 }  // namespace
 
 MakeCredentialCorpusTest::MakeCredentialCorpusTest(
-    Monitor* monitor, const std::string_view& base_corpus_path)
+    Monitor* monitor, const fuzzing_helpers::FuzzingOptions& options)
     : BaseTest("make_credential_corpus",
                "Tests the corpus of CTAP MakeCredential commands.",
-               {.has_pin = false}, {Tag::kFuzzing}),
+               {.has_pin = options.fix_pin_auth}, {Tag::kFuzzing}),
       monitor_(monitor),
-      base_corpus_path_(base_corpus_path) {}
+      options_(options) {}
 
 std::optional<std::string> MakeCredentialCorpusTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
     CommandState* command_state) const {
+  std::unique_ptr<InputFixup> input_fixup =
+      MakeInputFixup(command_state, options_, /*needs_credentials=*/false);
   return ::fido2_tests::Execute(
       device, device_tracker, command_state, monitor_,
-      fuzzing_helpers::InputType::kCborMakeCredentialParameter,
-      base_corpus_path_);
+      fuzzing_helpers::InputType::kCborMakeCredentialParameter, options_,
+      input_fixup.get());
 }
 
 void MakeCredentialCorpusTest::Setup(CommandState* command_state) const {
@@ -101,20 +242,22 @@ void MakeCredentialCorpusTest::Setup(CommandState* command_state) const {
 }
 
 GetAssertionCorpusTest::GetAssertionCorpusTest(
-    Monitor* monitor, const std::string_view& base_corpus_path)
+    Monitor* monitor, const fuzzing_helpers::FuzzingOptions& options)
     : BaseTest("get_assertion_corpus",
                "Tests the corpus of CTAP GetAssertion commands.",
-               {.has_pin = false}, {Tag::kFuzzing}),
+               {.has_pin = options.fix_pin_auth}, {Tag::kFuzzing}),
       monitor_(monitor),
-      base_corpus_path_(base_corpus_path) {}
+      options_(options) {}
 
 std::optional<std::string> GetAssertionCorpusTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
     CommandState* command_state) const {
+  std::unique_ptr<InputFixup> input_fixup =
+      MakeInputFixup(command_state, options_, /*needs_credentials=*/true);
   return ::fido2_tests::Execute(
       device, device_tracker, command_state, monitor_,
-      fuzzing_helpers::InputType::kCborGetAssertionParameter,
-      base_corpus_path_);
+      fuzzing_helpers::InputType::kCborGetAssertionParameter, options_,
+      input_fixup.get());
 }
 
 void GetAssertionCorpusTest::Setup(CommandState* command_state) const {
@@ -123,19 +266,22 @@ void GetAssertionCorpusTest::Setup(CommandState* command_state) const {
 }
 
 ClientPinCorpusTest::ClientPinCorpusTest(
-    Monitor* monitor, const std::string_view& base_corpus_path)
+    Monitor* monitor, const fuzzing_helpers::FuzzingOptions& options)
     : BaseTest("client_pin_corpus",
                "Tests the corpus of CTAP ClientPIN commands.",
-               {.has_pin = false}, {Tag::kFuzzing}),
+               {.has_pin = options.fix_pin_auth}, {Tag::kFuzzing}),
       monitor_(monitor),
-      base_corpus_path_(base_corpus_path) {}
+      options_(options) {}
 
 std::optional<std::string> ClientPinCorpusTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
     CommandState* command_state) const {
+  std::unique_ptr<InputFixup> input_fixup =
+      MakeInputFixup(command_state, options_, /*needs_credentials=*/false);
   return ::fido2_tests::Execute(
       device, device_tracker, command_state, monitor_,
-      fuzzing_helpers::InputType::kCborClientPinParameter, base_corpus_path_);
+      fuzzing_helpers::InputType::kCborClientPinParameter, options_,
+      input_fixup.get());
 }
 
 void ClientPinCorpusTest::Setup(CommandState* command_state) const {
@@ -143,5 +289,110 @@ void ClientPinCorpusTest::Setup(CommandState* command_state) const {
   ::fido2_tests::Setup(command_state, monitor_);
 }
 
+CborRawCorpusTest::CborRawCorpusTest(
+    Monitor* monitor, const fuzzing_helpers::FuzzingOptions& options)
+    : BaseTest("cbor_raw_corpus",
+               "Tests the corpus of CTAP commands with any command byte.",
+               {.has_pin = options.fix_pin_auth}, {Tag::kFuzzing}),
+      monitor_(monitor),
+      options_(options) {}
+
+std::optional<std::string> CborRawCorpusTest::Execute(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    CommandState* command_state) const {
+  std::unique_ptr<InputFixup> input_fixup =
+      MakeInputFixup(command_state, options_, /*needs_credentials=*/false);
+  return ::fido2_tests::Execute(device, device_tracker, command_state,
+                                monitor_, fuzzing_helpers::InputType::kCborRaw,
+                                options_, input_fixup.get());
+}
+
+void CborRawCorpusTest::Setup(CommandState* command_state) const {
+  BaseTest::Setup(command_state);
+  ::fido2_tests::Setup(command_state, monitor_);
+}
+
+RawDataCorpusTest::RawDataCorpusTest(
+    Monitor* monitor, const fuzzing_helpers::FuzzingOptions& options)
+    : BaseTest("raw_data_corpus", "Tests the corpus of raw CTAPHID reports.",
+               {.has_pin = options.fix_pin_auth}, {Tag::kFuzzing}),
+      monitor_(monitor),
+      options_(options) {}
+
+std::optional<std::string> RawDataCorpusTest::Execute(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    CommandState* command_state) const {
+  return ::fido2_tests::Execute(device, device_tracker, command_state,
+                                monitor_, fuzzing_helpers::InputType::kRawData,
+                                options_);
+}
+
+void RawDataCorpusTest::Setup(CommandState* command_state) const {
+  BaseTest::Setup(command_state);
+  ::fido2_tests::Setup(command_state, monitor_);
+}
+
+ScheduledCorpusTest::ScheduledCorpusTest(
+    Monitor* monitor, const fuzzing_helpers::FuzzingOptions& options)
+    : BaseTest("scheduled_corpus",
+               "Tests mutated files of all corpora, scheduled by the device "
+               "behavior they found.",
+               {.has_pin = options.fix_pin_auth}, {Tag::kFuzzing}),
+      monitor_(monitor),
+      options_(options) {}
+
+std::optional<std::string> ScheduledCorpusTest::Execute(
+    DeviceInterface* device, DeviceTracker* device_tracker,
+    CommandState* command_state) const {
+  // The pipeline prepares inputs ahead of the device, so it only gets the
+  // credential fix-up. PIN related values depend on the state right before
+  // sending, so they are fixed here.
+  std::unique_ptr<CredentialFixup> credential_fixup;
+  if (options_.fix_credentials) {
+    credential_fixup =
+        ProvisionCredentials(command_state, options_.corpus_path);
+  }
+  std::unique_ptr<PinAuthFixup> pin_auth_fixup;
+  if (options_.fix_pin_auth) {
+    pin_auth_fixup = MakePinAuthFixup(command_state);
+  }
+  InputPipeline input_pipeline(options_, credential_fixup.get());
+  if (!input_pipeline.HasInputs()) {
+    return std::nullopt;
+  }
+  InputRunner input_runner(device, device_tracker, command_state, monitor_);
+  std::cout << "\n|--- Processing scheduled inputs ---|\n\n";
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < options_.num_runs; ++i) {
+    PreparedInput input = input_pipeline.GetNextInput();
+    if (pin_auth_fixup != nullptr) {
+      pin_auth_fixup->Apply(input.input_type, &input.data);
+    }
+    ExecutionFeedback feedback;
+    if (auto error = input_runner.Run(input.input_type, input.data,
+                                      input.name, &feedback)) {
+      return error;
+    }
+    input_pipeline.RecordExecution(std::move(feedback));
+  }
+  const absl::Duration total_time = absl::Now() - start;
+  std::cout << "\n\nRates of new behavior at the end of the run:\n";
+  for (const auto& [input_type, success_rate] : input_pipeline.Join()) {
+    std::cout << InputTypeToDirectoryName(input_type) << ": " << success_rate
+              << std::endl;
+  }
+  std::cout << "Device utilization: "
+            << 100.0 * absl::FDivDuration(input_runner.GetDeviceTime(),
+                                          total_time)
+            << "%, waited " << input_pipeline.GetWaitTime()
+            << " for inputs." << std::endl;
+  return std::nullopt;
+}
+
+void ScheduledCorpusTest::Setup(CommandState* command_state) const {
+  BaseTest::Setup(command_state);
+  ::fido2_tests::Setup(command_state, monitor_);
+}
+
 }  // namespace fido2_tests
 
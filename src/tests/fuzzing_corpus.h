@@ -18,16 +18,21 @@
 #include "src/command_state.h"
 #include "src/device_interface.h"
 #include "src/device_tracker.h"
+#include "src/fuzzing/fuzzing_helpers.h"
 #include "src/monitors/monitor.h"
 #include "src/tests/base.h"
 
 namespace fido2_tests {
+// All corpus tests except the scheduled one run every file of their corpus
+// once, in the order of their sizes. The input type of the options is ignored,
+// since each test has its own. Inputs are rewritten by the fix-ups that the
+// options enable, and all tests need a PIN if PIN fix-ups are enabled.
 // TODO(#27) expand test set
 // Tests the corpus of make credential command parameters.
 class MakeCredentialCorpusTest : public BaseTest {
  public:
   MakeCredentialCorpusTest(fido2_tests::Monitor* monitor,
-                           const std::string_view& base_corpus_path);
+                           const fuzzing_helpers::FuzzingOptions& options);
   std::optional<std::string> Execute(
       DeviceInterface* device, DeviceTracker* device_tracker,
       CommandState* command_state) const override;
@@ -35,14 +40,14 @@ class MakeCredentialCorpusTest : public BaseTest {
 
  private:
   fido2_tests::Monitor* monitor_;
-  std::string_view base_corpus_path_;
+  const fuzzing_helpers::FuzzingOptions options_;
 };
 
 // Tests the corpus of get assertion command parameters.
 class GetAssertionCorpusTest : public BaseTest {
  public:
   GetAssertionCorpusTest(fido2_tests::Monitor* monitor,
-                         const std::string_view& base_corpus_path);
+                         const fuzzing_helpers::FuzzingOptions& options);
   std::optional<std::string> Execute(
       DeviceInterface* device, DeviceTracker* device_tracker,
       CommandState* command_state) const override;
@@ -50,14 +55,14 @@ class GetAssertionCorpusTest : public BaseTest {
 
  private:
   fido2_tests::Monitor* monitor_;
-  std::string_view base_corpus_path_;
+  const fuzzing_helpers::FuzzingOptions options_;
 };
 
 // Tests the corpus of client pin command parameters.
 class ClientPinCorpusTest : public BaseTest {
  public:
   ClientPinCorpusTest(fido2_tests::Monitor* monitor,
-                      const std::string_view& base_corpus_path);
+                      const fuzzing_helpers::FuzzingOptions& options);
   std::optional<std::string> Execute(
       DeviceInterface* device, DeviceTracker* device_tracker,
       CommandState* command_state) const override;
@@ -65,7 +70,54 @@ class ClientPinCorpusTest : public BaseTest {
 
  private:
   fido2_tests::Monitor* monitor_;
-  std::string_view base_corpus_path_;
+  const fuzzing_helpers::FuzzingOptions options_;
+};
+
+// Tests the corpus of CBOR messages, whose first byte is the command byte.
+class CborRawCorpusTest : public BaseTest {
+ public:
+  CborRawCorpusTest(fido2_tests::Monitor* monitor,
+                    const fuzzing_helpers::FuzzingOptions& options);
+  std::optional<std::string> Execute(
+      DeviceInterface* device, DeviceTracker* device_tracker,
+      CommandState* command_state) const override;
+  void Setup(CommandState* command_state) const override;
+
+ private:
+  fido2_tests::Monitor* monitor_;
+  const fuzzing_helpers::FuzzingOptions options_;
+};
+
+// Tests the corpus of raw CTAPHID reports, sent without any framing.
+class RawDataCorpusTest : public BaseTest {
+ public:
+  RawDataCorpusTest(fido2_tests::Monitor* monitor,
+                    const fuzzing_helpers::FuzzingOptions& options);
+  std::optional<std::string> Execute(
+      DeviceInterface* device, DeviceTracker* device_tracker,
+      CommandState* command_state) const override;
+  void Setup(CommandState* command_state) const override;
+
+ private:
+  fido2_tests::Monitor* monitor_;
+  const fuzzing_helpers::FuzzingOptions options_;
+};
+
+// Runs options.num_runs mutated files from all corpora, prepared and
+// scheduled by an InputPipeline while the device handles earlier inputs.
+// Reports how much of the run the device was busy.
+class ScheduledCorpusTest : public BaseTest {
+ public:
+  ScheduledCorpusTest(fido2_tests::Monitor* monitor,
+                      const fuzzing_helpers::FuzzingOptions& options);
+  std::optional<std::string> Execute(
+      DeviceInterface* device, DeviceTracker* device_tracker,
+      CommandState* command_state) const override;
+  void Setup(CommandState* command_state) const override;
+
+ private:
+  fido2_tests::Monitor* monitor_;
+  const fuzzing_helpers::FuzzingOptions options_;
 };
 
 }  // namespace fido2_tests
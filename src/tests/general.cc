@@ -70,7 +70,7 @@ std::optional<std::string> GetInfoTest::Execute(
 PersistentCredentialsTest::PersistentCredentialsTest()
     : BaseTest("persistent_credentials",
                "Tests whether credentials persist after replug.",
-               {.has_pin = false}, {}) {}
+               {.has_pin = false}, {}, {.replugs = 1}) {}
 
 std::optional<std::string> PersistentCredentialsTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -110,7 +110,7 @@ std::optional<std::string> PersistentCredentialsTest::Execute(
 PersistentPinRetriesTest::PersistentPinRetriesTest()
     : BaseTest("persistent_pin_retries",
                "Tests whether PIN retries persist after replug.",
-               {.has_pin = true}, {Tag::kClientPin}) {}
+               {.has_pin = true}, {Tag::kClientPin}, {.replugs = 1}) {}
 
 std::optional<std::string> PersistentPinRetriesTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -140,7 +140,7 @@ std::optional<std::string> PersistentPinRetriesTest::Execute(
 RegeneratesPinAuthTest::RegeneratesPinAuthTest()
     : BaseTest("regenerates_pin_auth",
                "Tests whether the PIN auth token regenerates after replug.",
-               {.has_pin = true}, {Tag::kClientPin}) {}
+               {.has_pin = true}, {Tag::kClientPin}, {.replugs = 1}) {}
 
 std::optional<std::string> RegeneratesPinAuthTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -554,7 +554,7 @@ GetAssertionPinAuthMissingParameterTest::
     : BaseTest(
           "get_assertion_pin_auth_missing_parameter",
           "Tests if client PIN fails with missing parameters in GetAssertion.",
-          {.has_pin = true}, {Tag::kClientPin}) {}
+          {.has_pin = true}, {Tag::kClientPin}, {.resets = true}) {}
 
 std::optional<std::string> GetAssertionPinAuthMissingParameterTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
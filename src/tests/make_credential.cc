@@ -22,6 +22,7 @@
 #include "src/cbor_builders.h"
 #include "src/constants.h"
 #include "src/fido2_commands.h"
+#include "src/request_template.h"
 #include "src/tests/test_helpers.h"
 #include "third_party/chromium_components_cbor/values.h"
 #include "third_party/chromium_components_cbor/writer.h"
@@ -682,7 +683,7 @@ std::optional<std::string> MakeCredentialDuplicateTest::Execute(
 MakeCredentialFullStoreTest::MakeCredentialFullStoreTest()
     : BaseTest("make_credential_full_store",
                "Tests if storing lots of credentials is handled gracefully.",
-               {.has_pin = false}, {}) {}
+               {.has_pin = false}, {}, {.resets = true}) {}
 
 std::optional<std::string> MakeCredentialFullStoreTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -691,14 +692,19 @@ std::optional<std::string> MakeCredentialFullStoreTest::Execute(
   MakeCredentialCborBuilder resident_key_builder;
   resident_key_builder.AddDefaultsForRequiredFields(RpId());
   resident_key_builder.SetResidentKeyOptions(true);
+  resident_key_builder.SetPublicKeyCredentialUserEntity(
+      cbor::Value::BinaryValue(32, 0), "Greedy Greg");
+  RequestTemplate resident_key_template(resident_key_builder.GetCbor());
   Status returned_status = Status::kErrNone;
   int counter = 0;
   while (returned_status == Status::kErrNone && counter != kNumCredentials) {
     counter += 1;
-    resident_key_builder.SetPublicKeyCredentialUserEntity(
-        cbor::Value::BinaryValue(32, counter), "Greedy Greg");
-    returned_status = fido2_commands::MakeCredentialNegativeTest(
-        device, resident_key_builder.GetCbor(), true);
+    resident_key_template.Patch(
+        static_cast<int>(MakeCredentialParameters::kUser), "id",
+        cbor::Value::BinaryValue(32, counter));
+    returned_status = fido2_commands::GenericNegativeTest(
+        device, resident_key_template,
+        Command::kAuthenticatorMakeCredential, true);
   }
   if (returned_status != Status::kErrNone) {
     if (returned_status != Status::kErrKeyStoreFull) {
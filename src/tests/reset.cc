@@ -31,7 +31,7 @@ namespace fido2_tests {
 DeleteCredentialsTest::DeleteCredentialsTest()
     : BaseTest("delete_credential",
                "Tests if Reset actually deletes credentials.",
-               {.has_pin = false}, {}) {}
+               {.has_pin = false}, {}, {.resets = true}) {}
 
 std::optional<std::string> DeleteCredentialsTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
@@ -80,7 +80,8 @@ std::optional<std::string> DeleteCredentialsTest::Execute(
 
 DeletePinTest::DeletePinTest()
     : BaseTest("delete_pin", "Tests if Reset actually deletes the PIN.",
-               {.has_pin = true}, {Tag::kClientPin}) {}
+               {.has_pin = true}, {Tag::kClientPin},
+               {.sets_pin = true, .resets = true}) {}
 
 std::optional<std::string> DeletePinTest::Execute(
     DeviceInterface* device, DeviceTracker* device_tracker,
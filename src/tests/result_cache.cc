@@ -0,0 +1,156 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/tests/result_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <sstream>
+
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "glog/logging.h"
+#include "src/crypto_utility.h"
+
+extern const char build_scm_revision[];
+
+namespace fido2_tests {
+namespace {
+
+// Code that all tests depend on. Changing it invalidates all cached results.
+constexpr std::array<std::string_view, 8> kHarnessFiles = {
+    "src/cbor_builders.cc",   "src/command_state.cc",
+    "src/crypto_utility.cc",  "src/device_tracker.cc",
+    "src/fido2_commands.cc",  "src/parameter_check.cc",
+    "src/tests/base.cc",      "src/tests/test_helpers.cc",
+};
+
+std::string HexSha256(std::string_view data) {
+  const std::vector<uint8_t> hash = crypto_utility::Sha256Hash(data);
+  return absl::BytesToHexString(
+      std::string_view(reinterpret_cast<const char*>(hash.data()),
+                       hash.size()));
+}
+
+}  // namespace
+
+nlohmann::json FirmwareIdentity::ToJson() const {
+  return {
+      {"aaguid", aaguid},
+      {"firmware_version", firmware_version},
+      {"vendor_id", vendor_id},
+      {"product_id", product_id},
+      {"product_name", product_name},
+  };
+}
+
+ResultCache::ResultCache(std::string_view cache_dir, FirmwareIdentity firmware,
+                         std::string_view source_dir)
+    : cache_path_(std::filesystem::path(cache_dir) /
+                  absl::StrCat(firmware.aaguid, "_", firmware.firmware_version,
+                               ".json")),
+      firmware_(std::move(firmware)),
+      source_dir_(source_dir),
+      entries_(nlohmann::json::object()) {
+  std::ifstream cache_file(cache_path_);
+  if (!cache_file.is_open()) {
+    return;
+  }
+  nlohmann::json cache =
+      nlohmann::json::parse(cache_file, nullptr, /*allow_exceptions=*/false);
+  // Another device with the same AAGUID and firmware version is not trusted.
+  if (cache.is_object() && cache.value("firmware", nlohmann::json()) ==
+                               firmware_.ToJson()) {
+    entries_ = cache.value("tests", nlohmann::json::object());
+  }
+}
+
+std::optional<nlohmann::json> ResultCache::Lookup(const BaseTest& test) {
+  auto entry = entries_.find(test.GetId());
+  if (entry == entries_.end() ||
+      entry->value("fingerprint", "") != Fingerprint(test)) {
+    return std::nullopt;
+  }
+  const nlohmann::json& result = (*entry)["result"];
+  if (result.value("result", "") != "pass") {
+    return std::nullopt;
+  }
+  return result;
+}
+
+void ResultCache::Store(const BaseTest& test,
+                        const nlohmann::json& test_result) {
+  if (test_result.value("result", "") != "pass") {
+    entries_.erase(test.GetId());
+    return;
+  }
+  entries_[test.GetId()] = {
+      {"fingerprint", Fingerprint(test)},
+      {"result", test_result},
+  };
+}
+
+void ResultCache::Save() const {
+  std::filesystem::create_directories(cache_path_.parent_path());
+  std::ofstream cache_file(cache_path_);
+  CHECK(cache_file.is_open()) << "Unable to open file: " << cache_path_;
+  nlohmann::json cache = {
+      {"firmware", firmware_.ToJson()},
+      {"tests", entries_},
+  };
+  cache_file << std::setw(2) << cache << std::endl;
+}
+
+std::string ResultCache::Fingerprint(const BaseTest& test) {
+  std::vector<std::string> tags = test.ListTags();
+  std::sort(tags.begin(), tags.end());
+  const StateEffects& effects = test.GetStateEffects();
+  nlohmann::json config = {
+      {"id", test.GetId()},
+      {"description", test.GetDescription()},
+      {"has_pin", test.GetPreconditions().has_pin},
+      {"sets_pin", effects.sets_pin},
+      {"resets", effects.resets},
+      {"replugs", effects.replugs},
+      {"tags", tags},
+      {"source", HashSourceFile(test.GetSourceFile())},
+  };
+  std::vector<std::string> harness_hashes;
+  for (std::string_view file_name : kHarnessFiles) {
+    harness_hashes.push_back(HashSourceFile(std::string(file_name)));
+  }
+  config["harness"] = harness_hashes;
+  return HexSha256(config.dump());
+}
+
+std::string ResultCache::HashSourceFile(const std::string& file_name) {
+  if (auto iter = file_hashes_.find(file_name); iter != file_hashes_.end()) {
+    return iter->second;
+  }
+  std::string file_hash;
+  std::ifstream source_file(std::filesystem::path(source_dir_) / file_name);
+  if (source_file.is_open()) {
+    std::stringstream content;
+    content << source_file.rdbuf();
+    file_hash = HexSha256(content.str());
+  } else {
+    // Without sources, every new build invalidates the cache.
+    file_hash = absl::StrCat("commit:", build_scm_revision);
+  }
+  file_hashes_[file_name] = file_hash;
+  return file_hash;
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,78 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TESTS_RESULT_CACHE_H_
+#define TESTS_RESULT_CACHE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "absl/container/flat_hash_map.h"
+#include "nlohmann/json.hpp"
+#include "src/tests/base.h"
+
+namespace fido2_tests {
+
+// Identifies a firmware build. The serial number is not part of it, so that
+// all units with the same firmware share their results.
+struct FirmwareIdentity {
+  nlohmann::json ToJson() const;
+
+  std::string aaguid;
+  int64_t firmware_version;
+  uint16_t vendor_id;
+  uint16_t product_id;
+  std::string product_name;
+};
+
+// Remembers passed tests per firmware across runs. A cached result is only
+// valid while the test's fingerprint is unchanged. The fingerprint covers the
+// test's configuration, its source file and the shared test harness, so
+// editing a test invalidates all tests in the same file. Failed tests are
+// never cached.
+class ResultCache {
+ public:
+  // Reads the cache for this firmware from cache_dir, if it exists. Source
+  // files are read relative to source_dir. If they are missing, the commit of
+  // the binary replaces their hashes.
+  ResultCache(std::string_view cache_dir, FirmwareIdentity firmware,
+              std::string_view source_dir);
+
+  // Returns the result of an earlier run, if the test passed with the same
+  // fingerprint.
+  std::optional<nlohmann::json> Lookup(const BaseTest& test);
+  // Updates the cache with a new result in the format of the results file.
+  void Store(const BaseTest& test, const nlohmann::json& test_result);
+  // Writes the cache back to its file.
+  void Save() const;
+
+ private:
+  std::string Fingerprint(const BaseTest& test);
+  // Hashes a file relative to source_dir_. Results are memoized.
+  std::string HashSourceFile(const std::string& file_name);
+
+  const std::filesystem::path cache_path_;
+  const FirmwareIdentity firmware_;
+  const std::string source_dir_;
+  absl::flat_hash_map<std::string, std::string> file_hashes_;
+  // Maps test IDs to objects with a fingerprint and a result.
+  nlohmann::json entries_;
+};
+
+}  // namespace fido2_tests
+
+#endif  // TESTS_RESULT_CACHE_H_
@@ -0,0 +1,120 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/tests/result_cache.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+class FakeTest : public BaseTest {
+ public:
+  FakeTest(std::string test_id, std::string test_description)
+      : BaseTest(std::move(test_id), std::move(test_description),
+                 {.has_pin = false}, {}, {}, "fake_test.cc") {}
+  std::optional<std::string> Execute(
+      DeviceInterface* device, DeviceTracker* device_tracker,
+      CommandState* command_state) const override {
+    return std::nullopt;
+  }
+};
+
+const FirmwareIdentity kFirmware = {.aaguid = "0123",
+                                    .firmware_version = 7,
+                                    .vendor_id = 1,
+                                    .product_id = 2,
+                                    .product_name = "P"};
+
+nlohmann::json Result(std::string_view result) {
+  return {{"id", "TEST"}, {"result", result}};
+}
+
+void WriteFile(const std::filesystem::path& path, std::string_view content) {
+  std::ofstream file(path);
+  file << content;
+}
+
+class ResultCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = std::filesystem::path(::testing::TempDir()) / "result_cache_test";
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_);
+    WriteFile(dir_ / "fake_test.cc", "version 1");
+  }
+
+  std::string CacheDir() const { return (dir_ / "cache").string(); }
+  std::string SourceDir() const { return dir_.string(); }
+
+  std::filesystem::path dir_;
+};
+
+TEST_F(ResultCacheTest, TestReusesPasses) {
+  FakeTest test("TEST", "DESCRIPTION");
+  ResultCache cache(CacheDir(), kFirmware, SourceDir());
+  EXPECT_EQ(cache.Lookup(test), std::nullopt);
+  cache.Store(test, Result("pass"));
+  EXPECT_EQ(cache.Lookup(test), Result("pass"));
+  cache.Save();
+
+  ResultCache loaded_cache(CacheDir(), kFirmware, SourceDir());
+  EXPECT_EQ(loaded_cache.Lookup(test), Result("pass"));
+}
+
+TEST_F(ResultCacheTest, TestForgetsFailures) {
+  FakeTest test("TEST", "DESCRIPTION");
+  ResultCache cache(CacheDir(), kFirmware, SourceDir());
+  cache.Store(test, Result("pass"));
+  cache.Store(test, Result("fail"));
+  EXPECT_EQ(cache.Lookup(test), std::nullopt);
+}
+
+TEST_F(ResultCacheTest, TestInvalidatesChangedTests) {
+  FakeTest test("TEST", "DESCRIPTION");
+  ResultCache cache(CacheDir(), kFirmware, SourceDir());
+  cache.Store(test, Result("pass"));
+  cache.Save();
+
+  FakeTest changed_test("TEST", "NEW DESCRIPTION");
+  ResultCache loaded_cache(CacheDir(), kFirmware, SourceDir());
+  EXPECT_EQ(loaded_cache.Lookup(changed_test), std::nullopt);
+
+  WriteFile(dir_ / "fake_test.cc", "version 2");
+  ResultCache edited_cache(CacheDir(), kFirmware, SourceDir());
+  EXPECT_EQ(edited_cache.Lookup(test), std::nullopt);
+}
+
+TEST_F(ResultCacheTest, TestSeparatesFirmware) {
+  FakeTest test("TEST", "DESCRIPTION");
+  ResultCache cache(CacheDir(), kFirmware, SourceDir());
+  cache.Store(test, Result("pass"));
+  cache.Save();
+
+  FirmwareIdentity new_firmware = kFirmware;
+  new_firmware.firmware_version = 8;
+  ResultCache new_firmware_cache(CacheDir(), new_firmware, SourceDir());
+  EXPECT_EQ(new_firmware_cache.Lookup(test), std::nullopt);
+
+  FirmwareIdentity other_product = kFirmware;
+  other_product.product_id = 3;
+  ResultCache other_product_cache(CacheDir(), other_product, SourceDir());
+  EXPECT_EQ(other_product_cache.Lookup(test), std::nullopt);
+}
+
+}  // namespace
+}  // namespace fido2_tests
@@ -16,6 +16,7 @@
 
 #include <cstdint>
 #include <iostream>
+#include <map>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/variant.h"
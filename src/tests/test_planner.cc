@@ -0,0 +1,101 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/tests/test_planner.h"
+
+#include <array>
+#include <list>
+
+namespace fido2_tests {
+namespace {
+
+// Tests are grouped by whether they need a PIN and whether they leave one.
+enum class Transition {
+  kNoPinToNoPin,
+  kNoPinToPin,
+  kPinToNoPin,
+  kPinToPin,
+};
+
+bool HasPinAfter(const BaseTest& test) {
+  const StateEffects& effects = test.GetStateEffects();
+  if (effects.sets_pin) {
+    return true;
+  }
+  return !effects.resets && test.GetPreconditions().has_pin;
+}
+
+Transition GetTransition(const BaseTest& test) {
+  if (test.GetPreconditions().has_pin) {
+    return HasPinAfter(test) ? Transition::kPinToPin : Transition::kPinToNoPin;
+  }
+  return HasPinAfter(test) ? Transition::kNoPinToPin
+                           : Transition::kNoPinToNoPin;
+}
+
+// Without a PIN, all tests are cheap to prepare. Tests that set a PIN run
+// before tests that remove it again, so that the removal comes for free.
+constexpr std::array<Transition, 4> kPriorityWithoutPin = {
+    Transition::kNoPinToNoPin, Transition::kNoPinToPin,
+    Transition::kPinToNoPin, Transition::kPinToPin};
+// With a PIN, tests that keep it run first. Once only tests without a PIN are
+// left, the next one needs a Reset. Tests that leave no PIN then go first.
+constexpr std::array<Transition, 4> kPriorityWithPin = {
+    Transition::kPinToPin, Transition::kPinToNoPin, Transition::kNoPinToNoPin,
+    Transition::kNoPinToPin};
+
+}  // namespace
+
+int PredictReplugs(const std::vector<const BaseTest*>& tests, bool has_pin) {
+  int replugs = 0;
+  for (const BaseTest* test : tests) {
+    if (has_pin && !test->GetPreconditions().has_pin) {
+      replugs += 1;
+    }
+    const StateEffects& effects = test->GetStateEffects();
+    replugs += effects.replugs + (effects.resets ? 1 : 0);
+    has_pin = HasPinAfter(*test);
+  }
+  return replugs;
+}
+
+TestPlan PlanTests(const std::vector<const BaseTest*>& tests, bool has_pin) {
+  std::list<const BaseTest*> remaining(tests.begin(), tests.end());
+  TestPlan plan = {.tests = {}, .predicted_replugs = 0};
+  plan.tests.reserve(tests.size());
+  bool plan_has_pin = has_pin;
+  while (!remaining.empty()) {
+    const std::array<Transition, 4>& priority =
+        plan_has_pin ? kPriorityWithPin : kPriorityWithoutPin;
+    auto next = remaining.end();
+    for (Transition transition : priority) {
+      for (auto iter = remaining.begin(); iter != remaining.end(); ++iter) {
+        if (GetTransition(**iter) == transition) {
+          next = iter;
+          break;
+        }
+      }
+      if (next != remaining.end()) {
+        break;
+      }
+    }
+    plan.tests.push_back(*next);
+    plan_has_pin = HasPinAfter(**next);
+    remaining.erase(next);
+  }
+  plan.predicted_replugs = PredictReplugs(plan.tests, has_pin);
+  return plan;
+}
+
+}  // namespace fido2_tests
@@ -0,0 +1,43 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TESTS_TEST_PLANNER_H_
+#define TESTS_TEST_PLANNER_H_
+
+#include <vector>
+
+#include "src/tests/base.h"
+
+namespace fido2_tests {
+
+// An order to run tests in, with the number of replugs it is expected to need.
+struct TestPlan {
+  std::vector<const BaseTest*> tests;
+  int predicted_replugs;
+};
+
+// Counts the replugs for running the tests in the given order, starting with or
+// without a PIN. Preparing a test without a PIN after a PIN was set requires a
+// Reset, and therefore a replug. Setting a PIN needs no user interaction. The
+// state effects of each test add their own replugs and change the PIN state.
+int PredictReplugs(const std::vector<const BaseTest*>& tests, bool has_pin);
+
+// Reorders the tests to need fewer replugs. Every test is still prepared by its
+// Setup, so the order does not change what a test checks. Tests that need the
+// same transitions keep their relative order.
+TestPlan PlanTests(const std::vector<const BaseTest*>& tests, bool has_pin);
+
+}  // namespace fido2_tests
+
+#endif  // TESTS_TEST_PLANNER_H_
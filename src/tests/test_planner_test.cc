@@ -0,0 +1,90 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/tests/test_planner.h"
+
+#include "gtest/gtest.h"
+
+namespace fido2_tests {
+namespace {
+
+class FakeTest : public BaseTest {
+ public:
+  FakeTest(std::string test_id, bool has_pin, StateEffects state_effects = {})
+      : BaseTest(std::move(test_id), "Tests nothing.", {.has_pin = has_pin},
+                 {}, state_effects) {}
+  std::optional<std::string> Execute(
+      DeviceInterface* device, DeviceTracker* device_tracker,
+      CommandState* command_state) const override {
+    return std::nullopt;
+  }
+};
+
+std::vector<std::string> ListIds(const std::vector<const BaseTest*>& tests) {
+  std::vector<std::string> ids;
+  for (const BaseTest* test : tests) {
+    ids.push_back(test->GetId());
+  }
+  return ids;
+}
+
+TEST(TestPlanner, TestPredictReplugs) {
+  FakeTest with_pin("with_pin", true);
+  FakeTest without_pin("without_pin", false);
+  FakeTest resets("resets", false, {.resets = true, .replugs = 2});
+  EXPECT_EQ(PredictReplugs({&with_pin, &without_pin, &with_pin, &without_pin},
+                           false),
+            2);
+  EXPECT_EQ(PredictReplugs({&without_pin, &with_pin}, true), 1);
+  EXPECT_EQ(PredictReplugs({&resets}, false), 3);
+}
+
+TEST(TestPlanner, TestGroupsByPin) {
+  FakeTest pin1("pin1", true);
+  FakeTest no_pin1("no_pin1", false);
+  FakeTest pin2("pin2", true);
+  FakeTest no_pin2("no_pin2", false);
+  TestPlan plan = PlanTests({&pin1, &no_pin1, &pin2, &no_pin2}, false);
+  EXPECT_EQ(ListIds(plan.tests), std::vector<std::string>(
+                                     {"no_pin1", "no_pin2", "pin1", "pin2"}));
+  EXPECT_EQ(plan.predicted_replugs, 0);
+}
+
+TEST(TestPlanner, TestStartsWithPin) {
+  FakeTest no_pin("no_pin", false);
+  FakeTest pin("pin", true);
+  TestPlan plan = PlanTests({&no_pin, &pin}, true);
+  EXPECT_EQ(ListIds(plan.tests), std::vector<std::string>({"pin", "no_pin"}));
+  EXPECT_EQ(plan.predicted_replugs, 1);
+}
+
+TEST(TestPlanner, TestPairsPinChanges) {
+  FakeTest sets_pin("sets_pin", false, {.sets_pin = true});
+  FakeTest no_pin1("no_pin1", false);
+  FakeTest pin("pin", true);
+  FakeTest resets("resets", true, {.resets = true});
+  FakeTest no_pin2("no_pin2", false);
+  const std::vector<const BaseTest*> tests = {&sets_pin, &no_pin1, &pin,
+                                              &resets, &no_pin2};
+  EXPECT_EQ(PredictReplugs(tests, false), 2);
+  TestPlan plan = PlanTests(tests, false);
+  EXPECT_EQ(ListIds(plan.tests),
+            std::vector<std::string>(
+                {"no_pin1", "no_pin2", "sets_pin", "pin", "resets"}));
+  // Only the Reset inside the last test is left.
+  EXPECT_EQ(plan.predicted_replugs, 1);
+}
+
+}  // namespace
+}  // namespace fido2_tests
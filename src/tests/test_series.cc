@@ -14,12 +14,15 @@
 
 #include "src/tests/test_series.h"
 
+#include <iostream>
+
 #include "src/tests/client_pin.h"
 #include "src/tests/fuzzing_corpus.h"
 #include "src/tests/general.h"
 #include "src/tests/get_assertion.h"
 #include "src/tests/make_credential.h"
 #include "src/tests/reset.h"
+#include "src/tests/test_planner.h"
 
 namespace fido2_tests {
 namespace runners {
@@ -134,16 +137,25 @@ const std::vector<std::unique_ptr<BaseTest>>& GetTests() {
 }
 
 const std::vector<std::unique_ptr<BaseTest>>& GetCorpusTests(
-    fido2_tests::Monitor* monitor, const std::string_view& base_corpus_path) {
-  static const auto* const tests = [monitor, base_corpus_path] {
+    fido2_tests::Monitor* monitor,
+    const fuzzing_helpers::FuzzingOptions& options) {
+  static const auto* const tests = [monitor, &options] {
     auto* test_list = new std::vector<std::unique_ptr<BaseTest>>;
     // TODO(#27) extend tests
     test_list->push_back(
-        std::make_unique<MakeCredentialCorpusTest>(monitor, base_corpus_path));
+        std::make_unique<MakeCredentialCorpusTest>(monitor, options));
+    test_list->push_back(
+        std::make_unique<GetAssertionCorpusTest>(monitor, options));
+    test_list->push_back(
+        std::make_unique<ClientPinCorpusTest>(monitor, options));
     test_list->push_back(
-        std::make_unique<GetAssertionCorpusTest>(monitor, base_corpus_path));
+        std::make_unique<CborRawCorpusTest>(monitor, options));
     test_list->push_back(
-        std::make_unique<ClientPinCorpusTest>(monitor, base_corpus_path));
+        std::make_unique<RawDataCorpusTest>(monitor, options));
+    if (options.num_runs > 0) {
+      test_list->push_back(
+          std::make_unique<ScheduledCorpusTest>(monitor, options));
+    }
     return test_list;
   }();
   return *tests;
@@ -151,7 +163,9 @@ const std::vector<std::unique_ptr<BaseTest>>& GetCorpusTests(
 
 void RunTests(DeviceInterface* device, DeviceTracker* device_tracker,
               CommandState* command_state,
-              const std::vector<std::unique_ptr<BaseTest>>& tests) {
+              const std::vector<std::unique_ptr<BaseTest>>& tests,
+              ResultCache* result_cache) {
+  std::vector<const BaseTest*> applicable_tests;
   for (const auto& test : tests) {
     if (test->HasTag(Tag::kClientPin) &&
         !device_tracker->HasOption("clientPin")) {
@@ -167,6 +181,20 @@ void RunTests(DeviceInterface* device, DeviceTracker* device_tracker,
         !device_tracker->HasVersion("FIDO_2_1_PRE")) {
       continue;
     }
+    if (result_cache) {
+      if (std::optional<nlohmann::json> cached_result =
+              result_cache->Lookup(*test)) {
+        device_tracker->LogCachedTest(*cached_result);
+        continue;
+      }
+    }
+    applicable_tests.push_back(test.get());
+  }
+
+  const bool initial_has_pin = command_state->HasPin();
+  const TestPlan plan = PlanTests(applicable_tests, initial_has_pin);
+  const int initial_replug_count = command_state->GetReplugCount();
+  for (const BaseTest* test : plan.tests) {
     test->Setup(command_state);
     std::optional<std::string> error_message =
         test->Execute(device, device_tracker, command_state);
@@ -175,9 +203,22 @@ void RunTests(DeviceInterface* device, DeviceTracker* device_tracker,
     if (error_message.has_value() && test->HasTag(Tag::kClientPin)) {
       command_state->Reset();
     }
-    device_tracker->LogTest(test->GetId(), test->GetDescription(),
-                            error_message, test->ListTags());
+    nlohmann::json test_result =
+        device_tracker->LogTest(test->GetId(), test->GetDescription(),
+                                error_message, test->ListTags());
+    if (result_cache) {
+      result_cache->Store(*test, test_result);
+    }
+  }
+  if (result_cache) {
+    result_cache->Save();
   }
+  std::cout << "The tests needed "
+            << command_state->GetReplugCount() - initial_replug_count
+            << " replugs, " << plan.predicted_replugs
+            << " were planned. Registration order would need "
+            << PredictReplugs(applicable_tests, initial_has_pin)
+            << "." << std::endl;
 }
 
 }  // namespace runners
@@ -20,8 +20,10 @@
 #include "src/command_state.h"
 #include "src/device_interface.h"
 #include "src/device_tracker.h"
+#include "src/fuzzing/fuzzing_helpers.h"
 #include "src/monitors/monitor.h"
 #include "src/tests/base.h"
+#include "src/tests/result_cache.h"
 
 namespace fido2_tests {
 namespace runners {
@@ -31,13 +33,17 @@ const std::vector<std::unique_ptr<BaseTest>>& GetTests();
 
 // Returns a list of all corpus tests.
 const std::vector<std::unique_ptr<BaseTest>>& GetCorpusTests(
-    fido2_tests::Monitor* monitor, const std::string_view& base_corpus_path);
+    fido2_tests::Monitor* monitor,
+    const fuzzing_helpers::FuzzingOptions& options);
 
 // Runs all tests. This includes setup, and checking if they are suitable for a
-// given authenticator by comparing device information and tags.
+// given authenticator by comparing device information and tags. With a result
+// cache, tests that passed before are logged from the cache instead of running
+// them again, and the cache is updated with all new results.
 void RunTests(DeviceInterface* device, DeviceTracker* device_tracker,
               CommandState* command_state,
-              const std::vector<std::unique_ptr<BaseTest>>& tests);
+              const std::vector<std::unique_ptr<BaseTest>>& tests,
+              ResultCache* result_cache = nullptr);
 
 }  // namespace runners
 }  // namespace fido2_tests
@@ -0,0 +1,175 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMPONENTS_CBOR_FLAT_MAP_H_
+#define COMPONENTS_CBOR_FLAT_MAP_H_
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace cbor {
+
+// A map stored as a vector of pairs sorted by key, with the subset of the
+// std::map interface that CBOR values need. Upstream Chromium uses
+// base::flat_map for the same purpose.
+//
+// Lookups are binary searches over contiguous memory, which is faster than
+// following tree nodes for the small maps in CTAP. Inserting in key order, as
+// the reader and Value::Clone do, appends. Inserting elsewhere moves all
+// following elements, and invalidates iterators like a std::vector does.
+template <class Key, class Mapped, class Compare = std::less<Key>>
+class flat_map {
+ public:
+  using key_type = Key;
+  using mapped_type = Mapped;
+  using value_type = std::pair<Key, Mapped>;
+  using key_compare = Compare;
+  using size_type = typename std::vector<value_type>::size_type;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+  using reverse_iterator = typename std::vector<value_type>::reverse_iterator;
+  using const_reverse_iterator =
+      typename std::vector<value_type>::const_reverse_iterator;
+
+  iterator begin() { return body_.begin(); }
+  const_iterator begin() const { return body_.begin(); }
+  const_iterator cbegin() const { return body_.cbegin(); }
+  iterator end() { return body_.end(); }
+  const_iterator end() const { return body_.end(); }
+  const_iterator cend() const { return body_.cend(); }
+  reverse_iterator rbegin() { return body_.rbegin(); }
+  const_reverse_iterator rbegin() const { return body_.rbegin(); }
+  reverse_iterator rend() { return body_.rend(); }
+  const_reverse_iterator rend() const { return body_.rend(); }
+
+  bool empty() const { return body_.empty(); }
+  size_type size() const { return body_.size(); }
+  void reserve(size_type new_capacity) { body_.reserve(new_capacity); }
+  void clear() { body_.clear(); }
+  key_compare key_comp() const { return key_compare(); }
+
+  iterator lower_bound(const Key& key) {
+    return std::lower_bound(body_.begin(), body_.end(), key, KeyLess());
+  }
+  const_iterator lower_bound(const Key& key) const {
+    return std::lower_bound(body_.begin(), body_.end(), key, KeyLess());
+  }
+
+  iterator find(const Key& key) {
+    iterator iter = lower_bound(key);
+    return IsKeyAt(iter, key) ? iter : end();
+  }
+  const_iterator find(const Key& key) const {
+    const_iterator iter = lower_bound(key);
+    return IsKeyAt(iter, key) ? iter : end();
+  }
+
+  size_type count(const Key& key) const { return find(key) == end() ? 0 : 1; }
+
+  Mapped& at(const Key& key) {
+    iterator iter = find(key);
+    CHECK(iter != end()) << "key not found in flat_map";
+    return iter->second;
+  }
+  const Mapped& at(const Key& key) const {
+    const_iterator iter = find(key);
+    CHECK(iter != end()) << "key not found in flat_map";
+    return iter->second;
+  }
+
+  Mapped& operator[](const Key& key) {
+    iterator iter = lower_bound(key);
+    if (!IsKeyAt(iter, key)) {
+      iter = body_.emplace(iter, key, Mapped());
+    }
+    return iter->second;
+  }
+  Mapped& operator[](Key&& key) {
+    iterator iter = lower_bound(key);
+    if (!IsKeyAt(iter, key)) {
+      iter = body_.emplace(iter, std::move(key), Mapped());
+    }
+    return iter->second;
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    iterator iter = lower_bound(value.first);
+    if (IsKeyAt(iter, value.first)) {
+      return {iter, false};
+    }
+    return {body_.insert(iter, std::move(value)), true};
+  }
+
+  template <class... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return insert(value_type(std::forward<Args>(args)...));
+  }
+
+  // Inserts at the hint if that keeps the order, and searches otherwise.
+  template <class... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    value_type value(std::forward<Args>(args)...);
+    const Compare less;
+    if ((hint == cend() || less(value.first, hint->first)) &&
+        (hint == cbegin() || less(std::prev(hint)->first, value.first))) {
+      return body_.insert(hint, std::move(value));
+    }
+    return insert(std::move(value)).first;
+  }
+
+  template <class M>
+  std::pair<iterator, bool> insert_or_assign(Key&& key, M&& mapped) {
+    iterator iter = lower_bound(key);
+    if (IsKeyAt(iter, key)) {
+      iter->second = std::forward<M>(mapped);
+      return {iter, false};
+    }
+    return {body_.emplace(iter, std::move(key), std::forward<M>(mapped)),
+            true};
+  }
+
+  iterator erase(const_iterator position) { return body_.erase(position); }
+  size_type erase(const Key& key) {
+    iterator iter = find(key);
+    if (iter == end()) {
+      return 0;
+    }
+    body_.erase(iter);
+    return 1;
+  }
+
+  void swap(flat_map& other) { body_.swap(other.body_); }
+
+ private:
+  // Compares stored pairs with keys for binary search.
+  struct KeyLess {
+    bool operator()(const value_type& element, const Key& key) const {
+      return Compare()(element.first, key);
+    }
+  };
+
+  bool IsKeyAt(const_iterator iter, const Key& key) const {
+    return iter != end() && !Compare()(key, iter->first);
+  }
+
+  std::vector<value_type> body_;
+};
+
+}  // namespace cbor
+
+#endif  // COMPONENTS_CBOR_FLAT_MAP_H_
@@ -0,0 +1,71 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "third_party/chromium_components_cbor/flat_map.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace cbor {
+
+TEST(FlatMapTest, TestSortedInsertion) {
+  flat_map<int, std::string> map;
+  map[3] = "c";
+  map[1] = "a";
+  EXPECT_TRUE(map.emplace(2, "b").second);
+  EXPECT_FALSE(map.emplace(2, "x").second);
+  ASSERT_EQ(map.size(), 3u);
+  int expected_key = 1;
+  for (const auto& entry : map) {
+    EXPECT_EQ(entry.first, expected_key++);
+  }
+  EXPECT_EQ(map.at(2), "b");
+  EXPECT_EQ(map.rbegin()->first, 3);
+}
+
+TEST(FlatMapTest, TestLookupAndErase) {
+  flat_map<int, int> map;
+  for (int i = 0; i < 10; ++i) {
+    map.emplace_hint(map.end(), 2 * i, i);
+  }
+  EXPECT_EQ(map.count(4), 1u);
+  EXPECT_EQ(map.count(5), 0u);
+  EXPECT_EQ(map.find(5), map.end());
+  EXPECT_EQ(map.find(18)->second, 9);
+  EXPECT_EQ(map.erase(18), 1u);
+  EXPECT_EQ(map.erase(18), 0u);
+  EXPECT_EQ(map.size(), 9u);
+}
+
+TEST(FlatMapTest, TestWrongHint) {
+  flat_map<int, int> map;
+  map.emplace_hint(map.end(), 5, 0);
+  map.emplace_hint(map.end(), 1, 0);
+  map.emplace_hint(map.begin(), 9, 0);
+  map.emplace_hint(map.begin(), 9, 1);
+  ASSERT_EQ(map.size(), 3u);
+  EXPECT_EQ(map.begin()->first, 1);
+  EXPECT_EQ(map.rbegin()->first, 9);
+  EXPECT_EQ(map.at(9), 0);
+}
+
+TEST(FlatMapTest, TestInsertOrAssign) {
+  flat_map<std::string, int> map;
+  EXPECT_TRUE(map.insert_or_assign("key", 1).second);
+  EXPECT_FALSE(map.insert_or_assign("key", 2).second);
+  EXPECT_EQ(map.at("key"), 2);
+}
+
+}  // namespace cbor
@@ -60,12 +60,12 @@ const char kUnknownError[] = "An unknown error occured.";
 
 }  // namespace
 
-Reader::Reader(std::vector<uint8_t> data)
+Reader::Reader(absl::Span<const uint8_t> data)
     : rest_(data), error_code_(DecoderError::CBOR_NO_ERROR) {}
 Reader::~Reader() {}
 
 // static
-absl::optional<Value> Reader::Read(std::vector<uint8_t> data,
+absl::optional<Value> Reader::Read(absl::Span<const uint8_t> data,
                                    DecoderError* error_code_out,
                                    int max_nesting_level) {
   size_t num_bytes_consumed;
@@ -83,7 +83,7 @@ absl::optional<Value> Reader::Read(std::vector<uint8_t> data,
 }
 
 // static
-absl::optional<Value> Reader::Read(std::vector<uint8_t> data,
+absl::optional<Value> Reader::Read(absl::Span<const uint8_t> data,
                                    size_t* num_bytes_consumed,
                                    DecoderError* error_code_out,
                                    int max_nesting_level) {
@@ -172,7 +172,7 @@ absl::optional<uint64_t> Reader::ReadVariadicLengthInteger(
     return absl::nullopt;
   }
 
-  const absl::optional<std::vector<uint8_t>> bytes =
+  const absl::optional<absl::Span<const uint8_t>> bytes =
       ReadBytes(additional_bytes);
   if (!bytes) {
     return absl::nullopt;
@@ -239,7 +239,8 @@ absl::optional<Value> Reader::DecodeToSimpleValue(
 absl::optional<Value> Reader::ReadStringContent(
     const Reader::DataItemHeader& header) {
   uint64_t num_bytes = header.value;
-  const absl::optional<std::vector<uint8_t>> bytes = ReadBytes(num_bytes);
+  const absl::optional<absl::Span<const uint8_t>> bytes =
+      ReadBytes(num_bytes);
   if (!bytes) {
     return absl::nullopt;
   }
@@ -254,7 +255,8 @@ absl::optional<Value> Reader::ReadStringContent(
 absl::optional<Value> Reader::ReadByteStringContent(
     const Reader::DataItemHeader& header) {
   uint64_t num_bytes = header.value;
-  const absl::optional<std::vector<uint8_t>> bytes = ReadBytes(num_bytes);
+  const absl::optional<absl::Span<const uint8_t>> bytes =
+      ReadBytes(num_bytes);
   if (!bytes) {
     return absl::nullopt;
   }
@@ -312,17 +314,18 @@ absl::optional<Value> Reader::ReadMapContent(
 }
 
 absl::optional<uint8_t> Reader::ReadByte() {
-  const absl::optional<std::vector<uint8_t>> bytes = ReadBytes(1);
+  const absl::optional<absl::Span<const uint8_t>> bytes = ReadBytes(1);
   return bytes ? absl::make_optional(bytes.value()[0]) : absl::nullopt;
 }
 
-absl::optional<std::vector<uint8_t>> Reader::ReadBytes(uint64_t num_bytes) {
+absl::optional<absl::Span<const uint8_t>> Reader::ReadBytes(
+    uint64_t num_bytes) {
   if (static_cast<uint64_t>(rest_.size()) < num_bytes) {
     error_code_ = DecoderError::INCOMPLETE_CBOR_DATA;
     return absl::nullopt;
   }
-  std::vector<uint8_t> ret(rest_.begin(), rest_.begin() + num_bytes);
-  rest_ = std::vector<uint8_t>(rest_.begin() + num_bytes, rest_.end());
+  const absl::Span<const uint8_t> ret = rest_.first(num_bytes);
+  rest_.remove_prefix(num_bytes);
   return ret;
 }
 
@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "third_party/chromium_components_cbor/cbor_export.h"
 #include "third_party/chromium_components_cbor/values.h"
 
@@ -92,13 +93,13 @@ class CBOR_EXPORT Reader {
   //
   // Returns an empty Optional if not all the data was consumed, and sets
   // |error_code_out| to EXTRANEOUS_DATA in this case.
-  static absl::optional<Value> Read(std::vector<uint8_t> input_data,
+  static absl::optional<Value> Read(absl::Span<const uint8_t> input_data,
                                     DecoderError* error_code_out = nullptr,
                                     int max_nesting_level = kCBORMaxDepth);
 
   // Never fails with EXTRANEOUS_DATA, but informs the caller of how many bytes
   // were consumed through |num_bytes_consumed|.
-  static absl::optional<Value> Read(std::vector<uint8_t> input_data,
+  static absl::optional<Value> Read(absl::Span<const uint8_t> input_data,
                                     size_t* num_bytes_consumed,
                                     DecoderError* error_code_out = nullptr,
                                     int max_nesting_level = kCBORMaxDepth);
@@ -107,7 +108,7 @@ class CBOR_EXPORT Reader {
   static const char* ErrorCodeToString(DecoderError error_code);
 
  private:
-  explicit Reader(std::vector<uint8_t> data);
+  explicit Reader(absl::Span<const uint8_t> data);
 
   // Encapsulates information extracted from the header of a CBOR data item,
   // which consists of the initial byte, and a variable-length-encoded integer
@@ -137,7 +138,8 @@ class CBOR_EXPORT Reader {
   absl::optional<Value> ReadMapContent(const DataItemHeader& header,
                                        int max_nesting_level);
   absl::optional<uint8_t> ReadByte();
-  absl::optional<std::vector<uint8_t>> ReadBytes(uint64_t num_bytes);
+  // Returns a view into the input, which the reader does not own.
+  absl::optional<absl::Span<const uint8_t>> ReadBytes(uint64_t num_bytes);
   // TODO(crbug/879237): This function's only caller has to make a copy of a
   // `span<uint8_t>` to satisfy this function's interface. Maybe we can make
   // this function take a `const span<const uint8_t>` and avoid copying?
@@ -149,7 +151,7 @@ class CBOR_EXPORT Reader {
 
   size_t num_bytes_remaining() const { return rest_.size(); }
 
-  std::vector<uint8_t> rest_;
+  absl::Span<const uint8_t> rest_;
   DecoderError error_code_;
 
   Reader(const Reader&) = delete;
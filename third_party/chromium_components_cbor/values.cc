@@ -117,6 +117,7 @@ Value::Value(ArrayValue&& in_array) noexcept
     : type_(Type::ARRAY), array_value_(std::move(in_array)) {}
 
 Value::Value(const MapValue& in_map) : type_(Type::MAP), map_value_() {
+  map_value_.reserve(in_map.size());
   for (const auto& it : in_map)
     map_value_.emplace_hint(map_value_.end(), it.first.Clone(),
                             it.second.Clone());
@@ -217,6 +218,16 @@ const Value::MapValue& Value::GetMap() const {
   return map_value_;
 }
 
+Value::BinaryValue& Value::GetMutableBytestring() {
+  CHECK(is_bytestring());
+  return bytestring_value_;
+}
+
+Value::MapValue& Value::GetMutableMap() {
+  CHECK(is_map());
+  return map_value_;
+}
+
 void Value::InternalMoveConstructFrom(Value&& that) {
   type_ = that.type_;
 
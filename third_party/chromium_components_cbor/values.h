@@ -7,13 +7,13 @@
 
 #include <stdint.h>
 
-#include <map>
 #include <string>
 #include <tuple>
 #include <vector>
 
 #include "glog/logging.h"
 #include "third_party/chromium_components_cbor/cbor_export.h"
+#include "third_party/chromium_components_cbor/flat_map.h"
 
 namespace cbor {
 
@@ -80,7 +80,7 @@ class CBOR_EXPORT Value {
 
   using BinaryValue = std::vector<uint8_t>;
   using ArrayValue = std::vector<Value>;
-  using MapValue = std::map<Value, Value, Less>;
+  using MapValue = flat_map<Value, Value, Less>;
 
   enum class Type {
     UNSIGNED = 0,
@@ -165,6 +165,10 @@ class CBOR_EXPORT Value {
   const std::string& GetString() const;
   const ArrayValue& GetArray() const;
   const MapValue& GetMap() const;
+  // Mutable access, to change values in place. Map keys must not be changed,
+  // since the map relies on their order.
+  BinaryValue& GetMutableBytestring();
+  MapValue& GetMutableMap();
 
  private:
   Type type_;
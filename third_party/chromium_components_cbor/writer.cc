@@ -11,18 +11,57 @@
 
 namespace cbor {
 
+namespace {
+
+class VectorSink : public Writer::Sink {
+ public:
+  explicit VectorSink(std::vector<uint8_t>* cbor) : cbor_(cbor) {}
+  void Append(absl::Span<const uint8_t> data) override {
+    cbor_->insert(cbor_->end(), data.begin(), data.end());
+  }
+
+ private:
+  std::vector<uint8_t>* cbor_;
+};
+
+class CountingSink : public Writer::Sink {
+ public:
+  void Append(absl::Span<const uint8_t> data) override { size_ += data.size(); }
+  size_t size() const { return size_; }
+
+ private:
+  size_t size_ = 0;
+};
+
+}  // namespace
+
 Writer::~Writer() {}
 
 // static
 absl::optional<std::vector<uint8_t>> Writer::Write(const Value& node,
                                                    size_t max_nesting_level) {
   std::vector<uint8_t> cbor;
-  Writer writer(&cbor);
-  if (writer.EncodeCBOR(node, static_cast<int>(max_nesting_level))) return cbor;
+  VectorSink sink(&cbor);
+  if (WriteToSink(node, &sink, max_nesting_level)) return cbor;
+  return absl::nullopt;
+}
+
+// static
+bool Writer::WriteToSink(const Value& node, Sink* sink,
+                         size_t max_nesting_level) {
+  Writer writer(sink);
+  return writer.EncodeCBOR(node, static_cast<int>(max_nesting_level));
+}
+
+// static
+absl::optional<size_t> Writer::EncodedSize(const Value& node,
+                                           size_t max_nesting_level) {
+  CountingSink sink;
+  if (WriteToSink(node, &sink, max_nesting_level)) return sink.size();
   return absl::nullopt;
 }
 
-Writer::Writer(std::vector<uint8_t>* cbor) : encoded_cbor_(cbor) {}
+Writer::Writer(Sink* sink) : sink_(sink) {}
 
 bool Writer::EncodeCBOR(const Value& node, int max_nesting_level) {
   if (max_nesting_level < 0)
@@ -53,16 +92,17 @@ bool Writer::EncodeCBOR(const Value& node, int max_nesting_level) {
       const Value::BinaryValue& bytes = node.GetBytestring();
       StartItem(Value::Type::BYTE_STRING, static_cast<uint64_t>(bytes.size()));
       // Add the bytes.
-      encoded_cbor_->insert(encoded_cbor_->end(), bytes.begin(), bytes.end());
+      sink_->Append(bytes);
       return true;
     }
 
     case Value::Type::STRING: {
-      std::string string = node.GetString();
+      const std::string& string = node.GetString();
       StartItem(Value::Type::STRING, static_cast<uint64_t>(string.size()));
 
       // Add the characters.
-      encoded_cbor_->insert(encoded_cbor_->end(), string.begin(), string.end());
+      sink_->Append(absl::MakeConstSpan(
+          reinterpret_cast<const uint8_t*>(string.data()), string.size()));
       return true;
     }
 
@@ -111,20 +151,22 @@ bool Writer::EncodeCBOR(const Value& node, int max_nesting_level) {
 }
 
 void Writer::StartItem(Value::Type type, uint64_t size) {
-  encoded_cbor_->push_back(static_cast<uint8_t>(
-      static_cast<unsigned>(type) << constants::kMajorTypeBitShift));
-  SetUint(size);
+  // The initial byte and at most 8 bytes for the size.
+  uint8_t header[9];
+  header[0] = static_cast<uint8_t>(static_cast<unsigned>(type)
+                                   << constants::kMajorTypeBitShift);
+  sink_->Append(absl::MakeConstSpan(header, SetUint(size, header)));
 }
 
-void Writer::SetAdditionalInformation(uint8_t additional_information) {
-  DCHECK(!encoded_cbor_->empty());
+void Writer::SetAdditionalInformation(uint8_t additional_information,
+                                      uint8_t* initial_byte) {
   DCHECK_EQ(additional_information & constants::kAdditionalInformationMask,
             additional_information);
-  encoded_cbor_->back() |=
+  *initial_byte |=
       (additional_information & constants::kAdditionalInformationMask);
 }
 
-void Writer::SetUint(uint64_t value) {
+size_t Writer::SetUint(uint64_t value, uint8_t* header) {
   size_t count = GetNumUintBytes(value);
   int shift = -1;
   // Values under 24 are encoded directly in the initial byte.
@@ -132,31 +174,33 @@ void Writer::SetUint(uint64_t value) {
   // of unsigned integer, which is encoded in following bytes.
   switch (count) {
     case 0:
-      SetAdditionalInformation(static_cast<uint8_t>(value));
+      SetAdditionalInformation(static_cast<uint8_t>(value), header);
       break;
     case 1:
-      SetAdditionalInformation(constants::kAdditionalInformation1Byte);
+      SetAdditionalInformation(constants::kAdditionalInformation1Byte, header);
       shift = 0;
       break;
     case 2:
-      SetAdditionalInformation(constants::kAdditionalInformation2Bytes);
+      SetAdditionalInformation(constants::kAdditionalInformation2Bytes, header);
       shift = 1;
       break;
     case 4:
-      SetAdditionalInformation(constants::kAdditionalInformation4Bytes);
+      SetAdditionalInformation(constants::kAdditionalInformation4Bytes, header);
       shift = 3;
       break;
     case 8:
-      SetAdditionalInformation(constants::kAdditionalInformation8Bytes);
+      SetAdditionalInformation(constants::kAdditionalInformation8Bytes, header);
       shift = 7;
       break;
     default:
       DCHECK(false);
       break;
   }
+  size_t header_size = 1;
   for (; shift >= 0; shift--) {
-    encoded_cbor_->push_back(0xFF & (value >> (shift * 8)));
+    header[header_size++] = 0xFF & (value >> (shift * 8));
   }
+  return header_size;
 }
 
 size_t Writer::GetNumUintBytes(uint64_t value) {
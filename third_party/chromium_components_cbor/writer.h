@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "third_party/chromium_components_cbor/cbor_export.h"
 #include "third_party/chromium_components_cbor/values.h"
 
@@ -57,6 +58,13 @@ class CBOR_EXPORT Writer {
   // Default that should be sufficiently large for most use cases.
   static constexpr size_t kDefaultMaxNestingDepth = 16;
 
+  // Receives the encoding in order, split into pieces of arbitrary size.
+  class Sink {
+   public:
+    virtual ~Sink() = default;
+    virtual void Append(absl::Span<const uint8_t> data) = 0;
+  };
+
   ~Writer();
 
   // Returns the CBOR byte string representation of |node|, unless its nesting
@@ -68,28 +76,41 @@ class CBOR_EXPORT Writer {
   static absl::optional<std::vector<uint8_t>> Write(
       const Value& node, size_t max_nesting_level = kDefaultMaxNestingDepth);
 
+  // Same as above, but passes the encoding to |sink| while it is produced. If
+  // the nesting depth is too large, returns false after a prefix of the
+  // encoding might already have been passed to |sink|.
+  static bool WriteToSink(const Value& node, Sink* sink,
+                          size_t max_nesting_level = kDefaultMaxNestingDepth);
+
+  // Returns the length of the encoding that Write would return, without
+  // storing it.
+  static absl::optional<size_t> EncodedSize(
+      const Value& node, size_t max_nesting_level = kDefaultMaxNestingDepth);
+
  private:
-  explicit Writer(std::vector<uint8_t>* cbor);
+  explicit Writer(Sink* sink);
 
-  // Called recursively to build the CBOR bytestring. When completed,
-  // |encoded_cbor_| will contain the CBOR.
+  // Called recursively to build the CBOR bytestring. The encoding is passed
+  // to |sink_| in order.
   bool EncodeCBOR(const Value& node, int max_nesting_level);
 
   // Encodes the type and size of the data being added.
   void StartItem(Value::Type type, uint64_t size);
 
-  // Encodes the additional information for the data.
-  void SetAdditionalInformation(uint8_t additional_information);
+  // Encodes the additional information for the data into the initial byte.
+  void SetAdditionalInformation(uint8_t additional_information,
+                                uint8_t* initial_byte);
 
-  // Encodes an unsigned integer value. This is used to both write
-  // unsigned integers and to encode the lengths of other major types.
-  void SetUint(uint64_t value);
+  // Encodes an unsigned integer value behind the initial byte of |header|.
+  // This is used to both write unsigned integers and to encode the lengths of
+  // other major types. Returns the number of bytes used in |header|.
+  size_t SetUint(uint64_t value, uint8_t* header);
 
   // Get the number of bytes needed to store the unsigned integer.
   size_t GetNumUintBytes(uint64_t value);
 
-  // Holds the encoded CBOR data.
-  std::vector<uint8_t>* encoded_cbor_;
+  // Receives the encoded CBOR data.
+  Sink* sink_;
 
   Writer(const Writer&) = delete;
   Writer& operator=(const Writer&) = delete;
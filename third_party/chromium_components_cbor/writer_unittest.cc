@@ -485,4 +485,33 @@ TEST(CBORWriterTest, OverlyNestedCBOR) {
   EXPECT_FALSE(Writer::Write(Value(map), 4).has_value());
 }
 
+// The sink receives the same bytes as the returned vector, and the size
+// pre-pass agrees with both.
+TEST(CBORWriterTest, TestWriteToSink) {
+  class PieceSink : public Writer::Sink {
+   public:
+    void Append(absl::Span<const uint8_t> data) override {
+      bytes.insert(bytes.end(), data.begin(), data.end());
+      pieces += 1;
+    }
+    std::vector<uint8_t> bytes;
+    int pieces = 0;
+  };
+
+  Value::MapValue map;
+  map[Value(1)] = Value(Value::BinaryValue(300, 0x42));
+  map[Value(2)] = Value("text");
+  map[Value(-3)] = Value(Value::ArrayValue());
+  const Value value(map);
+
+  PieceSink sink;
+  ASSERT_TRUE(Writer::WriteToSink(value, &sink));
+  const absl::optional<std::vector<uint8_t>> encoded = Writer::Write(value);
+  ASSERT_TRUE(encoded.has_value());
+  EXPECT_EQ(sink.bytes, *encoded);
+  EXPECT_GT(sink.pieces, 1);
+  EXPECT_EQ(Writer::EncodedSize(value), encoded->size());
+  EXPECT_FALSE(Writer::EncodedSize(value, 0).has_value());
+}
+
 }  // namespace cbor